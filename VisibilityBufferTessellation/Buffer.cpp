@@ -76,6 +76,84 @@ namespace vbt
 		descriptorWriteSet.pBufferInfo = &descriptor;
 	}
 
+	void UniformRing::Create(const std::vector<VkDeviceSize>& sizes, uint32_t count, VkDeviceSize minOffsetAlignment, VmaAllocator& allocator)
+	{
+		// Regions and slices both start on the device's dynamic offset alignment
+		auto align = [minOffsetAlignment](VkDeviceSize value) { return minOffsetAlignment > 0 ? (value + minOffsetAlignment - 1) / minOffsetAlignment * minOffsetAlignment : value; };
+		regionOffsets.clear();
+		regionDescriptors.clear();
+		VkDeviceSize offset = 0;
+		for (VkDeviceSize size : sizes)
+		{
+			regionOffsets.push_back(offset);
+			offset = align(offset + size);
+		}
+		sliceSize = offset;
+		sliceCount = count;
+		bufferSize = sliceSize * sliceCount;
+		usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = bufferSize;
+		bufferInfo.usage = usageFlags;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Device local host visible memory is preferred so shaders read the uniforms without crossing the bus, plain host visible
+		// memory is used where there's none
+		VmaAllocationCreateInfo allocInfo = {};
+		allocInfo.usage = allocationUsage;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		allocInfo.requiredFlags = propertyFlags;
+		allocInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		VmaAllocationInfo allocationInfo = {};
+		if (vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &buffer, &bufferMemory, &allocationInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create uniform ring buffer");
+		}
+		vmaGetMemoryTypeProperties(allocator, allocationInfo.memoryType, &memoryProperties);
+
+		// Persistently mapped by the allocation, so it isn't unmapped on clean up
+		mappedRange = allocationInfo.pMappedData;
+		for (size_t i = 0; i < sizes.size(); i++)
+			regionDescriptors.push_back({ buffer, regionOffsets[i], sizes[i] });
+	}
+
+	void UniformRing::Write(uint32_t slice, uint32_t region, const void* data)
+	{
+		memcpy(static_cast<char*>(mappedRange) + slice * sliceSize + regionOffsets[region], data, (size_t)regionDescriptors[region].range);
+	}
+
+	// Only needed when the ring didn't get coherent memory
+	void UniformRing::FlushSlice(uint32_t slice, VmaAllocator& allocator)
+	{
+		if ((memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+			vmaFlushAllocation(allocator, bufferMemory, slice * sliceSize, sliceSize);
+	}
+
+	VkWriteDescriptorSet UniformRing::RegionWriteDescriptorSet(VkDescriptorSet dstSet, uint32_t binding, uint32_t region)
+	{
+		VkWriteDescriptorSet writeSet = {};
+		writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeSet.dstSet = dstSet;
+		writeSet.dstBinding = binding;
+		writeSet.dstArrayElement = 0;
+		writeSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writeSet.descriptorCount = 1;
+		writeSet.pBufferInfo = &regionDescriptors[region];
+		return writeSet;
+	}
+
+	void UniformRing::CleanUp(VmaAllocator& allocator)
+	{
+		// The allocation owns the mapping, so it's released with the buffer rather than unmapped
+		mappedRange = nullptr;
+		Buffer::CleanUp(allocator);
+	}
+
 	void Buffer::CleanUp(VmaAllocator& allocator)
 	{
 		// Free memory and destroy buffer object
@@ -1,6 +1,7 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 
+#include <vector>
 #include "vk_mem_alloc.h"
 
 namespace vbt
@@ -18,6 +19,7 @@ namespace vbt
 		void CleanUp(VmaAllocator& allocator);
 
 		VkBuffer VkHandle() { return buffer; }
+		VkDeviceSize Size() { return bufferSize; }
 		VkDescriptorBufferInfo* DescriptorInfo() { return &descriptor; }
 		VkWriteDescriptorSet WriteDescriptorSet() const { return descriptorWriteSet; }
 		void* mappedRange = nullptr;
@@ -33,6 +35,30 @@ namespace vbt
 		VkDescriptorBufferInfo descriptor; 
 		VkWriteDescriptorSet descriptorWriteSet;
 	};
+
+	// Persistently mapped uniform buffer split into one slice per frame in flight, each slice holding the same regions. Regions are
+	// bound as dynamic uniform buffers and offset to a frame's slice when their descriptor set is bound, so the host writes a slice
+	// with a memcpy once the GPU has finished with the frame that last read it.
+	class UniformRing : public Buffer
+	{
+	public:
+		void Create(const std::vector<VkDeviceSize>& sizes, uint32_t sliceCount, VkDeviceSize minOffsetAlignment, VmaAllocator& allocator);
+		void Write(uint32_t slice, uint32_t region, const void* data);
+		void FlushSlice(uint32_t slice, VmaAllocator& allocator);
+		VkWriteDescriptorSet RegionWriteDescriptorSet(VkDescriptorSet dstSet, uint32_t binding, uint32_t region);
+		void CleanUp(VmaAllocator& allocator);
+
+		uint32_t SliceOffset(uint32_t slice) const { return static_cast<uint32_t>(slice * sliceSize); }
+		uint32_t SliceCount() const { return sliceCount; }
+		bool DeviceLocal() const { return (memoryProperties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0; }
+
+	private:
+		std::vector<VkDeviceSize> regionOffsets;
+		std::vector<VkDescriptorBufferInfo> regionDescriptors; // Ranges within the first slice, the dynamic offset picks the slice
+		VkDeviceSize sliceSize = 0;
+		uint32_t sliceCount = 0;
+		VkMemoryPropertyFlags memoryProperties = 0;
+	};
 }
 
 #endif
\ No newline at end of file
@@ -7,11 +7,7 @@ namespace vbt
 		updated = false;
 		if (IsMoving())
 		{
-			glm::vec3 forward;
-			forward.x = -cos(glm::radians(rotation.x)) * sin(glm::radians(rotation.y));
-			forward.y = sin(glm::radians(rotation.x));
-			forward.z = cos(glm::radians(rotation.x)) * cos(glm::radians(rotation.y));
-			forward = glm::normalize(forward);
+			glm::vec3 forward = Forward();
 
 			float dt = frameTime < 0.001f ? 0.001f : frameTime;
 			float speed = dt * moveSpeed;
@@ -33,6 +29,16 @@ namespace vbt
 		}
 	}
 
+	// Direction the camera moves in when going forward
+	glm::vec3 Camera::Forward() const
+	{
+		glm::vec3 forward;
+		forward.x = -cos(glm::radians(rotation.x)) * sin(glm::radians(rotation.y));
+		forward.y = sin(glm::radians(rotation.x));
+		forward.z = cos(glm::radians(rotation.x)) * cos(glm::radians(rotation.y));
+		return glm::normalize(forward);
+	}
+
 	void Camera::UpdateViewMatrix()
 	{
 		glm::mat4 rotationMatrix = glm::mat4(1.0f);
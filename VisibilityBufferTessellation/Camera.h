@@ -22,6 +22,7 @@ namespace vbt
 
 		glm::vec3 Position() { return position; }
 		glm::vec3 Rotation() { return rotation; }
+		glm::vec3 Forward() const;
 
 		glm::mat4 ViewMatrix() const { return viewMatrix; }
 		glm::mat4 ProjectionMatrix() const { return projMatrix; }
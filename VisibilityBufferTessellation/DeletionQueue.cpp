@@ -0,0 +1,27 @@
+#include "DeletionQueue.h"
+
+namespace vbt
+{
+	void DeletionQueue::Push(uint64_t lastUseFrame, std::function<void()> destroy)
+	{
+		retired.push_back({ lastUseFrame, std::move(destroy) });
+	}
+
+	// Destroys everything retired while at most completedFrames frames had been submitted
+	void DeletionQueue::Flush(uint64_t completedFrames)
+	{
+		while (!retired.empty() && retired.front().lastUseFrame <= completedFrames)
+		{
+			retired.front().destroy();
+			retired.pop_front();
+		}
+	}
+
+	// Only once the device is idle
+	void DeletionQueue::FlushAll()
+	{
+		for (RetiredObject& object : retired)
+			object.destroy();
+		retired.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef DELETIONQUEUE_H
+#define DELETIONQUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace vbt
+{
+	// Objects that submitted frames may still be using, destroyed once those frames have finished instead of after waiting for the
+	// device to go idle. Each is tagged with the number of frames submitted when it was retired, so it goes as soon as that many have
+	// completed.
+	class DeletionQueue
+	{
+	public:
+		void Push(uint64_t lastUseFrame, std::function<void()> destroy);
+		void Flush(uint64_t completedFrames);
+		void FlushAll();
+		size_t Size() const { return retired.size(); }
+
+	private:
+		struct RetiredObject
+		{
+			uint64_t lastUseFrame;
+			std::function<void()> destroy;
+		};
+
+		std::deque<RetiredObject> retired; // Pushed in frame order, so the oldest are always at the front
+	};
+}
+#endif
\ No newline at end of file
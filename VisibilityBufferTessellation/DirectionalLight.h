@@ -2,7 +2,6 @@
 #define DIRECTIONALLIGHT_H
 
 #include <glm/glm.hpp>
-#include "Buffer.h"
 
 struct DirectionalLightUBO
 {
@@ -23,11 +22,8 @@ namespace vbt
 			glm::vec4 diffuse;
 		};
 
-		void Init(InitInfo info, VmaAllocator& allocator);
-		void UpdateUBO(VmaAllocator& allocator);
-		void SetupUBODescriptors(VkDescriptorSet dstSet, uint32_t binding, uint32_t count);
-		void CleanUp(VmaAllocator& allocator);
-		vbt::Buffer UBO() { return ubo; }
+		void Init(InitInfo info);
+		DirectionalLightUBO UBOData();
 		glm::vec4 Direction() { return direction; }
 		glm::vec4 Ambient() { return ambient; }
 		glm::vec4 Diffuse() { return diffuse; }
@@ -39,8 +35,6 @@ namespace vbt
 		glm::vec4 direction;
 		glm::vec4 ambient;
 		glm::vec4 diffuse;
-
-		vbt::Buffer ubo;
 	};
 }
 #endif 
\ No newline at end of file
@@ -3,12 +3,13 @@
 
 namespace vbt
 {
-	void Image::Create(uint32_t imageWidth, uint32_t imageHeight, VkFormat imageFormat, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags properties, VmaAllocator& allocator)
+	void Image::Create(uint32_t imageWidth, uint32_t imageHeight, VkFormat imageFormat, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags properties, VmaAllocator& allocator, VkSampleCountFlagBits samples, uint32_t imageMipLevels)
 	{
 		// Store details
 		format = imageFormat;
 		width = imageWidth;
 		height = imageHeight;
+		mipLevels = imageMipLevels;
 
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -16,14 +17,14 @@ namespace vbt
 		imageInfo.extent.width = SCAST_U32(width);
 		imageInfo.extent.height = SCAST_U32(height);
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = usage;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.samples = samples;
 		imageInfo.flags = 0; // Optional
 
 		// Create allocation info
@@ -46,7 +47,7 @@ namespace vbt
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -57,6 +58,11 @@ namespace vbt
 	}
 
 	void Image::CreateSampler(VkDevice device, VkSamplerAddressMode addressMode)
+	{
+		sampler = BuildSampler(device, addressMode, static_cast<float>(mipLevels - 1)); // Whole mip chain, 0 for single level images
+	}
+
+	VkSampler Image::BuildSampler(VkDevice device, VkSamplerAddressMode addressMode, float maxLod)
 	{
 		VkSamplerCreateInfo samplerInfo = {};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -74,12 +80,14 @@ namespace vbt
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		samplerInfo.mipLodBias = 0.0f;
 		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
+		samplerInfo.maxLod = maxLod;
 
-		if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		VkSampler newSampler;
+		if (vkCreateSampler(device, &samplerInfo, nullptr, &newSampler) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create texture sampler");
 		}
+		return newSampler;
 	}
 
 	void Image::SetUpDescriptorInfo(VkImageLayout layout)
@@ -108,10 +116,9 @@ namespace vbt
 		writeDescriptorSet.pImageInfo = &descriptor;
 	}
 
-	void Image::TransitionLayout(VkImageLayout srcLayout, VkImageLayout dstLayout, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool) 
+	// Records the transition into a command buffer the caller submits, so creating an image never waits on the queue
+	void Image::TransitionLayout(VkCommandBuffer commandBuffer, VkImageLayout srcLayout, VkImageLayout dstLayout) 
 	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands(device, cmdPool);
-
 		// Use an image memory barrier to perform the layout transition
 		VkImageMemoryBarrier barrier = {};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -121,7 +128,7 @@ namespace vbt
 		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		barrier.image = image;
 		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.levelCount = mipLevels; // Every level starts out in the same layout
 		barrier.subresourceRange.baseArrayLayer = 0;
 		barrier.subresourceRange.layerCount = 1;
 		// Determine aspect mask
@@ -137,7 +144,7 @@ namespace vbt
 		}
 
 		// Since barriers are primarily used for synchronisation, we must specify which processes to wait on, and which processes should wait on this
-		// We need to handle the transition from Undefined to Transfer Destination, from Transfer Destination to Shader Access and from Undefinded to Depth Attachment
+		// We need to handle the transition from Undefined to Transfer Destination, from Transfer Destination to Shader Access, from Undefinded to Depth Attachment and from Undefined to General for storage images
 		VkPipelineStageFlags sourceStage;
 		VkPipelineStageFlags destinationStage;
 
@@ -165,6 +172,14 @@ namespace vbt
 			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
 			destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 		}
+		else if (srcLayout == VK_IMAGE_LAYOUT_UNDEFINED && dstLayout == VK_IMAGE_LAYOUT_GENERAL)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		}
 		else
 		{
 			throw std::invalid_argument("Unsupported layout transition");
@@ -178,34 +193,6 @@ namespace vbt
 			0, nullptr,
 			1, &barrier
 		);
-
-		EndSingleTimeCommands(commandBuffer, device, physDevice, cmdPool);
-	}
-
-	void Image::CopyFromBuffer(VkBuffer buffer, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool)
-	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands(device, cmdPool);
-
-		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = {
-			width,
-			height,
-			1
-		};
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-		EndSingleTimeCommands(commandBuffer, device, physDevice, cmdPool);
 	}
 
 	void Image::CleanUp(VmaAllocator& allocator, VkDevice device)
@@ -213,6 +200,10 @@ namespace vbt
 		vkDestroySampler(device, sampler, nullptr);
 		vkDestroyImageView(device, imageView, nullptr);
 		vmaDestroyImage(allocator, image, imageMemory);
+		sampler = VK_NULL_HANDLE;
+		imageView = VK_NULL_HANDLE;
+		image = VK_NULL_HANDLE;
+		imageMemory = VK_NULL_HANDLE;
 	}
 
 	bool Image::HasStencilComponent(VkFormat format)
@@ -10,36 +10,41 @@ namespace vbt
 	class Image
 	{
 	public:
-		void Create(uint32_t imageWidth, uint32_t imageHeight, VkFormat imageFormat, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags properties, VmaAllocator& allocator);
+		void Create(uint32_t imageWidth, uint32_t imageHeight, VkFormat imageFormat, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags properties, VmaAllocator& allocator, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT, uint32_t imageMipLevels = 1);
 		void CreateImageView(const VkDevice device, VkImageAspectFlags aspectFlags);
 		void CreateSampler(VkDevice device, VkSamplerAddressMode addressMode);
 		void SetUpDescriptorInfo(VkImageLayout layout);
 		void SetUpDescriptorInfo(VkImageLayout layout, VkSampler sampler);
 		void SetupDescriptorWriteSet(VkDescriptorSet& dstSet, uint32_t binding, VkDescriptorType type, uint32_t count);
-		void TransitionLayout(VkImageLayout srcLayout, VkImageLayout dstLayout, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool);
-		void CopyFromBuffer(VkBuffer buffer, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool);
+		void TransitionLayout(VkCommandBuffer commandBuffer, VkImageLayout srcLayout, VkImageLayout dstLayout);
 		void CleanUp(VmaAllocator& allocator, VkDevice device);
 
 		VkImage VkHandle() { return image; }
 		VkImageView ImageView() { return imageView; }
 		VkFormat Format() { return format; }
+		uint32_t Width() { return width; }
+		uint32_t Height() { return height; }
+		uint32_t MipLevels() { return mipLevels; }
 		VkSampler Sampler() { return sampler; }
 		VkDescriptorImageInfo* DescriptorInfo() { return &descriptor; }
 		VkWriteDescriptorSet WriteDescriptorSet() const { return writeDescriptorSet; }
 
 	protected:
 		bool HasStencilComponent(VkFormat format);
+		VkSampler BuildSampler(VkDevice device, VkSamplerAddressMode addressMode, float maxLod);
 
-		VkImage image;
+		// Null until created, so images that are only created for some settings can always be cleaned up
+		VkImage image = VK_NULL_HANDLE;
 		VkImageLayout imageLayout;
-		VkImageView imageView;
+		VkImageView imageView = VK_NULL_HANDLE;
 		VkFormat format;
-		VmaAllocation imageMemory;
-		VkSampler sampler;
+		VmaAllocation imageMemory = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
 		VkDescriptorImageInfo descriptor;
 		VkWriteDescriptorSet writeDescriptorSet;
 
 		uint32_t width, height = 0;
+		uint32_t mipLevels = 1;
 	};
 }
 
@@ -85,47 +85,26 @@ namespace vbt
 		attributeBuffer.CleanUp(allocator);
 	}
 
-	void Mesh::CreateBuffers(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool)
+	// Buffers are filled by the uploader's current batch, so they can't be used until it has been waited on
+	void Mesh::CreateBuffers(VmaAllocator& allocator, UploadManager& uploader)
 	{
-		// Vertex Buffer
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-		Buffer stagingBuffer;
-		stagingBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
-
-		// Map vertex data to staging buffer memory allocation
-		stagingBuffer.MapData(vertices.data(), allocator);
+		// Vertex input and storage reads from any of the shader stages
+		VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+			VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
-		// Create vertex buffer on device local memory
+		// Vertex Buffer on device local memory
+		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 		vertexBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
-
-		// Copy data to new vertex buffer
-		CopyBuffer(stagingBuffer.VkHandle(), vertexBuffer.VkHandle(), bufferSize, device, physDevice, cmdPool);
-
-		stagingBuffer.CleanUp(allocator);
+		uploader.UploadBuffer(vertexBuffer, vertices.data(), bufferSize, readStages, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
 
 		// Index Buffer
 		bufferSize = sizeof(indices[0]) * indices.size();
-		stagingBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
-
-		stagingBuffer.MapData(indices.data(), allocator);
-
 		indexBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
-
-		CopyBuffer(stagingBuffer.VkHandle(), indexBuffer.VkHandle(), bufferSize, device, physDevice, cmdPool);
-
-		stagingBuffer.CleanUp(allocator);
+		uploader.UploadBuffer(indexBuffer, indices.data(), bufferSize, readStages, VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
 
 		// Attribute Buffer
 		bufferSize = sizeof(vertexAttributeData[0]) * vertexAttributeData.size();
-		stagingBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
-
-		stagingBuffer.MapData(vertexAttributeData.data(), allocator);
-
 		attributeBuffer.Create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
-
-		CopyBuffer(stagingBuffer.VkHandle(), attributeBuffer.VkHandle(), bufferSize, device, physDevice, cmdPool);
-
-		// Clean up staging buffer
-		stagingBuffer.CleanUp(allocator);
+		uploader.UploadBuffer(attributeBuffer, vertexAttributeData.data(), bufferSize, readStages, VK_ACCESS_SHADER_READ_BIT);
 	}
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 #define MESH_H
 
 #include "Buffer.h"
-#include "PhysicalDevice.h"
+#include "UploadManager.h"
 #include "vk_mem_alloc.h"
 #include <cstdlib>
 #include <array>
@@ -95,7 +95,7 @@ namespace vbt
 		std::vector<VertexAttributes> PackedVertexAttributes() const { return vertexAttributeData; }
 		
 	protected:
-		void CreateBuffers(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool); 
+		void CreateBuffers(VmaAllocator& allocator, UploadManager& uploader); 
 		
 		Buffer vertexBuffer;
 		Buffer indexBuffer;
@@ -32,6 +32,12 @@ namespace vbt
 		if (physicalDevice == VK_NULL_HANDLE) {
 			throw std::runtime_error("Failed to find a suitable GPU");
 		}
+
+		// Optional features are queried once a device has been chosen
+		int64Atomics = CheckInt64AtomicSupport(physicalDevice);
+		drawParameters = CheckDrawParameterSupport(physicalDevice);
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		subgroupProperties = QuerySubgroupProperties(physicalDevice);
 	}
 
 	bool PhysicalDevice::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface)
@@ -83,6 +89,131 @@ namespace vbt
 	}
 
 
+	// 64 bit buffer atomics are optional, the software rasteriser falls back to a two pass 32 bit resolve without them
+	bool PhysicalDevice::CheckInt64AtomicSupport(VkPhysicalDevice device)
+	{
+		// Extended feature queries need a 1.1 device
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device, &deviceProperties);
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_1)
+			return false;
+
+		// Check for the extension
+		uint32_t supportedExtensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionCount, nullptr);
+		std::vector<VkExtensionProperties> supportedExtensions(supportedExtensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &supportedExtensionCount, supportedExtensions.data());
+		bool extensionSupported = false;
+		for (const auto& extension : supportedExtensions)
+		{
+			if (strcmp(extension.extensionName, VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME) == 0)
+			{
+				extensionSupported = true;
+				break;
+			}
+		}
+		if (!extensionSupported)
+			return false;
+
+		// Then for the features themselves
+		VkPhysicalDeviceShaderAtomicInt64FeaturesKHR atomicInt64Features = {};
+		atomicInt64Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES_KHR;
+		VkPhysicalDeviceFeatures2 supportedFeatures = {};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &atomicInt64Features;
+		vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+		return supportedFeatures.features.shaderInt64 && atomicInt64Features.shaderBufferInt64Atomics;
+	}
+
+	// gl_DrawIDARB is optional, without it the vis buff terrain is only written in a single draw and material binning is off
+	bool PhysicalDevice::CheckDrawParameterSupport(VkPhysicalDevice device)
+	{
+		// Extended feature queries need a 1.1 device
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device, &deviceProperties);
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_1)
+			return false;
+
+		VkPhysicalDeviceShaderDrawParameterFeatures drawParametersFeatures = {};
+		drawParametersFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETER_FEATURES;
+		VkPhysicalDeviceFeatures2 supportedFeatures = {};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &drawParametersFeatures;
+		vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+		return drawParametersFeatures.shaderDrawParameters == VK_TRUE;
+	}
+
+	// Subgroup size and the operations and stages they're supported in, zeroed on devices without 1.1
+	VkPhysicalDeviceSubgroupProperties PhysicalDevice::QuerySubgroupProperties(VkPhysicalDevice device)
+	{
+		VkPhysicalDeviceSubgroupProperties properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device, &deviceProperties);
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_1)
+			return properties;
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &properties;
+		vkGetPhysicalDeviceProperties2(device, &properties2);
+		properties.pNext = nullptr;
+		return properties;
+	}
+
+	// The subgroup fetch shade passes elect and broadcast with ballot operations in the fragment stage, the per pixel passes are used without them
+	bool PhysicalDevice::SupportsSubgroupFetch() const
+	{
+		VkSubgroupFeatureFlags requiredOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+		return (subgroupProperties.supportedStages & VK_SHADER_STAGE_FRAGMENT_BIT) && (subgroupProperties.supportedOperations & requiredOperations) == requiredOperations;
+	}
+
+	// Sample counts a visibility attachment of either format can be rendered with alongside a depth attachment, then read as an input attachment
+	VkSampleCountFlags PhysicalDevice::VisibilitySampleCounts(bool uintFormat) const
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		const VkPhysicalDeviceLimits& limits = deviceProperties.limits;
+		VkSampleCountFlags inputSampleCounts = uintFormat ? limits.sampledImageIntegerSampleCounts : limits.sampledImageColorSampleCounts;
+		return limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts & inputSampleCounts;
+	}
+
+	// Nanoseconds per timestamp tick
+	float PhysicalDevice::TimestampPeriod() const
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		return deviceProperties.limits.timestampPeriod;
+	}
+
+	// Dynamic uniform buffer offsets have to be multiples of this
+	VkDeviceSize PhysicalDevice::MinUniformBufferOffsetAlignment() const
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		return deviceProperties.limits.minUniformBufferOffsetAlignment;
+	}
+
+	// Identifies the device and driver a pipeline cache was written by
+	VkPhysicalDeviceProperties PhysicalDevice::Properties() const
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		return deviceProperties;
+	}
+
+	// Meaningful low bits of timestamps written on a queue family, 0 when the family can't write them
+	uint32_t PhysicalDevice::TimestampValidBits(uint32_t queueFamily) const
+	{
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+		return queueFamily < queueFamilyCount ? queueFamilyProperties[queueFamily].timestampValidBits : 0;
+	}
+
 	QueueFamilyIndices PhysicalDevice::FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
 	{
 		QueueFamilyIndices indices;
@@ -99,20 +230,31 @@ namespace vbt
 		int i = 0;
 		for (const auto& queueFamily : queueFamilyProperties)
 		{
-			// Check for graphics support
-			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			// Graphics and presentation are taken from the first families that suit, the search carries on for a transfer family
+			if (!indices.isSuitable())
 			{
-				indices.graphicsFamily = i;
+				// Check for graphics support, compute is also needed for the tess factor feedback passes recorded alongside the graphics work
+				if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
+				{
+					indices.graphicsFamily = i;
+				}
+				// Check for presentation support 
+				VkBool32 presentSupport = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+				if (queueFamilyCount > 0 && presentSupport)
+				{
+					indices.presentationFamily = i;
+				}
 			}
-			// Check for presentation support 
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-			if (queueFamilyCount > 0 && presentSupport)
+
+			// A family that can only transfer copies alongside the graphics queue without taking time from it
+			if (!indices.transferFamily.has_value() && queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+				!(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
 			{
-				indices.presentationFamily = i;
+				indices.transferFamily = i;
 			}
 
-			if (indices.isSuitable())
+			if (indices.isSuitable() && indices.transferFamily.has_value())
 			{
 				break;
 			}
@@ -26,15 +26,32 @@ namespace vbt
 		VkPhysicalDevice VkHandle() const { return physicalDevice; }
 		DeviceQueues* Queues() { return &queues; }
 		const std::vector<const char*> Extensions() { return deviceExtensions; }
+		bool SupportsInt64Atomics() const { return int64Atomics; }
+		bool SupportsDrawParameters() const { return drawParameters; }
+		const VkPhysicalDeviceFeatures& Features() const { return features; }
+		bool SupportsSubgroupFetch() const;
+		const VkPhysicalDeviceSubgroupProperties& SubgroupProperties() const { return subgroupProperties; }
+		VkSampleCountFlags VisibilitySampleCounts(bool uintFormat) const;
+		float TimestampPeriod() const;
+		VkDeviceSize MinUniformBufferOffsetAlignment() const;
+		uint32_t TimestampValidBits(uint32_t queueFamily) const;
+		VkPhysicalDeviceProperties Properties() const;
 
 	private:
 		void SelectPhysicalDevice(VkInstance instance, VkSurfaceKHR surface);
 		bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
 		bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+		bool CheckInt64AtomicSupport(VkPhysicalDevice device);
+		bool CheckDrawParameterSupport(VkPhysicalDevice device);
+		VkPhysicalDeviceSubgroupProperties QuerySubgroupProperties(VkPhysicalDevice device);
 		SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
 
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 		DeviceQueues queues;
+		bool int64Atomics = false;
+		bool drawParameters = false;
+		VkPhysicalDeviceFeatures features = {};
+		VkPhysicalDeviceSubgroupProperties subgroupProperties = {};
 	};
 }
 
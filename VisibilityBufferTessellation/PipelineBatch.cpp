@@ -0,0 +1,215 @@
+#include "PipelineBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "VbtUtils.h"
+
+namespace vbt
+{
+	namespace
+	{
+		// Copies an optional state struct and returns the pointer the description should use in its place
+		template <typename T>
+		const T* CopyState(const T* src, T& dst)
+		{
+			if (src == nullptr)
+				return nullptr;
+			dst = *src;
+			return &dst;
+		}
+
+		template <typename T>
+		const T* CopyArray(const T* src, uint32_t count, std::vector<T>& dst)
+		{
+			if (src == nullptr)
+				return nullptr;
+			dst.assign(src, src + count);
+			return dst.data();
+		}
+	}
+
+	void PipelineBatch::Begin(VkDevice vkDevice, VkPipelineCache pipelineCache)
+	{
+		device = vkDevice;
+		cache = pipelineCache;
+	}
+
+	VkShaderModule PipelineBatch::ShaderModule(const std::string& path)
+	{
+		auto loaded = shaderModules.find(path);
+		if (loaded != shaderModules.end())
+			return loaded->second;
+
+		std::vector<char> code = ReadFile(path);
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shader module");
+		}
+
+		shaderModules[path] = shaderModule;
+		return shaderModule;
+	}
+
+	void PipelineBatch::AddGraphics(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline, const std::string& name)
+	{
+		graphicsPipelines.emplace_back();
+		GraphicsPipelineDesc& desc = graphicsPipelines.back();
+		desc.pipeline = pipeline;
+		desc.name = name;
+
+		// Shader stages, resized up front so the specialisation pointers stay valid
+		desc.stageDescs.resize(info.stageCount);
+		desc.stages.resize(info.stageCount);
+		for (uint32_t i = 0; i < info.stageCount; i++)
+		{
+			CopyStage(info.pStages[i], desc.stageDescs[i]);
+			desc.stages[i] = desc.stageDescs[i].stage;
+		}
+
+		// Fixed-function state
+		desc.info = info;
+		desc.info.pStages = desc.stages.data();
+		if (CopyState(info.pVertexInputState, desc.vertexInput) != nullptr)
+		{
+			desc.vertexInput.pVertexBindingDescriptions = CopyArray(info.pVertexInputState->pVertexBindingDescriptions, info.pVertexInputState->vertexBindingDescriptionCount, desc.vertexBindings);
+			desc.vertexInput.pVertexAttributeDescriptions = CopyArray(info.pVertexInputState->pVertexAttributeDescriptions, info.pVertexInputState->vertexAttributeDescriptionCount, desc.vertexAttributes);
+			desc.info.pVertexInputState = &desc.vertexInput;
+		}
+		desc.info.pInputAssemblyState = CopyState(info.pInputAssemblyState, desc.inputAssembly);
+		desc.info.pTessellationState = CopyState(info.pTessellationState, desc.tessellation);
+		if (CopyState(info.pViewportState, desc.viewport) != nullptr)
+		{
+			desc.viewport.pViewports = CopyArray(info.pViewportState->pViewports, info.pViewportState->viewportCount, desc.viewports);
+			desc.viewport.pScissors = CopyArray(info.pViewportState->pScissors, info.pViewportState->scissorCount, desc.scissors);
+			desc.info.pViewportState = &desc.viewport;
+		}
+		desc.info.pRasterizationState = CopyState(info.pRasterizationState, desc.rasterization);
+		if (CopyState(info.pMultisampleState, desc.multisample) != nullptr)
+		{
+			uint32_t sampleMaskWords = (static_cast<uint32_t>(info.pMultisampleState->rasterizationSamples) + 31) / 32;
+			desc.multisample.pSampleMask = CopyArray(info.pMultisampleState->pSampleMask, sampleMaskWords, desc.sampleMask);
+			desc.info.pMultisampleState = &desc.multisample;
+		}
+		desc.info.pDepthStencilState = CopyState(info.pDepthStencilState, desc.depthStencil);
+		if (CopyState(info.pColorBlendState, desc.colourBlend) != nullptr)
+		{
+			desc.colourBlend.pAttachments = CopyArray(info.pColorBlendState->pAttachments, info.pColorBlendState->attachmentCount, desc.blendAttachments);
+			desc.info.pColorBlendState = &desc.colourBlend;
+		}
+		if (CopyState(info.pDynamicState, desc.dynamic) != nullptr)
+		{
+			desc.dynamic.pDynamicStates = CopyArray(info.pDynamicState->pDynamicStates, info.pDynamicState->dynamicStateCount, desc.dynamicStates);
+			desc.info.pDynamicState = &desc.dynamic;
+		}
+	}
+
+	void PipelineBatch::AddCompute(const VkComputePipelineCreateInfo& info, VkPipeline* pipeline, const std::string& name)
+	{
+		computePipelines.emplace_back();
+		ComputePipelineDesc& desc = computePipelines.back();
+		desc.pipeline = pipeline;
+		desc.name = name;
+		CopyStage(info.stage, desc.stageDesc);
+		desc.info = info;
+		desc.info.stage = desc.stageDesc.stage;
+	}
+
+	// Compiles every pipeline added since the last build, graphics first as they're usually the slowest. vkCreate*Pipelines can be
+	// called from several threads at once and the pipeline cache synchronises itself, so each worker just takes its share of the jobs.
+	// If any pipeline fails the ones already created are destroyed, so the caller's handles are all null when the error reaches it.
+	void PipelineBatch::Build(RecordThreadPool& threadPool)
+	{
+		auto buildStart = std::chrono::high_resolution_clock::now();
+
+		for (GraphicsPipelineDesc& desc : graphicsPipelines)
+			*desc.pipeline = VK_NULL_HANDLE;
+		for (ComputePipelineDesc& desc : computePipelines)
+			*desc.pipeline = VK_NULL_HANDLE;
+
+		uint32_t graphicsCount = SCAST_U32(graphicsPipelines.size());
+		pipelineCount = graphicsCount + SCAST_U32(computePipelines.size());
+		threadCount = std::min(threadPool.ThreadCount(), pipelineCount);
+		std::function<void(uint32_t, uint32_t)> buildJob = [&](uint32_t job, uint32_t)
+		{
+			if (job < graphicsCount)
+			{
+				GraphicsPipelineDesc& desc = graphicsPipelines[job];
+				if (vkCreateGraphicsPipelines(device, cache, 1, &desc.info, nullptr, desc.pipeline) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create " + desc.name + " pipeline");
+				}
+			}
+			else
+			{
+				ComputePipelineDesc& desc = computePipelines[job - graphicsCount];
+				if (vkCreateComputePipelines(device, cache, 1, &desc.info, nullptr, desc.pipeline) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create " + desc.name + " pipeline");
+				}
+			}
+		};
+
+		try
+		{
+			if (threadCount > 0)
+				threadPool.Run(threadCount, pipelineCount, buildJob);
+			else
+			{
+				for (uint32_t i = 0; i < pipelineCount; i++)
+					buildJob(i, 0);
+			}
+		}
+		catch (...)
+		{
+			for (GraphicsPipelineDesc& desc : graphicsPipelines)
+				DestroyPipeline(*desc.pipeline);
+			for (ComputePipelineDesc& desc : computePipelines)
+				DestroyPipeline(*desc.pipeline);
+			DestroyShaderModules();
+			graphicsPipelines.clear();
+			computePipelines.clear();
+			throw;
+		}
+
+		DestroyShaderModules();
+		graphicsPipelines.clear();
+		computePipelines.clear();
+		buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
+	}
+
+	void PipelineBatch::CopyStage(const VkPipelineShaderStageCreateInfo& src, ShaderStageDesc& dst)
+	{
+		dst.stage = src;
+		dst.entryPoint = src.pName;
+		dst.stage.pName = dst.entryPoint.c_str();
+		if (src.pSpecializationInfo != nullptr)
+		{
+			const VkSpecializationInfo& specialisation = *src.pSpecializationInfo;
+			const char* data = static_cast<const char*>(specialisation.pData);
+			dst.specialisation = specialisation;
+			dst.specialisation.pMapEntries = CopyArray(specialisation.pMapEntries, specialisation.mapEntryCount, dst.specialisationEntries);
+			dst.specialisation.pData = CopyArray(data, SCAST_U32(specialisation.dataSize), dst.specialisationData);
+			dst.stage.pSpecializationInfo = &dst.specialisation;
+		}
+	}
+
+	void PipelineBatch::DestroyPipeline(VkPipeline& pipeline)
+	{
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(device, pipeline, nullptr);
+		pipeline = VK_NULL_HANDLE;
+	}
+
+	void PipelineBatch::DestroyShaderModules()
+	{
+		for (auto& shaderModule : shaderModules)
+			vkDestroyShaderModule(device, shaderModule.second, nullptr);
+		shaderModules.clear();
+	}
+}
\ No newline at end of file
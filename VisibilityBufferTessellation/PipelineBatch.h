@@ -0,0 +1,89 @@
+#ifndef PIPELINEBATCH_H
+#define PIPELINEBATCH_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "VBTTypes.h"
+#include "RecordThreadPool.h"
+
+namespace vbt
+{
+	// Pipelines described up front then compiled together on the record threads instead of one after another on the main thread.
+	// Each description keeps its own copy of the create info and the state it points to, so the caller can change the create info
+	// and add the next variant straight away. Shader modules are loaded once per batch however many pipelines share them, and are
+	// destroyed once the batch is built. pNext chains are not copied.
+	class PipelineBatch
+	{
+	public:
+		void Begin(VkDevice device, VkPipelineCache cache);
+		VkShaderModule ShaderModule(const std::string& path);
+		void AddGraphics(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline, const std::string& name);
+		void AddCompute(const VkComputePipelineCreateInfo& info, VkPipeline* pipeline, const std::string& name);
+		void Build(RecordThreadPool& threadPool);
+
+		uint32_t PipelineCount() const { return pipelineCount; }
+		uint32_t ThreadCount() const { return threadCount; }
+		double BuildTime() const { return buildTime; }
+
+	private:
+		struct ShaderStageDesc
+		{
+			VkPipelineShaderStageCreateInfo stage;
+			std::string entryPoint;
+			VkSpecializationInfo specialisation;
+			std::vector<VkSpecializationMapEntry> specialisationEntries;
+			std::vector<char> specialisationData;
+		};
+
+		struct GraphicsPipelineDesc
+		{
+			std::vector<ShaderStageDesc> stageDescs;
+			std::vector<VkPipelineShaderStageCreateInfo> stages;
+			std::vector<VkVertexInputBindingDescription> vertexBindings;
+			std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+			std::vector<VkViewport> viewports;
+			std::vector<VkRect2D> scissors;
+			std::vector<VkSampleMask> sampleMask;
+			std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+			std::vector<VkDynamicState> dynamicStates;
+			VkPipelineVertexInputStateCreateInfo vertexInput;
+			VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+			VkPipelineTessellationStateCreateInfo tessellation;
+			VkPipelineViewportStateCreateInfo viewport;
+			VkPipelineRasterizationStateCreateInfo rasterization;
+			VkPipelineMultisampleStateCreateInfo multisample;
+			VkPipelineDepthStencilStateCreateInfo depthStencil;
+			VkPipelineColorBlendStateCreateInfo colourBlend;
+			VkPipelineDynamicStateCreateInfo dynamic;
+			VkGraphicsPipelineCreateInfo info;
+			VkPipeline* pipeline;
+			std::string name;
+		};
+
+		struct ComputePipelineDesc
+		{
+			ShaderStageDesc stageDesc;
+			VkComputePipelineCreateInfo info;
+			VkPipeline* pipeline;
+			std::string name;
+		};
+
+		static void CopyStage(const VkPipelineShaderStageCreateInfo& src, ShaderStageDesc& dst);
+		void DestroyPipeline(VkPipeline& pipeline);
+		void DestroyShaderModules();
+
+		VkDevice device = VK_NULL_HANDLE;
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		std::map<std::string, VkShaderModule> shaderModules; // By SPIR-V path
+		std::deque<GraphicsPipelineDesc> graphicsPipelines; // A deque so the descriptions never move once their pointers are set
+		std::deque<ComputePipelineDesc> computePipelines;
+
+		// Last batch built
+		uint32_t pipelineCount = 0;
+		uint32_t threadCount = 0;
+		double buildTime = 0.0; // Compiling every pipeline, ms
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "RecordThreadPool.h"
+
+namespace vbt
+{
+	void RecordThreadPool::Init(uint32_t threadCount)
+	{
+		for (uint32_t i = 0; i < threadCount; i++)
+			threads.emplace_back(&RecordThreadPool::WorkerLoop, this, i);
+	}
+
+	// Runs every job on the first threadCount workers and returns once they have all finished
+	void RecordThreadPool::Run(uint32_t threadCount, uint32_t jobCount, const std::function<void(uint32_t job, uint32_t thread)>& job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		currentJob = &job;
+		activeThreads = std::min(threadCount, static_cast<uint32_t>(threads.size()));
+		this->jobCount = jobCount;
+		pendingThreads = activeThreads;
+		error = nullptr;
+		generation++;
+		workReady.notify_all();
+		workDone.wait(lock, [this] { return pendingThreads == 0; });
+		currentJob = nullptr;
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void RecordThreadPool::CleanUp()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		workReady.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+		threads.clear();
+	}
+
+	void RecordThreadPool::WorkerLoop(uint32_t thread)
+	{
+		uint32_t seenGeneration = 0;
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+			if (stopping)
+				return;
+			seenGeneration = generation;
+			if (thread >= activeThreads)
+				continue;
+
+			// Record this thread's share of the jobs without holding the lock
+			const std::function<void(uint32_t, uint32_t)>& job = *currentJob;
+			uint32_t threadCount = activeThreads;
+			uint32_t count = jobCount;
+			lock.unlock();
+			try
+			{
+				for (uint32_t i = thread; i < count; i += threadCount)
+					job(i, thread);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> errorLock(mutex);
+				if (!error)
+					error = std::current_exception();
+			}
+
+			lock.lock();
+			if (--pendingThreads == 0)
+				workDone.notify_one();
+		}
+	}
+}
\ No newline at end of file
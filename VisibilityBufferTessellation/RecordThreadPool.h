@@ -0,0 +1,41 @@
+#ifndef RECORDTHREADPOOL_H
+#define RECORDTHREADPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vbt
+{
+	// Worker threads that record command buffers while the main thread waits. Jobs are handed out round robin, so job j always runs
+	// on thread j % threadCount and can record into command buffers allocated from that thread's pools.
+	class RecordThreadPool
+	{
+	public:
+		void Init(uint32_t threadCount);
+		void Run(uint32_t threadCount, uint32_t jobCount, const std::function<void(uint32_t job, uint32_t thread)>& job);
+		void CleanUp();
+		uint32_t ThreadCount() { return static_cast<uint32_t>(threads.size()); }
+
+	private:
+		void WorkerLoop(uint32_t thread);
+
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable workReady;
+		std::condition_variable workDone;
+		const std::function<void(uint32_t, uint32_t)>* currentJob = nullptr;
+		uint32_t activeThreads = 0;
+		uint32_t jobCount = 0;
+		uint32_t generation = 0; // Bumped for each Run, so a worker only picks up a batch once
+		uint32_t pendingThreads = 0;
+		std::exception_ptr error; // First exception thrown by a job, rethrown on the calling thread
+		bool stopping = false;
+	};
+}
+#endif
\ No newline at end of file
@@ -7,9 +7,10 @@ namespace vbt
 		CreateSurface(window, instance);
 	}
 
-	void SwapChain::InitSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device)
+	// The old swapchain is retired rather than destroyed, its images can still be presented until the caller destroys it
+	void SwapChain::InitSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device, VkSwapchainKHR oldSwapChain)
 	{
-		CreateSwapChain(window, physicalDevice, device);
+		CreateSwapChain(window, physicalDevice, device, oldSwapChain);
 		CreateSwapImageViews(device);
 	}
 
@@ -37,7 +38,7 @@ namespace vbt
 		}
 	}
 
-	void SwapChain::CreateSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device)
+	void SwapChain::CreateSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device, VkSwapchainKHR oldSwapChain)
 	{
 		SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(physicalDevice);
 
@@ -78,7 +79,7 @@ namespace vbt
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE; // Maybe disable this later on for more consistent test results
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		createInfo.oldSwapchain = oldSwapChain;
 
 		// Create swap chain
 		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
@@ -14,7 +14,7 @@ namespace vbt
 	{
 	public:
 		void InitSurface(GLFWwindow* window, VkInstance instance);
-		void InitSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device);
+		void InitSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
 		void CleanUpSwapChain(VkDevice device);
 		void CleanUpSurface(VkInstance instance);
 		static VkImageView CreateImageView(const VkDevice &device, VkImage &image, VkFormat format, VkImageAspectFlags aspectFlags);
@@ -27,7 +27,7 @@ namespace vbt
 		std::vector<VkImageView> ImageViews() const { return imageViews; }
 
 	private:
-		void CreateSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device);
+		void CreateSwapChain(GLFWwindow* window, VkPhysicalDevice physicalDevice, VkDevice device, VkSwapchainKHR oldSwapChain);
 		void CreateSurface(GLFWwindow* window, VkInstance instance);
 		void CreateSwapImageViews(VkDevice device);
 		SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
@@ -0,0 +1,65 @@
+#include "Sweep.h"
+
+namespace vbt
+{
+	void Sweep::Start()
+	{
+		running = true;
+		complete = false;
+		if (desc.start)
+			desc.start();
+		BeginStep(0);
+	}
+
+	// Samples the last frame, then reports the step and moves on once it has had all its frames
+	void Sweep::Update(uint32_t latency)
+	{
+		if (!running)
+			return;
+
+		// The first results of a step are from frames recorded with the previous configuration
+		if (discarded < latency)
+		{
+			discarded++;
+			return;
+		}
+
+		if (frame < desc.stepFrames)
+		{
+			SweepSample sample = desc.sample(step, frame);
+			for (size_t i = 0; i < totals.size(); i++)
+				totals[i] += sample[i];
+			frame++;
+			if (frame < desc.stepFrames || desc.measureFrame)
+				return;
+		}
+
+		SweepSample averages;
+		for (size_t i = 0; i < totals.size(); i++)
+			averages[i] = totals[i] / desc.stepFrames;
+		desc.report(step, averages);
+		BeginStep(step + 1);
+	}
+
+	// Applies the first step from firstStep on that isn't skipped, or finishes the sweep if there are none left
+	void Sweep::BeginStep(uint32_t firstStep)
+	{
+		step = firstStep;
+		frame = 0;
+		discarded = 0;
+		totals.fill(0.0);
+		while (step < desc.stepCount && desc.skip && desc.skip(step))
+			step++;
+
+		if (step == desc.stepCount)
+		{
+			running = false;
+			complete = true;
+			if (desc.finish)
+				desc.finish();
+			return;
+		}
+		if (desc.apply)
+			desc.apply(step);
+	}
+}
\ No newline at end of file
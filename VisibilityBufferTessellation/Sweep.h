@@ -0,0 +1,57 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace vbt
+{
+	const uint32_t SWEEP_STEP_FRAMES = 120; // Frames averaged at each step of a sweep that doesn't set its own count
+	const uint32_t SWEEP_SAMPLE_MAX = 3; // Values a sweep can average at each step
+
+	typedef std::array<double, SWEEP_SAMPLE_MAX> SweepSample;
+
+	// What a sweep measures and the configurations it steps through. Every callback runs on the main thread between frames, and
+	// only sample and report are required.
+	struct SweepDesc
+	{
+		uint32_t stepCount = 0;
+		uint32_t stepFrames = SWEEP_STEP_FRAMES;
+		bool measureFrame = false; // One more frame after the averaged ones, for measurements too slow for the timed frames
+		std::function<void()> start; // Clears the last results and saves whatever the steps change
+		std::function<bool(uint32_t step)> skip; // Steps it returns true for are passed over
+		std::function<void(uint32_t step)> apply; // Switches to the step's configuration before its first frame
+		std::function<SweepSample(uint32_t step, uint32_t frame)> sample; // The last frame's values, averaged over the step
+		std::function<void(uint32_t step, const SweepSample& averages)> report; // Stores the step's averages, after the measuring frame if there is one
+		std::function<void()> finish; // Restores whatever the steps changed
+	};
+
+	// Steps through a registered sweep, averaging the samples of a fixed number of frames at each step. Update is called once per
+	// frame, after the frame's times have been read back. Results arrive up to latency frames after they were recorded, so that
+	// many samples are discarded at the start of each step.
+	class Sweep
+	{
+	public:
+		void Register(const SweepDesc& sweepDesc) { desc = sweepDesc; }
+		void Start();
+		void Update(uint32_t latency);
+
+		bool Running() const { return running; }
+		bool Complete() const { return complete; }
+		uint32_t Step() const { return step; }
+		bool Measuring() const { return running && desc.measureFrame && frame == desc.stepFrames; } // The frame being recorded is the measuring frame
+
+	private:
+		void BeginStep(uint32_t firstStep);
+
+		SweepDesc desc;
+		bool running = false;
+		bool complete = false;
+		uint32_t step = 0;
+		uint32_t frame = 0; // Frames sampled in the current step
+		uint32_t discarded = 0; // Samples dropped in the current step, recorded before it was applied
+		SweepSample totals{};
+	};
+}
+#endif
\ No newline at end of file
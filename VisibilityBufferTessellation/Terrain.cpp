@@ -3,23 +3,24 @@
 
 namespace vbt
 {
-	// Generates terrain mesh, loads textures and returns triangle count. 
-	int Terrain::Init(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool, InitInfo info)
+	// Generates terrain mesh, loads textures and returns primitive count (triangles, or quads for quad patches). The uploads are
+	// recorded into the uploader's current batch.
+	int Terrain::Init(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, UploadManager& uploader, InitInfo info)
 	{
-		texture.LoadAndCreate(TEXTURE_PATH, allocator, device, physDevice, cmdPool);
-		heightmap.LoadAndCreate(HEIGHTMAP_PATH, allocator, device, physDevice, cmdPool);
-		normalmap.LoadAndCreate(NORMALMAP_PATH, allocator, device, physDevice, cmdPool);
+		texture.LoadAndCreate(TEXTURE_PATH, allocator, device, physDevice, uploader, true); // Only the colour texture is mipmapped, the height and normal maps are sampled at vertices
+		heightmap.LoadAndCreate(HEIGHTMAP_PATH, allocator, device, physDevice, uploader);
+		normalmap.LoadAndCreate(NORMALMAP_PATH, allocator, device, physDevice, uploader);
 
-		int triangleCount = Generate(info.subdivisions, info.width, info.uvScale);
+		int primitiveCount = Generate(info.subdivisions, info.width, info.uvScale, info.quadPatches);
 
-		CreateBuffers(allocator, device, physDevice, cmdPool);
+		CreateBuffers(allocator, uploader);
 
-		return triangleCount;
+		return primitiveCount;
 	}
 
-	void Terrain::SetupTextureDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count)
+	void Terrain::SetupTextureDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count, bool mipmapped)
 	{
-		texture.SetUpDescriptorInfo(layout);
+		texture.SetUpDescriptorInfo(layout, mipmapped ? texture.Sampler() : texture.BaseLevelSampler());
 		texture.SetupDescriptorWriteSet(dstSet, binding, type, count);
 	}
 
@@ -43,7 +44,7 @@ namespace vbt
 		normalmap.CleanUp(allocator, device);
 	}
 
-	int Terrain::Generate(int verticesPerEdge, int width, float uvScale)
+	int Terrain::Generate(int verticesPerEdge, int width, float uvScale, bool quadPatches)
 	{
 		// Get triangle count
 		const uint32_t quadsPerSide = verticesPerEdge - 1;
@@ -72,6 +73,25 @@ namespace vbt
 			}
 		}
 		
+		// Generate quad patch indices, in the same winding as the first triangle of each quad below
+		if (quadPatches)
+		{
+			indices.resize(quadCount * 4);
+			for (auto x = 0; x < quadsPerSide; x++)
+			{
+				for (auto y = 0; y < quadsPerSide; y++)
+				{
+					uint32_t index = (x + y * quadsPerSide) * 4;
+					indices[index] = (x + y * verticesPerEdge); // bottom left
+					indices[index + 1] = indices[index] + verticesPerEdge; // bottom right
+					indices[index + 2] = indices[index + 1] + 1; // top right
+					indices[index + 3] = indices[index] + 1; // top left
+				}
+			}
+
+			return quadCount;
+		}
+
 		// Generate triangle list indices
 		indices.resize(quadCount * 6);
 		for (auto x = 0; x < quadsPerSide; x++)
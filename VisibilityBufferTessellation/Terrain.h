@@ -20,13 +20,14 @@ namespace vbt
 			int subdivisions = 64;
 			int width = 32;
 			float uvScale = 5.0f;
+			bool quadPatches = false; // Generate 4 control point quad patches instead of a triangle list
 
 			InitInfo()
 			{}
 		};
 
-		int Init(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool, InitInfo info);
-		void SetupTextureDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count);
+		int Init(VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, UploadManager& uploader, InitInfo info);
+		void SetupTextureDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count, bool mipmapped = true);
 		void SetupHeightmapDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count);
 		void SetupNormalmapDescriptor(VkImageLayout layout, VkDescriptorSet dstSet, uint32_t binding, VkDescriptorType type, uint32_t count);
 		void CleanUp(VmaAllocator& allocator, VkDevice device);
@@ -36,7 +37,7 @@ namespace vbt
 		Texture Normalmap() { return normalmap; }
 
 	private:
-		int Generate(int verticesPerEdge, int width, float uvScale);
+		int Generate(int verticesPerEdge, int width, float uvScale, bool quadPatches);
 
 		vbt::Texture texture;
 		vbt::Texture heightmap; 
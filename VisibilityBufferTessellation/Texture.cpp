@@ -1,12 +1,13 @@
 #include "Texture.h"
-#include "Buffer.h"
 #include "VbtUtils.h"
+#include <algorithm>
+#include <cmath>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 namespace vbt
 {
-	void Texture::LoadAndCreate(std::string path, VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool)
+	void Texture::LoadAndCreate(std::string path, VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, UploadManager& uploader, bool generateMips)
 	{
 		// Load image file with STB library
 		int texWidth, texHeight, texChannels;
@@ -17,33 +18,109 @@ namespace vbt
 			throw std::runtime_error("Failed to load texture image");
 		}
 
-		// Create a staging buffer for the pixel data
-		Buffer stagingBuffer;
-		stagingBuffer.Create(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+		// Create Vulkan Image object, with a full mip chain down to 1x1 if requested. The levels are blitted from level 0, so it's
+		// also a transfer source.
+		uint32_t levels = generateMips ? static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1 : 1;
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (generateMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+		Create(texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, usage, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator, VK_SAMPLE_COUNT_1_BIT, levels);
 
-		// Copy the pixel values directly to the buffer
-		stagingBuffer.MapData(pixels, allocator);
-
-		// Clean up pixel memory
+		// The pixels are copied into a staging buffer of the uploader's batch, so they can be freed straight away. Single level images
+		// arrive ready for sampling, the rest stay transfer destinations for the blits on the graphics queue, which leave every level
+		// ready for sampling.
+		if (generateMips)
+		{
+			uploader.UploadImage(*this, pixels, imageSize, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+			GenerateMipmaps(uploader.GraphicsCommandBuffer(), physDevice);
+		}
+		else
+		{
+			VkPipelineStageFlags sampleStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			uploader.UploadImage(*this, pixels, imageSize, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampleStages, VK_ACCESS_SHADER_READ_BIT);
+		}
 		stbi_image_free(pixels);
 
-		// Now create Vulkan Image object
-		Create(texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+		// Now create the image view and the sampler
+		CreateImageView(device, VK_IMAGE_ASPECT_COLOR_BIT);
+		CreateSampler(device, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+		baseLevelSampler = generateMips ? BuildSampler(device, VK_SAMPLER_ADDRESS_MODE_REPEAT, 0.0f) : sampler;
+	}
+
+	void Texture::CleanUp(VmaAllocator& allocator, VkDevice device)
+	{
+		if (baseLevelSampler != sampler)
+			vkDestroySampler(device, baseLevelSampler, nullptr);
+		baseLevelSampler = VK_NULL_HANDLE;
+		Image::CleanUp(allocator, device);
+	}
+
+	// Each level is a linear blit of the one above it, halving both dimensions, which box filters it. Levels are moved to the
+	// shader read layout as soon as they've been blitted from. Recorded into a command buffer for a graphics queue.
+	void Texture::GenerateMipmaps(VkCommandBuffer commandBuffer, PhysicalDevice physDevice)
+	{
+		// Linear filtering of the format is required for blitting, it's mandatory for R8G8B8A8_UNORM but check anyway
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physDevice.VkHandle(), format, &formatProperties);
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+		{
+			throw std::runtime_error("Texture format does not support linear blitting for mip generation");
+		}
 
-		// Transition the texture image to the correct layout for recieving the pixel data from the buffer
-		TransitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, device, physDevice, cmdPool);
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
 
-		// Execute the copy from buffer to image
-		CopyFromBuffer(stagingBuffer.VkHandle(), device, physDevice, cmdPool);
+		int32_t mipWidth = static_cast<int32_t>(width);
+		int32_t mipHeight = static_cast<int32_t>(height);
+		for (uint32_t i = 1; i < mipLevels; i++)
+		{
+			// The level above was written by the copy or the previous blit
+			barrier.subresourceRange.baseMipLevel = i - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
-		// Now transition the image layout again to allow for sampling in the shader
-		TransitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device, physDevice, cmdPool);
+			int32_t nextWidth = std::max(mipWidth / 2, 1);
+			int32_t nextHeight = std::max(mipHeight / 2, 1);
+			VkImageBlit blit = {};
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = i - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = i;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+			vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 
-		// Free up the staging buffer
-		stagingBuffer.CleanUp(allocator);
+			// Finished with the level above, it's sampled by the fragment and compute resolve shaders
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
-		// Now create the image view and the sampler
-		CreateImageView(device, VK_IMAGE_ASPECT_COLOR_BIT);
-		CreateSampler(device, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+			mipWidth = nextWidth;
+			mipHeight = nextHeight;
+		}
+
+		// The last level is never blitted from
+		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 	}
 }
@@ -3,6 +3,7 @@
 
 #include "vk_mem_alloc.h"
 #include "Image.h"
+#include "UploadManager.h"
 
 namespace vbt
 {
@@ -10,7 +11,16 @@ namespace vbt
 	class Texture: public Image
 	{
 	public:
-		void LoadAndCreate(std::string path, VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, VkCommandPool& cmdPool);
+		void LoadAndCreate(std::string path, VmaAllocator& allocator, VkDevice device, PhysicalDevice physDevice, UploadManager& uploader, bool generateMips = false);
+		void CleanUp(VmaAllocator& allocator, VkDevice device);
+
+		VkSampler BaseLevelSampler() { return baseLevelSampler; }
+
+	private:
+		void GenerateMipmaps(VkCommandBuffer commandBuffer, PhysicalDevice physDevice);
+
+		// Only samples the full resolution level, so mipmapped textures can be compared with the old single level behaviour
+		VkSampler baseLevelSampler = VK_NULL_HANDLE;
 	};
 }
 
@@ -0,0 +1,258 @@
+#include "UploadManager.h"
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+namespace vbt
+{
+	void UploadManager::Init(VkDevice vkDevice, uint32_t graphicsQueueFamily, uint32_t transferQueueFamily, DeviceQueues* queues, VmaAllocator& vmaAllocator)
+	{
+		device = vkDevice;
+		allocator = vmaAllocator;
+		graphicsFamily = graphicsQueueFamily;
+		transferFamily = transferQueueFamily;
+		graphicsQueue = queues->graphics;
+		transferQueue = queues->transfer;
+
+		// Command buffers are only recorded once, so the pools are reset rather than their buffers
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = graphicsFamily;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &graphicsCommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload command pool");
+		}
+		if (SeparateTransferFamily())
+		{
+			poolInfo.queueFamilyIndex = transferFamily;
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create transfer command pool");
+			}
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &transferCompleteSemaphore) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create transfer semaphore");
+			}
+		}
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &batchFence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload fence");
+		}
+	}
+
+	// Starts recording a batch, the last one has to have been waited on
+	void UploadManager::Begin()
+	{
+		if (batchPending)
+		{
+			throw std::runtime_error("Upload batch begun before the last one was waited on");
+		}
+
+		graphicsCommandBuffer = AllocateCommandBuffer(graphicsCommandPool);
+		transferCommandBuffer = SeparateTransferFamily() ? AllocateCommandBuffer(transferCommandPool) : graphicsCommandBuffer;
+	}
+
+	// Copies the data into a staging buffer now and records its copy into dst, which has to be a transfer destination. The
+	// destination stages and accesses are the first uses of dst once the batch has finished.
+	void UploadManager::UploadBuffer(Buffer& dst, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+	{
+		Buffer stagingBuffer;
+		stagingBuffer.Create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+		stagingBuffer.MapData(const_cast<void*>(data), allocator);
+		stagingBuffers.push_back(stagingBuffer);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.size = size;
+		vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer.VkHandle(), dst.VkHandle(), 1, &copyRegion);
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = dst.VkHandle();
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		if (SeparateTransferFamily())
+		{
+			// Release from the transfer family, the destination access is ignored there. The acquire repeats the barrier on the
+			// graphics family with the source access ignored instead.
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccess;
+			vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+		}
+		else
+			vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		uploadCount++;
+		uploadedBytes += size;
+	}
+
+	// Copies the data into the first level of dst, moving every level to finalLayout. Images that go on to have their other levels
+	// written on the graphics queue ask for the transfer destination layout and record that work into GraphicsCommandBuffer().
+	void UploadManager::UploadImage(Image& dst, const void* data, VkDeviceSize size, VkImageLayout finalLayout, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+	{
+		Buffer stagingBuffer;
+		stagingBuffer.Create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+		stagingBuffer.MapData(const_cast<void*>(data), allocator);
+		stagingBuffers.push_back(stagingBuffer);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = dst.VkHandle();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = dst.MipLevels();
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		// Whole level copies are allowed whatever the transfer queue's image granularity is
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { dst.Width(), dst.Height(), 1 };
+		vkCmdCopyBufferToImage(transferCommandBuffer, stagingBuffer.VkHandle(), dst.VkHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// The layout transition happens once, between the release and the acquire, so both barriers carry it
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		if (SeparateTransferFamily())
+		{
+			barrier.srcQueueFamilyIndex = transferFamily;
+			barrier.dstQueueFamilyIndex = graphicsFamily;
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccess;
+			vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+		else
+			vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		uploadCount++;
+		uploadedBytes += size;
+	}
+
+	// Submits the batch without waiting for it. The graphics submission waits for the transfer one and signals the fence.
+	void UploadManager::Submit()
+	{
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		if (SeparateTransferFamily())
+		{
+			if (vkEndCommandBuffer(transferCommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to record transfer command buffer");
+			}
+			submitInfo.pCommandBuffers = &transferCommandBuffer;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &transferCompleteSemaphore;
+			if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit transfer command buffer");
+			}
+			submissionCount++;
+
+			submitInfo.signalSemaphoreCount = 0;
+			submitInfo.pSignalSemaphores = nullptr;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &transferCompleteSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+		}
+
+		if (vkEndCommandBuffer(graphicsCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer");
+		}
+		submitInfo.pCommandBuffers = &graphicsCommandBuffer;
+		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, batchFence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer");
+		}
+		submissionCount++;
+		batchPending = true;
+	}
+
+	// Blocks until the submitted batch has finished, then frees its staging buffers and command buffers
+	void UploadManager::Wait()
+	{
+		if (!batchPending)
+			return;
+
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		vkWaitForFences(device, 1, &batchFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		waitTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+		vkResetFences(device, 1, &batchFence);
+		batchPending = false;
+
+		for (Buffer& stagingBuffer : stagingBuffers)
+			stagingBuffer.CleanUp(allocator);
+		stagingBuffers.clear();
+
+		vkResetCommandPool(device, graphicsCommandPool, 0);
+		vkFreeCommandBuffers(device, graphicsCommandPool, 1, &graphicsCommandBuffer);
+		if (SeparateTransferFamily())
+		{
+			vkResetCommandPool(device, transferCommandPool, 0);
+			vkFreeCommandBuffers(device, transferCommandPool, 1, &transferCommandBuffer);
+		}
+		graphicsCommandBuffer = VK_NULL_HANDLE;
+		transferCommandBuffer = VK_NULL_HANDLE;
+	}
+
+	void UploadManager::CleanUp()
+	{
+		Wait();
+		vkDestroyFence(device, batchFence, nullptr);
+		vkDestroySemaphore(device, transferCompleteSemaphore, nullptr);
+		vkDestroyCommandPool(device, transferCommandPool, nullptr);
+		vkDestroyCommandPool(device, graphicsCommandPool, nullptr);
+	}
+
+	VkCommandBuffer UploadManager::AllocateCommandBuffer(VkCommandPool pool)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = pool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate upload command buffer");
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+}
\ No newline at end of file
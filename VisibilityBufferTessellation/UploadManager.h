@@ -0,0 +1,61 @@
+#ifndef UPLOADMANAGER_H
+#define UPLOADMANAGER_H
+
+#include <vector>
+#include "vk_mem_alloc.h"
+#include "VBTTypes.h"
+#include "Buffer.h"
+#include "Image.h"
+
+namespace vbt
+{
+	// Batches staging copies into one submission on the transfer queue instead of submitting and idling the graphics queue for each.
+	// When the transfer queue is from its own family, every resource is released by it and acquired by the graphics family, which
+	// waits on a semaphore the transfer submission signals. Work that needs the graphics queue, such as mip blits, is recorded into
+	// the graphics command buffer after the acquires. A batch is finished with a fence, and its staging buffers are freed once it's
+	// signalled.
+	class UploadManager
+	{
+	public:
+		void Init(VkDevice device, uint32_t graphicsFamily, uint32_t transferFamily, DeviceQueues* queues, VmaAllocator& allocator);
+		void Begin();
+		void UploadBuffer(Buffer& dst, const void* data, VkDeviceSize size, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+		void UploadImage(Image& dst, const void* data, VkDeviceSize size, VkImageLayout finalLayout, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+		void Submit();
+		void Wait();
+		void CleanUp();
+
+		VkCommandBuffer GraphicsCommandBuffer() { return graphicsCommandBuffer; } // Recorded after every resource is acquired
+		bool SeparateTransferFamily() const { return graphicsFamily != transferFamily; }
+		uint32_t SubmissionCount() const { return submissionCount; }
+		uint32_t UploadCount() const { return uploadCount; }
+		VkDeviceSize UploadedBytes() const { return uploadedBytes; }
+		double WaitTime() const { return waitTime; }
+
+	private:
+		VkCommandBuffer AllocateCommandBuffer(VkCommandPool pool);
+
+		VkDevice device = VK_NULL_HANDLE;
+		VmaAllocator allocator = VK_NULL_HANDLE;
+		VkQueue graphicsQueue = VK_NULL_HANDLE;
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		uint32_t graphicsFamily = 0;
+		uint32_t transferFamily = 0;
+		VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
+		VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE; // The graphics command buffer when there's no separate transfer family
+		VkSemaphore transferCompleteSemaphore = VK_NULL_HANDLE;
+		VkFence batchFence = VK_NULL_HANDLE;
+		bool batchPending = false;
+		std::vector<Buffer> stagingBuffers; // Freed once the batch that reads them has finished
+
+		// Totals across every batch
+		uint32_t submissionCount = 0;
+		uint32_t uploadCount = 0;
+		VkDeviceSize uploadedBytes = 0;
+		double waitTime = 0.0; // CPU time blocked waiting for batches to finish, ms
+	};
+}
+
+#endif
\ No newline at end of file
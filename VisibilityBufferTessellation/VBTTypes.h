@@ -19,12 +19,14 @@ struct DeviceQueues
 {
 	VkQueue graphics;
 	VkQueue present;
+	VkQueue transfer; // The graphics queue when there's no dedicated transfer family
 };
 
 struct QueueFamilyIndices
 {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentationFamily;
+	std::optional<uint32_t> transferFamily; // Only set for a family without graphics or compute, usually a DMA engine
 
 	bool isSuitable()
 	{
@@ -1,15 +1,17 @@
+#include <cmath>
 #include "VbtImGUI.h"
 #include "VulkanApplication.h"
 #include "VbtUtils.h"
 
 namespace vbt
 {	
-	void ImGUI::Init(VulkanApplication* app, GLFWwindow* window, ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool, int visBuffTriCount, int tessTriCount)
+	void ImGUI::Init(VulkanApplication* app, GLFWwindow* window, ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool, int visBuffTriCount, int tessTriCount, int tessQuadCount)
 	{
 		// Store app instance and triangle counts
 		appHandle = app;
 		this->visBuffTriCount = visBuffTriCount;
 		this->tessTricount = tessTriCount; // Tri-count in host memory won't change, subdivision is calculated locally per-frame
+		this->tessQuadCount = tessQuadCount;
 
 		// Create vulkan resources
 		CreateVulkanResources();
@@ -26,7 +28,7 @@ namespace vbt
 		ImGui_ImplGlfw_InitForVulkan(window, true);
 		ImGui_ImplVulkan_InitInfo initInfo = *info;
 		initInfo.DescriptorPool = descriptorPool;
-		ImGui_ImplVulkanVbt_Init(&initInfo, renderPass);
+		ImGui_ImplVulkan_Init(&initInfo, renderPass); // The UI render pass only has the one subpass, so the stock backend's pipeline is compatible
 
 		// Load Fonts
 		vbt::PhysicalDevice physDevice = appHandle->GetVulkanCore()->PhysDevice();
@@ -36,7 +38,8 @@ namespace vbt
 		ImGui_ImplVulkan_InvalidateFontUploadObjects();
 	}
 
-	// Reinitialises ImGui for new render pass configuration
+	// Rebuilds the Vulkan backend and re-uploads the fonts, which every pipeline switch used to do. Only the device idle switch
+	// still calls it, to measure against.
 	void ImGUI::Recreate(ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool)
 	{
 		vkDestroyDescriptorPool(appHandle->GetVulkanCore()->Device(), descriptorPool, nullptr);
@@ -46,7 +49,7 @@ namespace vbt
 
 		ImGui_ImplVulkan_InitInfo initInfo = *info;
 		initInfo.DescriptorPool = descriptorPool;
-		ImGui_ImplVulkanVbt_Init(&initInfo, renderPass);
+		ImGui_ImplVulkan_Init(&initInfo, renderPass);
 
 		// Load Fonts
 		vbt::PhysicalDevice physDevice = appHandle->GetVulkanCore()->PhysDevice();
@@ -88,6 +91,7 @@ namespace vbt
 
 		// Calculate tessellation tri-count at current tess factor
 		int tessCount = tessTricount * CalculateTriangleSubdivision(currentSettings.tessellationFactor);
+		int tessQuadTriCount = tessQuadCount * CalculateQuadSubdivision(currentSettings.tessellationFactor);
 
 		// Start the Dear ImGui frame
 		ImGui_ImplVulkan_NewFrame();
@@ -192,14 +196,96 @@ namespace vbt
 				}
 			}
 			ImGui::Text(currentSettings.pipeline == VISIBILITYBUFFER ? "Current: Visibility Buffer" : "Current: Vis Buff + Tessellation");
+			if (ImGui::Checkbox("Switch Through Device Idle", &(currentSettings.deviceIdleSwitch))) currentSettings.updateSettings = true;
+			RenderStatistics stats = appHandle->Statistics();
+			ImGui::Text("Last Switch: %.3f ms, first frame after: %.3f ms", stats.pipelineSwitchTimes[0], stats.pipelineSwitchFrameTimes[0]);
+			ImGui::Text("Last Device Idle Switch: %.3f ms, first frame after: %.3f ms", stats.pipelineSwitchTimes[1], stats.pipelineSwitchFrameTimes[1]);
 		}
 		if (ImGui::CollapsingHeader("Render Settings"), ImGuiTreeNodeFlags_DefaultOpen)
 		{
 			if (ImGui::Checkbox("Show Visibility Buffer", &(currentSettings.showVisBuff))) currentSettings.updateSettings = true;
 			if (ImGui::Checkbox("Show Interpolated UV Coords", &(currentSettings.showInterpTex))) currentSettings.updateSettings = true;
 			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::Checkbox("Show Tess Coords Buffer", &(currentSettings.showTessBuff))) currentSettings.updateSettings = true;
+			if (ImGui::Checkbox("32-bit Uint Visibility Buffer", &(currentSettings.uintVisibilityBuffer))) currentSettings.updateSettings = true;
+			if (ImGui::SliderInt("Frames In Flight", &(currentSettings.framesInFlight), 1, MAX_FRAMES_IN_FLIGHT)) currentSettings.updateSettings = true;
+			ImGui::Text("CPU Fence Wait: %.3f ms", appHandle->Statistics().fenceWaitTime);
+			if (ImGui::Checkbox("Resize Through Full Recreation", &(currentSettings.fullResize))) currentSettings.updateSettings = true;
+			ImGui::Text("Last Resize: %.3f ms, %u waiting to be destroyed", appHandle->Statistics().resizeStallTimes[0], appHandle->Statistics().retiredObjectCount);
+			ImGui::Text("Last Full Recreation Resize: %.3f ms", appHandle->Statistics().resizeStallTimes[1]);
+			ImGui::Text("Startup: %.1f ms, %.1f ms waiting on uploads", appHandle->Statistics().startupTime, appHandle->Statistics().uploadWaitTime);
+			ImGui::Text("Pipelines: %.1f ms from a %s cache (%.1f KB)", appHandle->Statistics().pipelineCreationTime, appHandle->Statistics().pipelineCacheWarm ? "warm" : "cold",
+				appHandle->Statistics().pipelineCacheLoadedBytes / 1024.0);
+			ImGui::Text("%u pipelines compiled on %u threads in %.1f ms, last rebuild: %.1f ms", appHandle->Statistics().pipelineCount, appHandle->Statistics().pipelineBuildThreads,
+				appHandle->Statistics().pipelineBuildTime, appHandle->Statistics().pipelineRebuildTime);
+			ImGui::Text("%u uploads (%.1f MB) in %u submissions on the %s queue", appHandle->Statistics().uploadCount, appHandle->Statistics().uploadedBytes / (1024.0 * 1024.0),
+				appHandle->Statistics().uploadSubmissionCount, appHandle->Statistics().dedicatedTransferQueue ? "transfer" : "graphics");
+			if (ImGui::Checkbox("Cache Scene Command Buffers", &(currentSettings.sceneCommandCache))) currentSettings.updateSettings = true;
+			if (ImGui::SliderInt("Recording Threads", &(currentSettings.recordThreads), 1, MAX_RECORD_THREADS)) currentSettings.updateSettings = true;
+			if (appHandle->Statistics().multiDrawIndirectSupported)
+			{
+				if (ImGui::SliderInt("Write Draw Calls", &(currentSettings.writeDrawCalls), 1, MATERIAL_DRAW_COUNT)) currentSettings.updateSettings = true;
+			}
+			else
+				ImGui::Text("Write Draw Calls: One Per Draw, Multi-Draw Indirect Not Supported");
+			ImGui::Text("Command Recording: %.3f ms, CPU Frame: %.3f ms", appHandle->Statistics().commandRecordTime, appHandle->Statistics().cpuFrameTime);
+			if (ImGui::Checkbox("GPU Timing Queries", &(currentSettings.gpuQueries))) currentSettings.updateSettings = true;
+			ImGui::Text("Query Readback: %u frames behind, %u dropped", appHandle->Statistics().queryReadbackLatency, appHandle->Statistics().droppedQueryResults);
+			if (currentSettings.pipeline == VISIBILITYBUFFER)
+			{
+				// Unsupported sample counts fall back to the highest supported one below them
+				const char* msaaModes[] = { "Off", "2x", "4x", "8x" };
+				int msaaMode = 0;
+				while (MSAA_SAMPLE_COUNTS[msaaMode] < currentSettings.msaaSamples)
+					msaaMode++;
+				if (ImGui::Combo("MSAA", &msaaMode, msaaModes, IM_ARRAYSIZE(msaaModes)))
+				{
+					currentSettings.msaaSamples = MSAA_SAMPLE_COUNTS[msaaMode];
+					currentSettings.updateSettings = true;
+				}
+			}
 			/*if (ImGui::Checkbox("Wireframe", &(currentSettings.wireframe))) currentSettings.updateSettings = true;*/
-			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::SliderInt("Tess Factor", &(currentSettings.tessellationFactor), 2, 64)) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Tile Classified Compute Shading", &(currentSettings.tileShading))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER)
+			{
+				if (!appHandle->Statistics().drawParametersSupported)
+					ImGui::Text("Material Binned Compute Shading: Not Supported");
+				else if (ImGui::Checkbox("Material Binned Compute Shading", &(currentSettings.materialShading))) currentSettings.updateSettings = true;
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.materialShading && appHandle->Statistics().drawParametersSupported) if(ImGui::SliderInt("Material Count", &(currentSettings.materialCount), 1, MATERIAL_COUNT_MAX)) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Variable Rate Compute Shading", &(currentSettings.vrs))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.vrs) if(ImGui::SliderInt("VRS Aggressiveness", &(currentSettings.vrsLevel), 0, static_cast<int>(VRS_GRADIENT_THRESHOLDS.size()) - 1)) currentSettings.updateSettings = true;
+			if(ImGui::Checkbox("Texture Mipmaps", &(currentSettings.textureMips))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Temporal Shading Reuse", &(currentSettings.temporalReuse))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.temporalReuse) if(ImGui::SliderInt("Reuse Budget (Frames)", &(currentSettings.temporalReuseBudget), 1, static_cast<int>(TEMPORAL_REUSE_BUDGETS.back()))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Triangle Setup Cache", &(currentSettings.triangleSetupCache))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Post-Transform Vertex Buffer", &(currentSettings.postTransform))) currentSettings.updateSettings = true;
+			if (appHandle->Statistics().subgroupFetchSupported)
+			{
+				if (ImGui::Checkbox("Subgroup Triangle Fetch", &(currentSettings.subgroupFetch))) currentSettings.updateSettings = true;
+			}
+			else
+				ImGui::Text("Subgroup Triangle Fetch: Not Supported");
+			if (currentSettings.pipeline == VISIBILITYBUFFER) if(ImGui::Checkbox("Software Raster Small Triangles", &(currentSettings.swRaster))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.swRaster) if(ImGui::SliderInt("Max SW Triangle Size (px)", &(currentSettings.swRasterMaxTriangleSize), 1, 32)) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::SliderInt("Tess Factor", &(currentSettings.tessellationFactor), 2, MAX_TESSELLATION_FACTOR)) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VB_TESSELLATION)
+			{
+				if (appHandle->Statistics().tessRecordsSupported)
+				{
+					if (ImGui::Checkbox("Triangle Record Buffer", &(currentSettings.tessTriangleRecords))) currentSettings.updateSettings = true;
+				}
+				else
+					ImGui::Text("Triangle Record Buffer: Not Supported");
+			}
+			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::Checkbox("Quad Patches", &(currentSettings.quadPatches))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::Checkbox("Depth Pre-Pass", &(currentSettings.depthPrePass))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VB_TESSELLATION) if(ImGui::Checkbox("Feedback Tess Factors", &(currentSettings.tessFeedback))) currentSettings.updateSettings = true;
+			if (currentSettings.pipeline == VB_TESSELLATION && currentSettings.tessFeedback)
+			{
+				if (ImGui::SliderFloat("Pixels Per Triangle", &(currentSettings.feedbackPixelsPerTriangle), 1.0f, 64.0f)) currentSettings.updateSettings = true;
+				if (ImGui::SliderFloat("Hysteresis", &(currentSettings.feedbackHysteresis), 0.0f, 1.0f)) currentSettings.updateSettings = true;
+				if (ImGui::SliderInt("Unseen Patch Factor", &(currentSettings.feedbackFallbackFactor), 1, MAX_TESSELLATION_FACTOR)) currentSettings.updateSettings = true;
+			}
 		}
 		ImGui::End();
 
@@ -232,6 +318,53 @@ namespace vbt
 				ImGui::Text("Deferred Pass: %.3f ms", deferredTimeSample);
 			}
 
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.tileShading)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Shaded Tiles (Sky / Single / Multi): %u / %u / %u", stats.tileShadeTileCounts[0], stats.tileShadeTileCounts[1], stats.tileShadeTileCounts[2]);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.vrs && !currentSettings.materialShading)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("VRS Tiles (1x1 / 2x1 / 1x2 / 2x2): %u / %u / %u / %u", stats.vrsTileCounts[0], stats.vrsTileCounts[1], stats.vrsTileCounts[2], stats.vrsTileCounts[3]);
+				ImGui::Text("VRS Shaded Pixels: %u", stats.vrsShadedPixelCount);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.temporalReuse && !currentSettings.materialShading && !currentSettings.vrs)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Temporal Pixels (Shaded / Reused / Disoccluded): %u / %u / %u", stats.temporalShadedPixelCount, stats.temporalReusedPixelCount, stats.temporalDisoccludedPixelCount);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.materialShading)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Sky Pixels: %u", stats.materialBinPixelCounts[0]);
+				for (int i = 1; i <= currentSettings.materialCount; i++)
+					ImGui::Text("Material %d Pixels: %u", i - 1, stats.materialBinPixelCounts[i]);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.triangleSetupCache && !currentSettings.tileShading && !currentSettings.materialShading)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Set Up Triangles: %u", stats.setupCacheTriangleCount);
+				ImGui::Text("Pixels per Triangle: %.1f", stats.setupCacheTriangleCount > 0 ? (double)stats.setupCachePixelCount / stats.setupCacheTriangleCount : 0.0);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.postTransform)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Vertex Transform Time: %.3f ms", stats.postTransformTime);
+			}
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.msaaSamples > 1)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("MSAA Samples: %u", stats.msaaSampleCount);
+				ImGui::Text("Vis Buff Attachments: %.1f MB", (double)stats.msaaAttachmentBytes / (1024.0 * 1024.0));
+			}
+			if (currentSettings.subgroupFetch)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Text("Subgroup Size: %u", stats.subgroupSize);
+				ImGui::Text("Triangle Fetches: %u of %u Pixels", stats.subgroupFetchCount, stats.subgroupFetchPixelCount);
+			}
+
 			ImGui::Separator();
 
 			if (ImGui::Button("Reset Times", ImVec2(150, 20)))
@@ -243,6 +376,354 @@ namespace vbt
 		{
 			ImGui::Text("Visibility Buffer Triangle Count: %d", visBuffTriCount);
 			ImGui::Text("Tessellated Triangle Count: %d", tessCount);
+			ImGui::Text("Tessellated Quad Triangle Count: %d", tessQuadTriCount);
+			if (currentSettings.pipeline == VISIBILITYBUFFER && currentSettings.swRaster)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Separator();
+				ImGui::Text("Software Rasterised Triangles: %u", stats.swRasterTriangleCount);
+				ImGui::Text("Software Raster Time: %.3f ms", stats.swRasterTime);
+				ImGui::Text(stats.swRasterInt64Atomics ? "Resolve: 64-bit Atomics" : "Resolve: Two Pass 32-bit Fallback");
+			}
+			if (currentSettings.pipeline == VB_TESSELLATION)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Separator();
+				ImGui::Text("%s Patches: %d", currentSettings.quadPatches ? "Quad" : "Triangle", currentSettings.quadPatches ? tessQuadCount : tessTricount);
+				if (stats.pipelineStatisticsSupported)
+				{
+					ImGui::Text("Control Shader Patches: %llu", stats.tessControlPatches);
+					ImGui::Text("Evaluation Shader Invocations: %llu", stats.tessEvaluationInvocations);
+					ImGui::Text("Clipping Primitives: %llu", stats.clippingPrimitives);
+
+					// Colour attachment bytes written per shaded fragment: swapchain and visibility buffer, plus tess coords unless masked off
+					uint64_t bytesPerFragment = 4 + 4;
+					if (!currentSettings.tessTriangleRecords) bytesPerFragment += currentSettings.quadPatches ? 4 + 4 : 4 + 4 + 1;
+					ImGui::Text("Fragment Shader Invocations: %llu", stats.fragmentInvocations);
+					ImGui::Text("Est. Colour Writes: %.2f MB", (double)(stats.fragmentInvocations * bytesPerFragment) / (1024.0 * 1024.0));
+				}
+				else
+					ImGui::Text("Pipeline Statistics: Not Supported");
+			}
+			if (currentSettings.pipeline == VB_TESSELLATION && currentSettings.tessTriangleRecords && appHandle->Statistics().tessRecordsSupported)
+			{
+				RenderStatistics stats = appHandle->Statistics();
+				ImGui::Separator();
+				ImGui::Text("Triangle Records Written: %u / %u", stats.tessRecordCount, stats.tessRecordCapacity);
+				ImGui::Text("Record Buffer Size: %.2f MB", (double)stats.tessRecordBufferSize / (1024.0 * 1024.0));
+				ImGui::Text("Record Buffer Used: %.2f MB", (double)(stats.tessRecordCount * sizeof(TessTriangleRecord)) / (1024.0 * 1024.0));
+			}
+		}
+		if (ImGui::CollapsingHeader("Benchmark", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			// Flies a fixed camera path, run once per configuration to compare feedback against uniform factors
+			RenderStatistics stats = appHandle->Statistics();
+			if (stats.benchmarkRunning)
+			{
+				ImGui::Text("Running benchmark path...");
+			}
+			else if (ImGui::Button("Run Benchmark Path", ImVec2(150, 20)))
+			{
+				appHandle->StartBenchmark();
+			}
+			if (stats.benchmarkFrames > 0)
+			{
+				ImGui::Text("Frames: %u", stats.benchmarkFrames);
+				ImGui::Text("Avg Frame: %.3f ms", stats.benchmarkFrameTime);
+				ImGui::Text("Avg Forward Pass: %.3f ms", stats.benchmarkForwardTime);
+				ImGui::Text("Avg Deferred Pass: %.3f ms", stats.benchmarkDeferredTime);
+				ImGui::Text("Avg Triangles: %.0f", stats.benchmarkTriangles);
+			}
+
+			// Times the forward pass at each software raster size threshold to find where compute overtakes the hardware rasteriser
+			if (currentSettings.pipeline == VISIBILITYBUFFER)
+			{
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_SW_RASTER])
+				{
+					ImGui::Text("Running crossover sweep...");
+				}
+				else if (ImGui::Button("Run Crossover Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_SW_RASTER);
+				}
+				if (stats.swRasterCrossoverSize >= 0)
+				{
+					for (size_t i = 0; i < SW_RASTER_SWEEP_SIZES.size(); i++)
+						ImGui::Text("%2d px: %.3f ms, %.0f SW triangles", SW_RASTER_SWEEP_SIZES[i], stats.swRasterSweepTimes[i], stats.swRasterSweepTriangles[i]);
+					ImGui::Text("Crossover: %d px", stats.swRasterCrossoverSize);
+				}
+
+				// Times the material binned deferred pass as the same scene is split between more materials
+				ImGui::Separator();
+				if (!stats.drawParametersSupported)
+				{
+					ImGui::Text("Material sweep needs shader draw parameters");
+				}
+				else if (stats.sweepRunning[SWEEP_MATERIAL])
+				{
+					ImGui::Text("Running material sweep...");
+				}
+				else if (ImGui::Button("Run Material Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_MATERIAL);
+				}
+				if (stats.sweepComplete[SWEEP_MATERIAL])
+				{
+					for (size_t i = 0; i < stats.materialSweepTimes.size(); i++)
+						ImGui::Text("%zu material%s: %.3f ms", i + 1, i > 0 ? "s" : "", stats.materialSweepTimes[i]);
+				}
+
+				// Times the deferred pass with and without the triangle setup cache as the field of view changes triangle density
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_SETUP_CACHE])
+				{
+					ImGui::Text("Running setup cache sweep...");
+				}
+				else if (ImGui::Button("Run Setup Cache Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_SETUP_CACHE);
+				}
+				if (stats.sweepComplete[SWEEP_SETUP_CACHE])
+				{
+					for (size_t i = 0; i < SETUP_CACHE_SWEEP_FOVS.size(); i++)
+						ImGui::Text("%2.0f deg, %.1f px/tri: %.3f -> %.3f ms (%.2fx)", SETUP_CACHE_SWEEP_FOVS[i], stats.setupCacheSweepPixelsPerTriangle[i], stats.setupCacheSweepUncachedTimes[i], stats.setupCacheSweepCachedTimes[i], stats.setupCacheSweepCachedTimes[i] > 0.0 ? stats.setupCacheSweepUncachedTimes[i] / stats.setupCacheSweepCachedTimes[i] : 0.0);
+				}
+
+				// Times the transform, write and shade stages with and without the post-transform vertex buffer
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_POST_TRANSFORM])
+				{
+					ImGui::Text("Running post-transform benchmark...");
+				}
+				else if (ImGui::Button("Run Post-Transform Benchmark", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_POST_TRANSFORM);
+				}
+				if (stats.sweepComplete[SWEEP_POST_TRANSFORM])
+				{
+					const char* modes[] = { "Per stage", "Post-transform" };
+					for (size_t i = 0; i < stats.postTransformBenchmarkTransformTimes.size(); i++)
+					{
+						double total = stats.postTransformBenchmarkTransformTimes[i] + stats.postTransformBenchmarkWriteTimes[i] + stats.postTransformBenchmarkShadeTimes[i];
+						ImGui::Text("%s: transform %.3f, write %.3f, shade %.3f, total %.3f ms", modes[i], stats.postTransformBenchmarkTransformTimes[i], stats.postTransformBenchmarkWriteTimes[i], stats.postTransformBenchmarkShadeTimes[i], total);
+					}
+				}
+
+				// Compares per pixel and per subgroup triangle fetches in the current pipeline's shade pass as the camera pulls back
+				ImGui::Separator();
+				if (!stats.subgroupFetchSupported)
+				{
+					ImGui::Text("Subgroup fetch sweep needs subgroup ballot in fragment shaders");
+				}
+				else if (stats.sweepRunning[SWEEP_SUBGROUP_FETCH])
+				{
+					ImGui::Text("Running subgroup fetch sweep...");
+				}
+				else if (ImGui::Button("Run Subgroup Fetch Sweep", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_SUBGROUP_FETCH);
+				}
+				if (stats.sweepComplete[SWEEP_SUBGROUP_FETCH])
+				{
+					// Each fetch reads three indices and three vertices
+					const double bytesPerFetch = 3.0 * (sizeof(uint32_t) + sizeof(Vertex));
+					for (size_t i = 0; i < SUBGROUP_FETCH_SWEEP_DISTANCES.size(); i++)
+						ImGui::Text("+%2.0f: %.3f -> %.3f ms, %.0f -> %.1f bytes/px", SUBGROUP_FETCH_SWEEP_DISTANCES[i], stats.subgroupFetchSweepPerPixelTimes[i], stats.subgroupFetchSweepSubgroupTimes[i], bytesPerFetch, bytesPerFetch * stats.subgroupFetchSweepFetchesPerPixel[i]);
+				}
+
+				// Times the vis buff at each sample count against the single sampled baseline
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_MSAA])
+				{
+					ImGui::Text("Running MSAA sweep...");
+				}
+				else if (ImGui::Button("Run MSAA Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_MSAA);
+				}
+				if (stats.sweepComplete[SWEEP_MSAA])
+				{
+					for (size_t i = 0; i < MSAA_SAMPLE_COUNTS.size(); i++)
+					{
+						if (!(stats.msaaSupportedSampleCounts & MSAA_SAMPLE_COUNTS[i]))
+						{
+							ImGui::Text("%dx: Not Supported", MSAA_SAMPLE_COUNTS[i]);
+							continue;
+						}
+						ImGui::Text("%dx: frame %.3f, forward %.3f, deferred %.3f ms, %.1f MB, ~%.1f MB/frame", MSAA_SAMPLE_COUNTS[i], stats.msaaSweepFrameTimes[i], stats.msaaSweepForwardTimes[i], stats.msaaSweepDeferredTimes[i],
+							(double)stats.msaaSweepAttachmentBytes[i] / (1024.0 * 1024.0), (double)stats.msaaSweepTrafficBytes[i] / (1024.0 * 1024.0));
+					}
+				}
+
+				// Times the VRS deferred pass at each aggressiveness level, and compares its output with full rate shading of the same frame
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_VRS])
+				{
+					ImGui::Text("Running VRS sweep...");
+				}
+				else if (ImGui::Button("Run VRS Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_VRS);
+				}
+				if (stats.sweepComplete[SWEEP_VRS])
+				{
+					for (size_t i = 0; i < VRS_GRADIENT_THRESHOLDS.size(); i++)
+					{
+						if (stats.vrsSweepMeanSquaredErrors[i] > 0.0)
+							ImGui::Text("Level %zu: %.3f ms, %.1f%% shaded, PSNR %.1f dB", i, stats.vrsSweepDeferredTimes[i], stats.vrsSweepShadedFractions[i] * 100.0, 10.0 * std::log10(255.0 * 255.0 / stats.vrsSweepMeanSquaredErrors[i]));
+						else
+							ImGui::Text("Level %zu: %.3f ms, %.1f%% shaded, lossless", i, stats.vrsSweepDeferredTimes[i], stats.vrsSweepShadedFractions[i] * 100.0);
+					}
+				}
+
+				// Compares sampling the base level of the terrain texture with its mip chain in the current pipeline's shade pass as the camera pulls back
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_TEXTURE_LOD])
+				{
+					ImGui::Text("Running texture LOD sweep...");
+				}
+				else if (ImGui::Button("Run Texture LOD Sweep", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_TEXTURE_LOD);
+				}
+				if (stats.sweepComplete[SWEEP_TEXTURE_LOD])
+				{
+					ImGui::Text("Texture memory: base level %.1f MB, mip chain %.1f MB", stats.textureBaseLevelBytes / (1024.0 * 1024.0), stats.textureMipChainBytes / (1024.0 * 1024.0));
+					for (size_t i = 0; i < TEXTURE_LOD_SWEEP_DISTANCES.size(); i++)
+						ImGui::Text("+%2.0f: %.3f -> %.3f ms", TEXTURE_LOD_SWEEP_DISTANCES[i], stats.textureLodSweepBaseLevelTimes[i], stats.textureLodSweepMipmappedTimes[i]);
+				}
+
+				// Times the temporal reuse deferred pass at each reuse budget while panning, and compares the reused pixels with shading them
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_TEMPORAL])
+				{
+					ImGui::Text("Running temporal sweep...");
+				}
+				else if (ImGui::Button("Run Temporal Sweep", ImVec2(150, 20)))
+				{
+					appHandle->StartSweep(SWEEP_TEMPORAL);
+				}
+				if (stats.sweepComplete[SWEEP_TEMPORAL])
+				{
+					for (size_t i = 0; i < TEMPORAL_REUSE_BUDGETS.size(); i++)
+					{
+						if (stats.temporalSweepMeanSquaredErrors[i] > 0.0)
+							ImGui::Text("Budget %u: %.3f ms, %.1f%% shaded, PSNR %.1f dB", TEMPORAL_REUSE_BUDGETS[i], stats.temporalSweepDeferredTimes[i], stats.temporalSweepShadedFractions[i] * 100.0, 10.0 * std::log10(255.0 * 255.0 / stats.temporalSweepMeanSquaredErrors[i]));
+						else
+							ImGui::Text("Budget %u: %.3f ms, %.1f%% shaded, lossless", TEMPORAL_REUSE_BUDGETS[i], stats.temporalSweepDeferredTimes[i], stats.temporalSweepShadedFractions[i] * 100.0);
+					}
+				}
+
+				// Times frames with 1 to MAX_FRAMES_IN_FLIGHT frame contexts. Whatever part of the CPU and GPU work no longer adds up to
+				// the frame time is the overlap gained by recording ahead.
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_FRAMES_IN_FLIGHT])
+				{
+					ImGui::Text("Running frames in flight sweep...");
+				}
+				else if (ImGui::Button("Run Frames In Flight Sweep", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_FRAMES_IN_FLIGHT);
+				}
+				if (stats.sweepComplete[SWEEP_FRAMES_IN_FLIGHT])
+				{
+					for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+					{
+						double frameTime = stats.framesInFlightSweepFrameTimes[i];
+						double cpuTime = frameTime - stats.framesInFlightSweepFenceWaits[i];
+						double overlap = std::max(cpuTime + stats.framesInFlightSweepGpuTimes[i] - frameTime, 0.0);
+						ImGui::Text("%zu: %.3f ms (%.0f fps), CPU %.3f ms, fence wait %.3f ms, GPU %.3f ms, overlap %.3f ms", i + 1, frameTime, frameTime > 0.0 ? 1000.0 / frameTime : 0.0,
+							cpuTime, stats.framesInFlightSweepFenceWaits[i], stats.framesInFlightSweepGpuTimes[i], overlap);
+					}
+				}
+
+				// Times the CPU side of frames re-recording the whole scene every frame against replaying the cached scene
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_RECORD_BENCHMARK])
+				{
+					ImGui::Text("Running command recording benchmark...");
+				}
+				else if (ImGui::Button("Run Recording Benchmark", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_RECORD_BENCHMARK);
+				}
+				if (stats.sweepComplete[SWEEP_RECORD_BENCHMARK])
+				{
+					const char* modes[] = { "Re-recorded", "Cached" };
+					for (size_t i = 0; i < stats.recordBenchmarkRecordTimes.size(); i++)
+						ImGui::Text("%s: recording %.3f ms, CPU frame %.3f ms", modes[i], stats.recordBenchmarkRecordTimes[i], stats.recordBenchmarkCpuFrameTimes[i]);
+				}
+
+				// Times re-recording the scene against the number of recording threads and write draw calls, only the vis buff
+				// material path splits its draws between threads
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_RECORD])
+				{
+					ImGui::Text("Running recording sweep...");
+				}
+				else if (currentSettings.pipeline == VISIBILITYBUFFER && ImGui::Button("Run Recording Sweep", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_RECORD);
+				}
+				if (stats.sweepComplete[SWEEP_RECORD])
+				{
+					ImGui::Text("Recording time (ms) by threads and draw calls");
+					for (size_t i = 0; i < RECORD_SWEEP_THREAD_COUNTS.size(); i++)
+					{
+						ImGui::Text("%u threads:", RECORD_SWEEP_THREAD_COUNTS[i]);
+						for (size_t j = 0; j < RECORD_SWEEP_DRAW_CALLS.size(); j++)
+						{
+							ImGui::SameLine();
+							ImGui::Text("%u: %.3f", RECORD_SWEEP_DRAW_CALLS[j], stats.recordSweepRecordTimes[i][j]);
+						}
+					}
+				}
+
+				// Frame time with the GPU queries written and polled against not writing them at all
+				ImGui::Separator();
+				if (stats.sweepRunning[SWEEP_TIMING_BENCHMARK])
+				{
+					ImGui::Text("Running timing overhead benchmark...");
+				}
+				else if (ImGui::Button("Run Timing Overhead Benchmark", ImVec2(200, 20)))
+				{
+					appHandle->StartSweep(SWEEP_TIMING_BENCHMARK);
+				}
+				if (stats.sweepComplete[SWEEP_TIMING_BENCHMARK])
+				{
+					const char* modes[] = { "Queries on", "Queries off" };
+					for (size_t i = 0; i < stats.timingBenchmarkFrameTimes.size(); i++)
+						ImGui::Text("%s: frame %.3f ms, CPU frame %.3f ms", modes[i], stats.timingBenchmarkFrameTimes[i], stats.timingBenchmarkCpuFrameTimes[i]);
+				}
+
+				// CPU cost of getting a frame's uniforms to the GPU, timed synchronously on scratch buffers
+				ImGui::Separator();
+				ImGui::Text("Uniform Write: %.3f us, Ring %s", stats.uniformWriteTime, stats.uniformRingDeviceLocal ? "Device Local" : "Host Memory");
+				if (ImGui::Button("Run Uniform Update Benchmark", ImVec2(200, 20)))
+				{
+					appHandle->RunUniformUpdateBenchmark();
+				}
+				if (stats.uniformBenchmarkComplete)
+				{
+					const char* modes[] = { "Map per update", "Mapped ring" };
+					for (size_t i = 0; i < stats.uniformBenchmarkTimes.size(); i++)
+						ImGui::Text("%s: %.3f us per frame", modes[i], stats.uniformBenchmarkTimes[i]);
+				}
+
+				// Startup with and without the pipeline cache file, by rebuilding every pipeline from an empty cache and the loaded one
+				ImGui::Separator();
+				if (ImGui::Button("Run Pipeline Cache Benchmark", ImVec2(200, 20)))
+				{
+					appHandle->RunPipelineCacheBenchmark();
+				}
+				if (stats.pipelineCacheBenchmarkComplete)
+				{
+					const char* modes[] = { "No cache", "Pipeline cache" };
+					for (size_t i = 0; i < stats.pipelineCacheBenchmarkTimes.size(); i++)
+						ImGui::Text("%s: pipelines %.1f ms, startup %.1f ms", modes[i], stats.pipelineCacheBenchmarkTimes[i], stats.pipelineCacheStartupTimes[i]);
+				}
+			}
 		}
 		ImGui::End();
 		ImGui::Render();
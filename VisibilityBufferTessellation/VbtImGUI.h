@@ -10,6 +10,7 @@
 #include "imgui_impl_vulkan.h"
 #include "imgui_impl_glfw.h"
 #include "PhysicalDevice.h"
+#include "VulkanCore.h"
 
 #define IMGUI_ENABLED true 
 
@@ -20,6 +21,17 @@ namespace vbt
 
 	// ImGui Settings
 	enum PipelineType { VISIBILITYBUFFER, VB_TESSELLATION };
+	enum SweepType { SWEEP_SW_RASTER, SWEEP_MATERIAL, SWEEP_SETUP_CACHE, SWEEP_POST_TRANSFORM, SWEEP_SUBGROUP_FETCH, SWEEP_MSAA, SWEEP_VRS, SWEEP_TEMPORAL, SWEEP_TEXTURE_LOD, SWEEP_FRAMES_IN_FLIGHT, SWEEP_RECORD_BENCHMARK, SWEEP_RECORD, SWEEP_TIMING_BENCHMARK, SWEEP_COUNT }; // Sweeps and stepped benchmarks, in the order they're updated each frame
+	constexpr std::array<int, 7> SW_RASTER_SWEEP_SIZES = { 0, 1, 2, 4, 8, 16, 32 }; // Max software triangle sizes in pixels compared by the crossover sweep, 0 rasterises everything in hardware
+	constexpr uint32_t MATERIAL_COUNT_MAX = 8; // Materials in the multi-material test scene, the material sweep shades 1 to this many
+	constexpr std::array<float, 5> SUBGROUP_FETCH_SWEEP_DISTANCES = { 0.0f, 5.0f, 10.0f, 20.0f, 40.0f }; // Distances the camera is pulled back by the subgroup fetch sweep, further away puts more triangles in each subgroup
+	constexpr std::array<int, 4> MSAA_SAMPLE_COUNTS = { 1, 2, 4, 8 }; // Vis buff sample counts offered in the settings and compared by the MSAA sweep
+	constexpr std::array<float, 5> VRS_GRADIENT_THRESHOLDS = { 0.0f, 0.01f, 0.025f, 0.05f, 0.1f }; // Luminance step below which a tile is shaded coarsely at each VRS aggressiveness level, level 0 shades at full rate
+	constexpr std::array<float, 5> TEXTURE_LOD_SWEEP_DISTANCES = { 0.0f, 10.0f, 20.0f, 40.0f, 80.0f }; // Distances the camera is pulled back by the texture LOD sweep, further away minifies the terrain texture more
+	constexpr std::array<uint32_t, 5> TEMPORAL_REUSE_BUDGETS = { 1, 2, 4, 8, 16 }; // Frames a shaded colour can be reused for, compared by the temporal sweep, 1 shades every pixel every frame
+	constexpr std::array<uint32_t, 4> RECORD_SWEEP_THREAD_COUNTS = { 1, 2, 4, 8 }; // Recording threads compared by the recording sweep
+	constexpr std::array<uint32_t, 4> RECORD_SWEEP_DRAW_CALLS = { 1, 4, 16, 32 }; // Indirect calls the material draws are split into at each thread count of the recording sweep
+	constexpr std::array<float, 5> SETUP_CACHE_SWEEP_FOVS = { 15.0f, 30.0f, 45.0f, 60.0f, 90.0f }; // Camera fields of view compared by the setup cache sweep, narrower views give each triangle more pixels
 	struct AppSettings
 	{
 		glm::vec3 cameraPos;
@@ -33,16 +45,154 @@ namespace vbt
 		bool showTessBuff = false;
 		bool showInterpTex = false;
 		bool wireframe = false;
+		bool tessTriangleRecords = false;
+		bool quadPatches = false;
+		bool depthPrePass = false;
+		bool uintVisibilityBuffer = false;
+		bool swRaster = false;
+		int swRasterMaxTriangleSize = 4;
+		bool tileShading = false;
+		bool materialShading = false;
+		int materialCount = MATERIAL_COUNT_MAX;
+		bool triangleSetupCache = false;
+		bool postTransform = false;
+		bool subgroupFetch = false;
+		int msaaSamples = 1;
+		bool vrs = false;
+		int vrsLevel = 2;
+		bool textureMips = true;
+		bool temporalReuse = false;
+		int temporalReuseBudget = 4;
+		int framesInFlight = 2;
+		bool deviceIdleSwitch = false; // Switch pipelines the old way, idling the device and rebuilding ImGui, to compare against
+		bool fullResize = false; // Recreate everything on resize the old way, to compare against
+		bool sceneCommandCache = true;
+		int recordThreads = 1;
+		int writeDrawCalls = 1;
+		bool gpuQueries = true;
+		bool tessFeedback = false;
+		float feedbackPixelsPerTriangle = 8.0f;
+		float feedbackHysteresis = 0.25f;
+		int feedbackFallbackFactor = 8;
 		bool updateSettings = false; // When true this class will call the UpdateSettings function of the appHandle
 	};
 
+	// Values read back from the GPU for display, owned by the application
+	struct RenderStatistics
+	{
+		uint32_t tessRecordCount = 0;
+		uint32_t tessRecordCapacity = 0;
+		VkDeviceSize tessRecordBufferSize = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t fragmentInvocations = 0;
+		uint64_t tessControlPatches = 0;
+		uint64_t tessEvaluationInvocations = 0;
+		std::array<bool, SWEEP_COUNT> sweepRunning{}; // By sweep type
+		std::array<bool, SWEEP_COUNT> sweepComplete{};
+		bool benchmarkRunning = false;
+		uint32_t benchmarkFrames = 0; // Results of the last completed benchmark run, times in ms
+		double benchmarkFrameTime = 0.0;
+		double benchmarkForwardTime = 0.0;
+		double benchmarkDeferredTime = 0.0;
+		double benchmarkTriangles = 0.0;
+		bool swRasterInt64Atomics = false;
+		uint32_t swRasterTriangleCount = 0;
+		double swRasterTime = 0.0;
+		std::array<double, SW_RASTER_SWEEP_SIZES.size()> swRasterSweepTimes{}; // Average forward pass time at each sweep size, ms
+		std::array<double, SW_RASTER_SWEEP_SIZES.size()> swRasterSweepTriangles{}; // Average software rasterised triangles at each sweep size
+		int swRasterCrossoverSize = -1; // Sweep size with the fastest forward pass, -1 until a sweep completes
+		std::array<uint32_t, 3> tileShadeTileCounts{}; // Sky, single triangle and multi triangle tiles of the last frame
+		std::array<uint32_t, MATERIAL_COUNT_MAX + 1> materialBinPixelCounts{}; // Sky pixels, then pixels of each material in the last frame
+		std::array<double, MATERIAL_COUNT_MAX> materialSweepTimes{}; // Average deferred pass time shading 1 to MATERIAL_COUNT_MAX materials, ms
+		uint32_t setupCacheTriangleCount = 0; // Triangles set up by the setup pass in the last frame
+		uint32_t setupCachePixelCount = 0; // Pixels covered by those triangles
+		std::array<double, SETUP_CACHE_SWEEP_FOVS.size()> setupCacheSweepUncachedTimes{}; // Average deferred pass time at each sweep field of view, ms
+		std::array<double, SETUP_CACHE_SWEEP_FOVS.size()> setupCacheSweepCachedTimes{}; // Including the setup pass
+		std::array<double, SETUP_CACHE_SWEEP_FOVS.size()> setupCacheSweepPixelsPerTriangle{}; // Average visible triangle size at each sweep field of view
+		double postTransformTime = 0.0; // Vertex transform pass of the last frame, ms
+		std::array<double, 2> postTransformBenchmarkTransformTimes{}; // Per stage transforms, then the post-transform buffer. Average ms.
+		std::array<double, 2> postTransformBenchmarkWriteTimes{};
+		std::array<double, 2> postTransformBenchmarkShadeTimes{};
+		bool subgroupFetchSupported = false;
+		bool drawParametersSupported = false;
+		bool multiDrawIndirectSupported = false;
+		bool pipelineStatisticsSupported = false;
+		bool tessRecordsSupported = false;
+		uint32_t subgroupSize = 0;
+		uint32_t subgroupFetchCount = 0; // Triangle or patch fetches made by the subgroup fetch shade pass in the last frame
+		uint32_t subgroupFetchPixelCount = 0; // Pixels shaded by it, the per pixel shade pass makes one fetch for each
+		std::array<double, SUBGROUP_FETCH_SWEEP_DISTANCES.size()> subgroupFetchSweepPerPixelTimes{}; // Average deferred pass time at each sweep distance, ms
+		std::array<double, SUBGROUP_FETCH_SWEEP_DISTANCES.size()> subgroupFetchSweepSubgroupTimes{};
+		std::array<double, SUBGROUP_FETCH_SWEEP_DISTANCES.size()> subgroupFetchSweepFetchesPerPixel{}; // Average subgroup fetches per shaded pixel at each sweep distance
+		uint32_t msaaSupportedSampleCounts = VK_SAMPLE_COUNT_1_BIT; // Vis buff sample counts usable with the current visibility format
+		uint32_t msaaSampleCount = 1; // Sample count the vis buff attachments were created with
+		VkDeviceSize msaaAttachmentBytes = 0; // Vis buff visibility and depth attachments at that sample count
+		std::array<double, MSAA_SAMPLE_COUNTS.size()> msaaSweepFrameTimes{}; // Average times at each sample count in ms, zero if it isn't supported
+		std::array<double, MSAA_SAMPLE_COUNTS.size()> msaaSweepForwardTimes{};
+		std::array<double, MSAA_SAMPLE_COUNTS.size()> msaaSweepDeferredTimes{};
+		std::array<VkDeviceSize, MSAA_SAMPLE_COUNTS.size()> msaaSweepAttachmentBytes{};
+		std::array<VkDeviceSize, MSAA_SAMPLE_COUNTS.size()> msaaSweepTrafficBytes{}; // Estimated attachment traffic per frame, every sample's ID and depth stored by the write pass then every ID loaded by the shade pass
+		std::array<uint32_t, 4> vrsTileCounts{}; // Tiles shaded at 1x1, 2x1, 1x2 and 2x2 in the last frame
+		uint32_t vrsShadedPixelCount = 0; // Pixels shaded by the VRS pass in the last frame, the rest were reconstructed from them
+		std::array<double, VRS_GRADIENT_THRESHOLDS.size()> vrsSweepDeferredTimes{}; // Average deferred pass time at each aggressiveness level, ms
+		std::array<double, VRS_GRADIENT_THRESHOLDS.size()> vrsSweepShadedFractions{}; // Average fraction of screen pixels shaded
+		std::array<double, VRS_GRADIENT_THRESHOLDS.size()> vrsSweepMeanSquaredErrors{}; // Against full rate shading of the same frame, per 8 bit channel
+		std::array<double, TEXTURE_LOD_SWEEP_DISTANCES.size()> textureLodSweepBaseLevelTimes{}; // Average deferred pass time sampling only the base level at each sweep distance, ms
+		std::array<double, TEXTURE_LOD_SWEEP_DISTANCES.size()> textureLodSweepMipmappedTimes{};
+		VkDeviceSize textureBaseLevelBytes = 0; // Memory of the vis buff terrain texture's base level and of its whole mip chain
+		VkDeviceSize textureMipChainBytes = 0;
+		uint32_t temporalShadedPixelCount = 0; // Pixels shaded by the temporal reuse pass in the last frame
+		uint32_t temporalReusedPixelCount = 0; // Pixels taken from the history
+		uint32_t temporalDisoccludedPixelCount = 0; // Pixels whose reprojection missed the screen or landed on another triangle
+		std::array<double, TEMPORAL_REUSE_BUDGETS.size()> temporalSweepDeferredTimes{}; // Average deferred pass time at each reuse budget, ms
+		std::array<double, TEMPORAL_REUSE_BUDGETS.size()> temporalSweepShadedFractions{}; // Average fraction of screen pixels shaded
+		std::array<double, TEMPORAL_REUSE_BUDGETS.size()> temporalSweepMeanSquaredErrors{}; // Of the reused pixels against shading them in the same frame, per 8 bit channel
+		double fenceWaitTime = 0.0; // CPU time blocked waiting for a frame context to come back from the GPU in the last frame, ms
+		std::array<double, MAX_FRAMES_IN_FLIGHT> framesInFlightSweepFrameTimes{}; // Average frame time with 1 to MAX_FRAMES_IN_FLIGHT frame contexts, ms
+		std::array<double, MAX_FRAMES_IN_FLIGHT> framesInFlightSweepFenceWaits{}; // Average CPU time stalled on fences, the rest of the frame time is CPU work
+		std::array<double, MAX_FRAMES_IN_FLIGHT> framesInFlightSweepGpuTimes{}; // Average forward and deferred pass time
+		double commandRecordTime = 0.0; // CPU time recording the last frame's command buffers, ms
+		double cpuFrameTime = 0.0; // Last frame's time less the fence wait, ms
+		std::array<double, 2> recordBenchmarkRecordTimes{}; // Re-recording the scene every frame, then replaying the cached scene. Average ms.
+		std::array<double, 2> recordBenchmarkCpuFrameTimes{};
+		std::array<std::array<double, RECORD_SWEEP_DRAW_CALLS.size()>, RECORD_SWEEP_THREAD_COUNTS.size()> recordSweepRecordTimes{}; // Average recording time by thread count then draw call count, ms
+		uint32_t queryReadbackLatency = 0; // Frames submitted after the one whose queries were last read back
+		uint32_t droppedQueryResults = 0; // Query results still unavailable when their frame context came back around
+		std::array<double, 2> timingBenchmarkFrameTimes{}; // With the GPU queries on, then off. Average ms.
+		std::array<double, 2> timingBenchmarkCpuFrameTimes{};
+		double uniformWriteTime = 0.0; // CPU time writing the last frame's uniforms into its ring slice, us
+		bool uniformRingDeviceLocal = false; // The ring got device local host visible memory
+		bool uniformBenchmarkComplete = false;
+		std::array<double, 2> uniformBenchmarkTimes{}; // Mapping, copying and unmapping a buffer per uniform, then copying into the persistently mapped ring. Average us per frame.
+		double startupTime = 0.0; // Time taken by Init, ms
+		double uploadWaitTime = 0.0; // Part of the startup time blocked waiting for uploads to finish, ms
+		uint32_t uploadSubmissionCount = 0; // Queue submissions made by the uploads
+		uint32_t uploadCount = 0;
+		VkDeviceSize uploadedBytes = 0;
+		bool dedicatedTransferQueue = false; // Uploads ran on a transfer only queue family
+		std::array<double, 2> pipelineSwitchTimes{}; // CPU time of the last pipeline switch without waiting, then through device idle and ImGui recreation, ms
+		std::array<double, 2> pipelineSwitchFrameTimes{}; // Time of the first frame drawn after each, which re-records the scene for the new pipeline, ms
+		std::array<double, 2> resizeStallTimes{}; // CPU time of the last swapchain recreation of size dependent objects, then of a full recreation after device idle, ms
+		uint32_t retiredObjectCount = 0; // Deletion queue entries still waiting on the frames that used them
+		bool pipelineCacheWarm = false; // The pipeline cache was loaded from disk at startup
+		size_t pipelineCacheLoadedBytes = 0;
+		uint32_t pipelineCount = 0;
+		uint32_t pipelineBuildThreads = 0; // Record threads the last batch of pipelines was compiled on
+		double pipelineBuildTime = 0.0; // Compiling the last batch of pipelines, ms
+		double pipelineRebuildTime = 0.0; // Describing and compiling every pipeline again after the last visibility buffer change, ms
+		double pipelineCreationTime = 0.0; // Creating the pipeline cache, layouts and every pipeline at startup, ms
+		bool pipelineCacheBenchmarkComplete = false;
+		std::array<double, 2> pipelineCacheBenchmarkTimes{}; // Building every pipeline from an empty cache, then from the run's cache, ms
+		std::array<double, 2> pipelineCacheStartupTimes{}; // This run's startup with its pipeline build swapped for each of those, ms
+	};
+
 	// Renders on-screen GUI via Dear ImGui library
 	class ImGUI
 	{
 	public:
-		void Init(VulkanApplication* app, GLFWwindow* window, ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool, int visBuffTriCount, int tessTriCount);
-		void Recreate(ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool);
+		void Init(VulkanApplication* app, GLFWwindow* window, ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool, int visBuffTriCount, int tessTriCount, int tessQuadCount);
 		void CreateVulkanResources();
+		void Recreate(ImGui_ImplVulkan_InitInfo* info, VkRenderPass renderPass, VkCommandPool commandPool);
 		void Update(double frameTime, double forwardTime, double deferredTime, glm::vec3 cameraPos, glm::vec3 cameraRot, glm::vec3 lightDirection, glm::vec4 lightDiffuse, glm::vec4 lightAmbient);
 		void DrawFrame(VkCommandBuffer commandBuffer);
 		void CleanUp();
@@ -59,7 +209,7 @@ namespace vbt
 		VkDescriptorPool descriptorPool;
 
 		// Cached values
-		int visBuffTriCount = 0, tessTricount = 0;
+		int visBuffTriCount = 0, tessTricount = 0, tessQuadCount = 0;
 		std::array<float, 50> frameTimes{};
 		double frameTimeMin = 9999.0, frameTimeMax = 0.0;
 		double frameTimeSample = 0.0;
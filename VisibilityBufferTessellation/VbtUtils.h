@@ -103,6 +103,13 @@ namespace vbt
 		if (lod == 0)  return 0;
 		return ((2 * lod - 2) * 3) + CalculateTriangleSubdivision(lod - 2);
 	}
+
+	// Number of triangles generated from a quad patch with equal spacing and all levels set to lod
+	static int CalculateQuadSubdivision(int lod)
+	{
+		if (lod <= 0)  return 2;
+		return 2 * lod * lod;
+	}
 }
 
 #endif // !HELPERFUNCTIONS_H
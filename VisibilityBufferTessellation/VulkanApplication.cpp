@@ -1,5 +1,9 @@
 #define VMA_IMPLEMENTATION
+#include <algorithm>
 #include <chrono>
+#include <exception>
+#include <filesystem>
+#include <mutex>
 #include "vk_mem_alloc.h"
 #include "VulkanApplication.h"
 #include "VbtUtils.h"
@@ -25,33 +29,81 @@ void VulkanApplication::InitWindow()
 void VulkanApplication::Init()
 {
 	// Initialise core objects and functionality
+	auto startupStart = std::chrono::high_resolution_clock::now();
 	vulkan = new VulkanCore();
 	vulkan->Init(window);
+	swRasterInt64 = vulkan->PhysDevice().SupportsInt64Atomics();
+	statistics.swRasterInt64Atomics = swRasterInt64;
+	subgroupFetchSupported = vulkan->PhysDevice().SupportsSubgroupFetch();
+	statistics.subgroupFetchSupported = subgroupFetchSupported;
+	statistics.subgroupSize = vulkan->PhysDevice().SubgroupProperties().subgroupSize;
+	drawParametersSupported = vulkan->PhysDevice().SupportsDrawParameters();
+	statistics.drawParametersSupported = drawParametersSupported;
+	multiDrawIndirectSupported = vulkan->PhysDevice().Features().multiDrawIndirect == VK_TRUE;
+	statistics.multiDrawIndirectSupported = multiDrawIndirectSupported;
+	pipelineStatisticsSupported = vulkan->PhysDevice().Features().pipelineStatisticsQuery == VK_TRUE;
+	statistics.pipelineStatisticsSupported = pipelineStatisticsSupported;
+	tessRecordsSupported = vulkan->PhysDevice().Features().vertexPipelineStoresAndAtomics == VK_TRUE;
+	statistics.tessRecordsSupported = tessRecordsSupported;
+	statistics.msaaSupportedSampleCounts = vulkan->PhysDevice().VisibilitySampleCounts(useUintVisibility);
 	InitCamera();
 	CreateVmaAllocator();
+	CreateUploadManager();
 	InitLight();
 	CreateCommandPool();
 	CreateTimestampPool();
+	recordThreadPool.Init(MAX_RECORD_THREADS);
+	CreateFrameBufferAttachments();
 	CreateRenderPasses();
 	CreateShadePassDescriptorSetLayouts();
 	CreateVisBuffWritePassDescriptorSetLayout();
 	CreateTessWritePassDescriptorSetLayout();
+	CreateTessFeedbackDescriptorSetLayout();
+	CreateSwRasterDescriptorSetLayout();
+	CreateTileShadeDescriptorSetLayout();
+	auto pipelineStart = std::chrono::high_resolution_clock::now();
 	CreatePipelineCache();
 	CreatePipelineLayouts();
-	CreateWritePipelines();
-	CreateShadePipelines();
+	auto pipelineBuildStart = std::chrono::high_resolution_clock::now();
+	CreatePipelines();
+	auto pipelineEnd = std::chrono::high_resolution_clock::now();
+	statistics.pipelineCreationTime = std::chrono::duration<double, std::milli>(pipelineEnd - pipelineStart).count();
+	startupPipelineBuildTime = std::chrono::duration<double, std::milli>(pipelineEnd - pipelineBuildStart).count();
 	InitialiseTerrains();
 	CreateUniformBuffers();
+	CreateTessRecordBuffers();
+	CreateTessFeedbackBuffers();
+	CreateSwRasterBuffers();
+	CreateTileShadeBuffers();
+	CreateMaterialShadeBuffers();
+	CreateTriangleSetupBuffers();
+	CreatePostTransformBuffers();
+	CreateSubgroupFetchBuffers();
+	CreateVrsBuffers();
+	CreateTemporalBuffers();
+	CreateCounterReadbackBuffers();
 	CreateDescriptorPool();
 	CreateFrameBuffers();
 	CreateShadePassDescriptorSets();
 	CreateWritePassDescriptorSet();
 	CreateTessWritePassDescriptorSet();
+	CreateTessFeedbackDescriptorSets();
+	CreateSwRasterDescriptorSet();
+	CreateTileShadeDescriptorSet();
 #if IMGUI_ENABLED
-	InitImGui(currentPipeline == VISIBILITYBUFFER ? visBuffRenderPass : tessRenderPass);
+	InitImGui();
 #endif
 	AllocateCommandBuffers();
-	RecordCommandBuffers();
+	RegisterSweeps();
+
+	// The terrain uploads have been running alongside everything created since they were submitted, the first frame needs them
+	uploadManager.Wait();
+	statistics.startupTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count();
+	statistics.uploadWaitTime = uploadManager.WaitTime();
+	statistics.uploadSubmissionCount = uploadManager.SubmissionCount();
+	statistics.uploadCount = uploadManager.UploadCount();
+	statistics.uploadedBytes = uploadManager.UploadedBytes();
+	statistics.dedicatedTransferQueue = uploadManager.SeparateTransferFamily();
 }
 
 void VulkanApplication::Update()
@@ -70,8 +122,17 @@ void VulkanApplication::Update()
 		auto frameEnd = std::chrono::high_resolution_clock::now();
 		auto diff = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
 		frameTime = diff / 1000.0;
+		statistics.cpuFrameTime = diff - statistics.fenceWaitTime;
+		if (pipelineSwitched)
+		{
+			statistics.pipelineSwitchFrameTimes[deviceIdleSwitch ? 1 : 0] = diff;
+			pipelineSwitched = false;
+		}
 
-		GetTimestampResults();
+		// Queries are polled by DrawFrame, so the pass times are from the last frame the GPU has finished
+		if (statistics.benchmarkRunning)
+			UpdateBenchmark();
+		UpdateSweeps();
 
 		camera.Update(frameTime);
 	}
@@ -83,37 +144,86 @@ void VulkanApplication::Update()
 void VulkanApplication::CleanUp()
 {
 	CleanUpSwapChainResources(); 
+	deletionQueue.FlushAll();
+
+	// Keep everything compiled this run for the next one
+	SavePipelineCache();
+	vkDestroyPipelineCache(vulkan->Device(), pipelineCache, nullptr);
 
 	// Destroy Descriptor Pool
 	vkDestroyDescriptorPool(vulkan->Device(), descriptorPool, nullptr);
 
-	// Destroy query pool
-	vkDestroyQueryPool(vulkan->Device(), timestampPool, nullptr);
+	// Destroy the frame contexts' query pools and command buffers
+	for (FrameContext& frame : frames)
+	{
+		vkDestroyQueryPool(vulkan->Device(), frame.timestampPool, nullptr);
+		vkDestroyQueryPool(vulkan->Device(), frame.pipelineStatisticsPool, nullptr);
+		frame.counterReadback.CleanUp(allocator);
+		vkFreeCommandBuffers(vulkan->Device(), commandPool, 1, &frame.commandBuffer);
+		vkFreeCommandBuffers(vulkan->Device(), commandPool, SCAST_U32(frame.sceneCommandBuffers.size()), frame.sceneCommandBuffers.data());
+		vkFreeCommandBuffers(vulkan->Device(), commandPool, 1, &frame.uiCommandBuffer);
+	}
 
 	// Destroy descriptor layouts
 	vkDestroyDescriptorSetLayout(vulkan->Device(), visBuffShadePassDescSetLayout, nullptr);
 	vkDestroyDescriptorSetLayout(vulkan->Device(), visBuffWritePassDescSetLayout, nullptr);
 	vkDestroyDescriptorSetLayout(vulkan->Device(), tessWritePassDescSetLayout, nullptr);
 	vkDestroyDescriptorSetLayout(vulkan->Device(), tessShadePassDescSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(vulkan->Device(), tessFeedbackDescSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(vulkan->Device(), swRasterDescSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(vulkan->Device(), tileShadeDescSetLayout, nullptr);
 
 	// Destroy uniform buffers
-	light.CleanUp(allocator);
-	mvpUniformBuffer.CleanUp(allocator);
-	settingsBuffer.CleanUp(allocator);
+	uniformRing.CleanUp(allocator);
+
+	// Destroy storage buffers
+	tessRecordBuffer.CleanUp(allocator);
+	tessRecordCounterBuffer.CleanUp(allocator);
+	tessPatchCoverageBuffer.CleanUp(allocator);
+	tessPatchFactorBuffer.CleanUp(allocator);
+	tessVertexFactorBuffer.CleanUp(allocator);
+	swRasterIndexBuffer.CleanUp(allocator);
+	swRasterTriangleBuffer.CleanUp(allocator);
+	swRasterDispatchBuffer.CleanUp(allocator);
+	swRasterVisibilityBuffer.CleanUp(allocator);
+	tileListBuffer.CleanUp(allocator);
+	tileDispatchBuffer.CleanUp(allocator);
+	materialBinBuffer.CleanUp(allocator);
+	materialPixelBuffer.CleanUp(allocator);
+	materialDrawBuffer.CleanUp(allocator);
+	materialBuffer.CleanUp(allocator);
+	visBuffDrawCommandBuffer.CleanUp(allocator);
+	triangleSetupBuffer.CleanUp(allocator);
+	visibleTriangleBuffer.CleanUp(allocator);
+	triangleSetupCounterBuffer.CleanUp(allocator);
+	transformedVertexBuffer.CleanUp(allocator);
+	subgroupFetchCounterBuffer.CleanUp(allocator);
+	vrsRateBuffer.CleanUp(allocator);
+	vrsCounterBuffer.CleanUp(allocator);
+	temporalHistoryBuffer.CleanUp(allocator);
+	temporalCounterBuffer.CleanUp(allocator);
 
 	// Destroy vertex and index buffers
 	visBuffTerrain.CleanUp(allocator, vulkan->Device());
 	tessTerrain.CleanUp(allocator, vulkan->Device());
+	tessQuadTerrain.CleanUp(allocator, vulkan->Device());
 
 #if IMGUI_ENABLED
 	// Destroy ImGui resources
 	imGui.CleanUp();
 #endif
 
+	uploadManager.CleanUp();
 	vmaDestroyAllocator(allocator);
 
-	// Destroy command pool
+	// Destroy command pools, the recording threads' pools free the command buffers allocated from them
 	vkDestroyCommandPool(vulkan->Device(), commandPool, nullptr);
+	for (FrameContext& frame : frames)
+	{
+		for (VkCommandPool threadCommandPool : frame.threadCommandPools)
+			vkDestroyCommandPool(vulkan->Device(), threadCommandPool, nullptr);
+	}
+	recordThreadPool.CleanUp();
 
 	// Clean up Vulkan core objects
 	vulkan->CleanUp();
@@ -128,22 +238,22 @@ void VulkanApplication::CleanUp()
 
 #if IMGUI_ENABLED
 #pragma region ImGui Functions
-void VulkanApplication::InitImGui(VkRenderPass renderPass)
+void VulkanApplication::InitImGui()
 {
-	ImGui_ImplVulkan_InitInfo initInfo = {};
-	initInfo.Instance = vulkan->Instance();
-	initInfo.PhysicalDevice = vulkan->PhysDevice().VkHandle();
-	initInfo.Device = vulkan->Device();
-	initInfo.QueueFamily = PhysicalDevice::FindQueueFamilies(vulkan->PhysDevice().VkHandle(), vulkan->Swapchain().Surface()).graphicsFamily.value();
-	initInfo.Queue = vulkan->PhysDevice().Queues()->graphics;
-	initInfo.PipelineCache = pipelineCache;
-	initInfo.Allocator = nullptr;
-	initInfo.CheckVkResultFn = ImGuiCheckVKResult;
-	imGui.Init(this, window, &initInfo, renderPass, commandPool, visBuffTerrainTriCount, tessTerrainTriCount);
+	ImGui_ImplVulkan_InitInfo initInfo = ImGuiInitInfo();
+	imGui.Init(this, window, &initInfo, uiRenderPass, commandPool, visBuffTerrainTriCount, tessTerrainTriCount, tessQuadPatchCount);
 	imGui.Update(0.0, 0.0, 0.0, camera.Position(), camera.Rotation(), light.Direction(), light.Diffuse(), light.Ambient()); // Update imgui frame once to populate buffers
 }
 
-void VulkanApplication::RecreateImGui(VkRenderPass renderPass)
+// The device idle pipeline switch rebuilds the ImGui backend like every switch used to, then redraws the UI with the new font texture
+void VulkanApplication::RecreateImGui()
+{
+	ImGui_ImplVulkan_InitInfo initInfo = ImGuiInitInfo();
+	imGui.Recreate(&initInfo, uiRenderPass, commandPool);
+	imGui.Update(0.0, 0.0, 0.0, camera.Position(), camera.Rotation(), light.Direction(), light.Diffuse(), light.Ambient());
+}
+
+ImGui_ImplVulkan_InitInfo VulkanApplication::ImGuiInitInfo()
 {
 	ImGui_ImplVulkan_InitInfo initInfo = {};
 	initInfo.Instance = vulkan->Instance();
@@ -154,8 +264,7 @@ void VulkanApplication::RecreateImGui(VkRenderPass renderPass)
 	initInfo.PipelineCache = pipelineCache;
 	initInfo.Allocator = nullptr;
 	initInfo.CheckVkResultFn = ImGuiCheckVKResult;
-	imGui.Recreate(&initInfo, renderPass, commandPool);
-	imGui.Update(0.0f, 0.0, 0.0, camera.Position(), camera.Rotation(), light.Direction(), light.Diffuse(), light.Ambient());
+	return initInfo;
 }
 
 void VulkanApplication::ApplySettings(AppSettings settings)
@@ -175,19 +284,66 @@ void VulkanApplication::ApplySettings(AppSettings settings)
 	renderSettingsUbo.showVisibilityBuffer = settings.showVisBuff;
 	renderSettingsUbo.showInterpolatedTex = settings.showInterpTex;
 	renderSettingsUbo.wireframe = settings.wireframe;
-
-	// Check for pipeline change
-	if (settings.pipeline != currentPipeline)
+	useTessRecords = settings.tessTriangleRecords && tessRecordsSupported;
+	if (useTessRecords)
+		GrowTessRecordBuffer();
+	renderSettingsUbo.tessFeedback = settings.tessFeedback;
+	renderSettingsUbo.tessFeedbackFallbackFactor = settings.feedbackFallbackFactor;
+	renderSettingsUbo.tessFeedbackPixelsPerTriangle = settings.feedbackPixelsPerTriangle;
+	renderSettingsUbo.tessFeedbackHysteresis = settings.feedbackHysteresis;
+	renderSettingsUbo.tessFeedbackQuadPatches = settings.quadPatches;
+	renderSettingsUbo.tessFeedbackPatchCount = SCAST_U32(settings.quadPatches ? tessQuadPatchCount : tessTerrainTriCount);
+	if (settings.tessFeedback != useTessFeedback || settings.quadPatches != useQuadPatches)
+		resetTessFeedback = true; // Stored factors are indexed by patch and vertex of the previous terrain
+	useTessFeedback = settings.tessFeedback;
+	useQuadPatches = settings.quadPatches;
+	useDepthPrePass = settings.depthPrePass;
+	useSwRaster = settings.swRaster;
+	swRasterMaxTriangleSize = SCAST_U32(settings.swRasterMaxTriangleSize);
+	useTileShading = settings.tileShading;
+	useMaterialShading = settings.materialShading && drawParametersSupported;
+	useSetupCache = settings.triangleSetupCache;
+	usePostTransform = settings.postTransform;
+	useSubgroupFetch = settings.subgroupFetch && subgroupFetchSupported;
+	useVrs = settings.vrs;
+	vrsLevel = SCAST_U32(settings.vrsLevel);
+	useTemporalReuse = settings.temporalReuse;
+	temporalReuseBudget = SCAST_U32(settings.temporalReuseBudget);
+	temporalHistoryValid = false; // Any setting can change the shading, so nothing in the history is reused
+	if (SCAST_U32(settings.framesInFlight) != framesInFlight && !sweeps[SWEEP_FRAMES_IN_FLIGHT].Running())
+		SetFramesInFlight(SCAST_U32(settings.framesInFlight));
+	useSceneCache = settings.sceneCommandCache;
+	recordThreads = SCAST_U32(settings.recordThreads);
+	writeDrawCalls = SCAST_U32(settings.writeDrawCalls);
+	useGpuQueries = settings.gpuQueries;
+	if (settings.textureMips != useTextureMips && !sweeps[SWEEP_TEXTURE_LOD].Running())
 	{
-		// Command buffers are re-recorded every frame to satisfy ImGui, so changing the local current pipeline will automatically bind the new pipeline and renderpass objects for the next frame. 
-		currentPipeline = settings.pipeline;
-
-		// Wait for current operations to be finished
-		vkDeviceWaitIdle(vulkan->Device());
+		useTextureMips = settings.textureMips;
+		UpdateTextureDescriptors();
+	}
+	if (SCAST_U32(settings.materialCount) != materialCount)
+	{
+		// A running sweep restores the table from the current count when it finishes
+		materialCount = SCAST_U32(settings.materialCount);
+		if (!sweeps[SWEEP_MATERIAL].Running())
+			UpdateMaterialDrawTable(materialCount);
+	}
 
-		// Need to reinitialise ImGui to be compatible with new renderpass
-		RecreateImGui(currentPipeline == VISIBILITYBUFFER ? visBuffRenderPass : tessRenderPass);
+	// Changing the visibility buffer format or sample count invalidates the attachments and every object built against them. A
+	// running MSAA sweep owns the sample count until it finishes.
+	VkSampleCountFlagBits sampleCount = sweeps[SWEEP_MSAA].Running() ? visBuffSampleCount : SupportedVisBuffSampleCount(settings.msaaSamples, settings.uintVisibilityBuffer);
+	if (settings.uintVisibilityBuffer != useUintVisibility || sampleCount != visBuffSampleCount)
+	{
+		useUintVisibility = settings.uintVisibilityBuffer;
+		visBuffSampleCount = sampleCount;
+		statistics.msaaSupportedSampleCounts = vulkan->PhysDevice().VisibilitySampleCounts(useUintVisibility);
+		RecreateVisibilityBufferResources();
 	}
+
+	// Check for pipeline change
+	deviceIdleSwitch = settings.deviceIdleSwitch;
+	fullResize = settings.fullResize;
+	SwitchPipeline(settings.pipeline);
 }
 #pragma endregion
 #endif
@@ -203,43 +359,728 @@ void VulkanApplication::InitialiseTerrains()
 	tessTerrainInfo.subdivisions = 14;
 	tessTerrainInfo.width = 64;
 	tessTerrainInfo.uvScale = 10.75f;
-
-	// Generate terrain geometry
-	visBuffTerrainTriCount = visBuffTerrain.Init(allocator, vulkan->Device(), vulkan->PhysDevice(), commandPool, visBuffTerrainInfo);
-	tessTerrainTriCount = tessTerrain.Init(allocator, vulkan->Device(), vulkan->PhysDevice(), commandPool, tessTerrainInfo);
+	Terrain::InitInfo tessQuadTerrainInfo = tessTerrainInfo;
+	tessQuadTerrainInfo.quadPatches = true;
+
+	// Generate terrain geometry. Every texture and buffer upload goes in one batch that isn't waited on until the end of Init.
+	uploadManager.Begin();
+	visBuffTerrainTriCount = visBuffTerrain.Init(allocator, vulkan->Device(), vulkan->PhysDevice(), uploadManager, visBuffTerrainInfo);
+	visBuffTerrainVertexCount = static_cast<int>(visBuffTerrain.Vertices().size());
+	tessTerrainTriCount = tessTerrain.Init(allocator, vulkan->Device(), vulkan->PhysDevice(), uploadManager, tessTerrainInfo);
+	tessQuadPatchCount = tessQuadTerrain.Init(allocator, vulkan->Device(), vulkan->PhysDevice(), uploadManager, tessQuadTerrainInfo);
+	uploadManager.Submit();
+
+	// Texture memory reported alongside the texture LOD sweep, 4 bytes per texel in every level
+	Texture texture = visBuffTerrain.GetTexture();
+	statistics.textureBaseLevelBytes = (VkDeviceSize)texture.Width() * texture.Height() * 4;
+	statistics.textureMipChainBytes = 0;
+	for (uint32_t i = 0; i < texture.MipLevels(); i++)
+		statistics.textureMipChainBytes += (VkDeviceSize)std::max(texture.Width() >> i, 1u) * std::max(texture.Height() >> i, 1u) * 4;
 }
 #pragma endregion
 
 #pragma region Testing Functions
+// Each frame context has its own pools, so the pools form a ring with one entry per frame in flight. A frame can be recorded
+// while the results of the ones before it are still pending, and the cached scene secondaries can write their own context's pools.
 void VulkanApplication::CreateTimestampPool()
 {
 	VkQueryPoolCreateInfo timestampPoolInfo = {};
 	timestampPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
 	timestampPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
-	timestampPoolInfo.queryCount = 4; // Start of forward, end of forward, start of deferred, end of deferred. 
+	timestampPoolInfo.queryCount = 8; // Start of forward, end of forward, start of deferred, end of deferred, start and end of the software raster passes, start and end of the vertex transform pass
 	timestampPoolInfo.pNext = NULL;
 	timestampPoolInfo.flags = 0;
 
-	if (vkCreateQueryPool(vulkan->Device(), &timestampPoolInfo, nullptr, &timestampPool) != VK_SUCCESS)
+	// Pipeline statistics of the write subpass, used to compare tessellator work between patch types. One per write slice, as each
+	// slice is recorded into its own secondary. Not created when the device can't query statistics.
+	VkQueryPoolCreateInfo statisticsPoolInfo = {};
+	statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	statisticsPoolInfo.queryCount = MAX_RECORD_THREADS;
+	statisticsPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT | VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+
+	// Ticks are converted with the device's period rather than assumed to be nanoseconds, and only the queue's valid bits count
+	QueueFamilyIndices queueFamilyIndices = PhysicalDevice::FindQueueFamilies(vulkan->PhysDevice().VkHandle(), vulkan->Swapchain().Surface());
+	uint32_t validBits = vulkan->PhysDevice().TimestampValidBits(queueFamilyIndices.graphicsFamily.value());
+	if (validBits == 0)
+	{
+		throw std::runtime_error("Graphics queue doesn't support timestamps");
+	}
+	timestampPeriod = vulkan->PhysDevice().TimestampPeriod();
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	for (FrameContext& frame : frames)
 	{
-		throw std::runtime_error("Query pool creation failed");
+		if (vkCreateQueryPool(vulkan->Device(), &timestampPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Query pool creation failed");
+		}
+		frame.pipelineStatisticsPool = VK_NULL_HANDLE;
+		if (pipelineStatisticsSupported && vkCreateQueryPool(vulkan->Device(), &statisticsPoolInfo, nullptr, &frame.pipelineStatisticsPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Pipeline statistics query pool creation failed");
+		}
 	}
 }
 
-void VulkanApplication::GetTimestampResults()
+// Reads a frame context's queries without waiting, returning false if the GPU hasn't written all of them yet. Each result is
+// followed by its availability.
+bool VulkanApplication::GetQueryResults(FrameContext& frame)
 {
-	// Requests the results of the timestamp queries made in the current frame
-	std::array<uint64_t, 4> timestamps;
-
-	if (vkGetQueryPoolResults(vulkan->Device(), timestampPool, 0, SCAST_U32(timestamps.size()), SCAST_U32(timestamps.size()) * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+	const size_t timestampCount = 8;
+	std::array<uint64_t, timestampCount * 2> timestamps;
+	VkResult result = vkGetQueryPoolResults(vulkan->Device(), frame.timestampPool, 0, SCAST_U32(timestampCount), SCAST_U32(timestamps.size()) * sizeof(uint64_t), timestamps.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
 	{
 		throw std::runtime_error("Failed to get timestamp results");
 	}
-	else
+	for (size_t i = 0; i < timestampCount; i++)
+	{
+		if (timestamps[i * 2 + 1] == 0)
+			return false;
+	}
+
+	// Statistics are returned in order of their bits: clipping primitives, fragment invocations, control patches, evaluation invocations.
+	// Each write slice has its own query, so they're summed.
+	if (pipelineStatisticsSupported)
+	{
+		const size_t statisticCount = 4;
+		const size_t statisticStride = statisticCount + 1;
+		std::array<uint64_t, statisticStride * MAX_RECORD_THREADS> pipelineStatistics;
+		result = vkGetQueryPoolResults(vulkan->Device(), frame.pipelineStatisticsPool, 0, frame.writeSliceCount, SCAST_U32(pipelineStatistics.size()) * sizeof(uint64_t), pipelineStatistics.data(), statisticStride * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+		{
+			throw std::runtime_error("Failed to get pipeline statistics results");
+		}
+		std::array<uint64_t, statisticCount> totals = {};
+		for (uint32_t slice = 0; slice < frame.writeSliceCount; slice++)
+		{
+			if (pipelineStatistics[slice * statisticStride + statisticCount] == 0)
+				return false;
+			for (size_t i = 0; i < statisticCount; i++)
+				totals[i] += pipelineStatistics[slice * statisticStride + i];
+		}
+		statistics.clippingPrimitives = totals[0];
+		statistics.fragmentInvocations = totals[1];
+		statistics.tessControlPatches = totals[2];
+		statistics.tessEvaluationInvocations = totals[3];
+	}
+
+	// Differences are taken in the valid bits so a counter wrapping between two timestamps still gives the elapsed ticks
+	auto elapsedMs = [&](size_t start, size_t end) { return (double)((timestamps[end * 2] - timestamps[start * 2]) & timestampMask) * timestampPeriod / 1000000.0; };
+	statistics.swRasterTime = elapsedMs(4, 5);
+	statistics.postTransformTime = elapsedMs(6, 7);
+	forwardPassTime = elapsedMs(0, 1) + statistics.swRasterTime + statistics.postTransformTime; // Software raster and vertex transform passes run before the render pass but are part of the forward work
+	deferredPassTime = elapsedMs(2, 3);
+	statistics.queryReadbackLatency = SCAST_U32(submittedFrameCount - frame.querySubmitFrame);
+	return true;
+}
+
+// Reads back every frame context's finished queries, oldest first so the newest results are the ones kept. Frames finish in
+// submission order on the one queue, so it stops at the first that isn't ready.
+void VulkanApplication::PollQueryResults()
+{
+	while (true)
+	{
+		FrameContext* oldest = nullptr;
+		for (FrameContext& frame : frames)
+		{
+			if (frame.queriesPending && (oldest == nullptr || frame.querySubmitFrame < oldest->querySubmitFrame))
+				oldest = &frame;
+		}
+		if (oldest == nullptr || !GetQueryResults(*oldest))
+			return;
+		oldest->queriesPending = false;
+	}
+}
+
+// Counters the frame context's last submission copied into its readback buffer, read once its fence has signalled
+void VulkanApplication::GetCounterResults(const FrameContext& frame)
+{
+	const CounterReadback& counters = *static_cast<const CounterReadback*>(frame.counterReadback.mappedRange);
+
+	// Only the passes the submission recorded wrote their counters, the settings may have changed since
+	const SceneRecordState& state = frame.sceneState;
+
+	// Small triangle count written by the bin pass
+	if (state.swRaster)
+		statistics.swRasterTriangleCount = counters.swRasterDispatch[3];
+
+	// Group counts of the tile shade dispatches are the number of tiles in each class
+	if (state.tileShade)
+	{
+		for (size_t i = 0; i < statistics.tileShadeTileCounts.size(); i++)
+			statistics.tileShadeTileCounts[i] = counters.tileDispatches[i].x;
+	}
+
+	// Bin sizes are the number of pixels shaded by each material kernel
+	if (state.materialShade)
+		statistics.materialBinPixelCounts = counters.materialBins.counts;
+
+	// Visible triangles and their coverage, counted by the setup pass
+	if (state.setupCache)
+	{
+		statistics.setupCacheTriangleCount = counters.triangleSetup.triangleCount;
+		statistics.setupCachePixelCount = counters.triangleSetup.pixelCount;
+	}
+
+	// Fetches made by the subgroup fetch shade pass and the pixels sharing them
+	if (state.subgroupFetch)
+	{
+		statistics.subgroupFetchCount = counters.subgroupFetch.fetchCount;
+		statistics.subgroupFetchPixelCount = counters.subgroupFetch.pixelCount;
+	}
+
+	// Tiles at each shading rate and the pixels actually shaded by the VRS pass
+	if (state.vrs)
+	{
+		std::copy(counters.vrs.tileCounts.begin(), counters.vrs.tileCounts.end(), statistics.vrsTileCounts.begin());
+		statistics.vrsShadedPixelCount = counters.vrs.shadedPixelCount;
+	}
+
+	// Pixels shaded, reused and disoccluded by the temporal reuse pass
+	if (state.temporalReuse)
+	{
+		statistics.temporalShadedPixelCount = counters.temporal.shadedPixelCount;
+		statistics.temporalReusedPixelCount = counters.temporal.reusedPixelCount;
+		statistics.temporalDisoccludedPixelCount = counters.temporal.disoccludedPixelCount;
+	}
+
+	// Triangles appended to the record buffer
+	if (state.recordTriangles)
+		statistics.tessRecordCount = counters.tessRecordCount;
+}
+
+// Waits for the frame submitted last and returns its counters, for sweeps that need the results of one particular frame rather
+// than whichever frame finished most recently
+const CounterReadback& VulkanApplication::WaitForSubmittedCounters()
+{
+	vkWaitForFences(vulkan->Device(), 1, &vulkan->Fences()[lastSubmittedFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	return *static_cast<const CounterReadback*>(frames[lastSubmittedFrame].counterReadback.mappedRange);
+}
+
+// Camera keyframes (position, rotation) for the benchmark path, flown at a constant rate over BENCHMARK_DURATION
+static const std::array<std::pair<glm::vec3, glm::vec3>, 5> benchmarkPath = { {
+	{ glm::vec3(-2.0f, -6.0f, -1.5f), glm::vec3(10.0f, 310.0f, 0.0f) },
+	{ glm::vec3(8.0f, -4.0f, 6.0f), glm::vec3(20.0f, 280.0f, 0.0f) },
+	{ glm::vec3(16.0f, -3.0f, -4.0f), glm::vec3(25.0f, 220.0f, 0.0f) },
+	{ glm::vec3(4.0f, -10.0f, -14.0f), glm::vec3(35.0f, 160.0f, 0.0f) },
+	{ glm::vec3(-2.0f, -6.0f, -1.5f), glm::vec3(10.0f, 310.0f, 0.0f) }
+} };
+
+void VulkanApplication::StartBenchmark()
+{
+	benchmarkElapsed = 0.0;
+	benchmarkFrameTimeTotal = 0.0;
+	benchmarkForwardTimeTotal = 0.0;
+	benchmarkDeferredTimeTotal = 0.0;
+	benchmarkTriangleTotal = 0;
+	benchmarkFrameCount = 0;
+	statistics.benchmarkRunning = true;
+	statistics.benchmarkFrames = 0;
+	camera.SetPosition(benchmarkPath.front().first);
+	camera.SetRotation(benchmarkPath.front().second);
+}
+
+// Accumulates the last frame's results and moves the camera along the benchmark path
+void VulkanApplication::UpdateBenchmark()
+{
+	benchmarkFrameTimeTotal += frameTime * 1000.0;
+	benchmarkForwardTimeTotal += forwardPassTime;
+	benchmarkDeferredTimeTotal += deferredPassTime;
+	benchmarkTriangleTotal += statistics.clippingPrimitives;
+	benchmarkFrameCount++;
+	benchmarkElapsed += frameTime;
+
+	if (benchmarkElapsed >= BENCHMARK_DURATION)
+	{
+		statistics.benchmarkRunning = false;
+		statistics.benchmarkFrames = benchmarkFrameCount;
+		statistics.benchmarkFrameTime = benchmarkFrameTimeTotal / benchmarkFrameCount;
+		statistics.benchmarkForwardTime = benchmarkForwardTimeTotal / benchmarkFrameCount;
+		statistics.benchmarkDeferredTime = benchmarkDeferredTimeTotal / benchmarkFrameCount;
+		statistics.benchmarkTriangles = (double)benchmarkTriangleTotal / benchmarkFrameCount;
+		return;
+	}
+
+	float pathPosition = (float)(benchmarkElapsed / BENCHMARK_DURATION) * (benchmarkPath.size() - 1);
+	size_t segment = (size_t)pathPosition;
+	float t = pathPosition - (float)segment;
+	camera.SetPosition(glm::mix(benchmarkPath[segment].first, benchmarkPath[segment + 1].first, t));
+	camera.SetRotation(glm::mix(benchmarkPath[segment].second, benchmarkPath[segment + 1].second, t));
+}
+
+// Runs one sweep from its first step. Sweeps are independent, so any number can run at once.
+void VulkanApplication::StartSweep(SweepType type)
+{
+	sweeps[type].Start();
+	statistics.sweepRunning[type] = sweeps[type].Running();
+	statistics.sweepComplete[type] = sweeps[type].Complete();
+}
+
+// Each feature registers the sweep or stepped benchmark that measures it
+void VulkanApplication::RegisterSweeps()
+{
+	RegisterSwRasterSweep();
+	RegisterMaterialSweep();
+	RegisterSetupCacheSweep();
+	RegisterPostTransformBenchmark();
+	RegisterSubgroupFetchSweep();
+	RegisterMsaaSweep();
+	RegisterVrsSweep();
+	RegisterTemporalSweep();
+	RegisterTextureLodSweep();
+	RegisterFramesInFlightSweep();
+	RegisterRecordBenchmark();
+	RegisterRecordSweep();
+	RegisterTimingBenchmark();
+}
+
+// Samples the last frame into every running sweep, stepping those that have had all their frames. A frame's counters are read
+// back when its context is next used, so they're framesInFlight frames behind.
+void VulkanApplication::UpdateSweeps()
+{
+	for (size_t i = 0; i < sweeps.size(); i++)
+	{
+		sweeps[i].Update(framesInFlight);
+		statistics.sweepRunning[i] = sweeps[i].Running();
+		statistics.sweepComplete[i] = sweeps[i].Complete();
+	}
+}
+
+// Measures the forward pass at each software triangle size from the current camera, the fastest size is the crossover
+// point where hardware rasterisation starts to outperform the compute rasteriser
+void VulkanApplication::RegisterSwRasterSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(SW_RASTER_SWEEP_SIZES.size());
+	desc.start = [this]()
+	{
+		statistics.swRasterSweepTimes.fill(0.0);
+		statistics.swRasterSweepTriangles.fill(0.0);
+		statistics.swRasterCrossoverSize = -1;
+	};
+	desc.sample = [this](uint32_t step, uint32_t)
+	{
+		return SweepSample{ forwardPassTime, SW_RASTER_SWEEP_SIZES[step] > 0 ? (double)statistics.swRasterTriangleCount : 0.0 };
+	};
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.swRasterSweepTimes[step] = averages[0];
+		statistics.swRasterSweepTriangles[step] = averages[1];
+	};
+	desc.finish = [this]()
+	{
+		auto fastest = std::min_element(statistics.swRasterSweepTimes.begin(), statistics.swRasterSweepTimes.end());
+		statistics.swRasterCrossoverSize = SW_RASTER_SWEEP_SIZES[std::distance(statistics.swRasterSweepTimes.begin(), fastest)];
+	};
+	sweeps[SWEEP_SW_RASTER].Register(desc);
+}
+
+// Measures the deferred pass shading 1 to MATERIAL_COUNT_MAX materials with the same geometry and camera, so only the number
+// of bins and kernels changes between steps
+void VulkanApplication::RegisterMaterialSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = MATERIAL_COUNT_MAX;
+	desc.start = [this]() { statistics.materialSweepTimes.fill(0.0); };
+	desc.apply = [this](uint32_t step) { UpdateMaterialDrawTable(step + 1); };
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ deferredPassTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages) { statistics.materialSweepTimes[step] = averages[0]; };
+	desc.finish = [this]() { UpdateMaterialDrawTable(materialCount); };
+	sweeps[SWEEP_MATERIAL].Register(desc);
+}
+
+// Measures the deferred pass with and without the triangle setup cache at several fields of view. Narrowing the view gives each
+// visible triangle more pixels, so the setup work is shared by more of them. Even steps run without the cache, odd steps with it.
+void VulkanApplication::RegisterSetupCacheSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(SETUP_CACHE_SWEEP_FOVS.size() * 2);
+	desc.start = [this]()
+	{
+		statistics.setupCacheSweepUncachedTimes.fill(0.0);
+		statistics.setupCacheSweepCachedTimes.fill(0.0);
+		statistics.setupCacheSweepPixelsPerTriangle.fill(0.0);
+	};
+
+	// The field of view only changes once both runs are done
+	desc.apply = [this](uint32_t step)
+	{
+		VkExtent2D extent = vulkan->Swapchain().Extent();
+		if (step % 2 == 0)
+			camera.SetPerspective(SETUP_CACHE_SWEEP_FOVS[step / 2], (float)extent.width / (float)extent.height, 0.1f, 500.0f);
+	};
+	desc.sample = [this](uint32_t step, uint32_t)
+	{
+		bool cached = step % 2 == 1;
+		double pixelsPerTriangle = cached && statistics.setupCacheTriangleCount > 0 ? (double)statistics.setupCachePixelCount / statistics.setupCacheTriangleCount : 0.0;
+		return SweepSample{ deferredPassTime, pixelsPerTriangle };
+	};
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		size_t fovIndex = step / 2;
+		if (step % 2 == 1)
+		{
+			statistics.setupCacheSweepCachedTimes[fovIndex] = averages[0];
+			statistics.setupCacheSweepPixelsPerTriangle[fovIndex] = averages[1];
+		}
+		else
+			statistics.setupCacheSweepUncachedTimes[fovIndex] = averages[0];
+	};
+	desc.finish = [this]()
+	{
+		VkExtent2D extent = vulkan->Swapchain().Extent();
+		camera.SetPerspective(CAMERA_FOV, (float)extent.width / (float)extent.height, 0.1f, 500.0f);
+	};
+	sweeps[SWEEP_SETUP_CACHE].Register(desc);
+}
+
+// Measures the shade pass fetching triangles per pixel and per subgroup as the camera is pulled back. Triangles shrink with
+// distance, so each subgroup covers more of them and shares less of each fetch. Even steps fetch per pixel, odd steps per subgroup.
+void VulkanApplication::RegisterSubgroupFetchSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(SUBGROUP_FETCH_SWEEP_DISTANCES.size() * 2);
+	desc.start = [this]()
+	{
+		subgroupFetchSweepOrigin = camera.Position();
+		statistics.subgroupFetchSweepPerPixelTimes.fill(0.0);
+		statistics.subgroupFetchSweepSubgroupTimes.fill(0.0);
+		statistics.subgroupFetchSweepFetchesPerPixel.fill(0.0);
+	};
+
+	// The camera only moves once both runs are done
+	desc.apply = [this](uint32_t step)
+	{
+		if (step % 2 == 0)
+			camera.SetPosition(subgroupFetchSweepOrigin - camera.Forward() * SUBGROUP_FETCH_SWEEP_DISTANCES[step / 2]);
+	};
+	desc.sample = [this](uint32_t step, uint32_t)
+	{
+		bool subgroup = step % 2 == 1;
+		double fetchesPerPixel = subgroup && statistics.subgroupFetchPixelCount > 0 ? (double)statistics.subgroupFetchCount / statistics.subgroupFetchPixelCount : 0.0;
+		return SweepSample{ deferredPassTime, fetchesPerPixel };
+	};
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		size_t distanceIndex = step / 2;
+		if (step % 2 == 1)
+		{
+			statistics.subgroupFetchSweepSubgroupTimes[distanceIndex] = averages[0];
+			statistics.subgroupFetchSweepFetchesPerPixel[distanceIndex] = averages[1];
+		}
+		else
+			statistics.subgroupFetchSweepPerPixelTimes[distanceIndex] = averages[0];
+	};
+	desc.finish = [this]() { camera.SetPosition(subgroupFetchSweepOrigin); };
+	sweeps[SWEEP_SUBGROUP_FETCH].Register(desc);
+}
+
+// Times each stage with per stage vertex transforms, then with the post-transform buffer, from the same camera. The transform
+// pass is counted apart from the rest of the forward work.
+void VulkanApplication::RegisterPostTransformBenchmark()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(statistics.postTransformBenchmarkTransformTimes.size());
+	desc.start = [this]()
+	{
+		statistics.postTransformBenchmarkTransformTimes.fill(0.0);
+		statistics.postTransformBenchmarkWriteTimes.fill(0.0);
+		statistics.postTransformBenchmarkShadeTimes.fill(0.0);
+	};
+	desc.sample = [this](uint32_t, uint32_t)
+	{
+		return SweepSample{ statistics.postTransformTime, forwardPassTime - statistics.postTransformTime, deferredPassTime };
+	};
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.postTransformBenchmarkTransformTimes[step] = averages[0];
+		statistics.postTransformBenchmarkWriteTimes[step] = averages[1];
+		statistics.postTransformBenchmarkShadeTimes[step] = averages[2];
+	};
+	sweeps[SWEEP_POST_TRANSFORM].Register(desc);
+}
+
+// Times the vis buff at each sample count the device supports from the same camera. The attachments and everything built
+// against them are recreated between steps, starting from the single sampled baseline.
+void VulkanApplication::RegisterMsaaSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(MSAA_SAMPLE_COUNTS.size());
+	desc.start = [this]()
+	{
+		msaaSweepRestoreSampleCount = visBuffSampleCount;
+		statistics.msaaSweepFrameTimes.fill(0.0);
+		statistics.msaaSweepForwardTimes.fill(0.0);
+		statistics.msaaSweepDeferredTimes.fill(0.0);
+		VkExtent2D extent = vulkan->Swapchain().Extent();
+		for (size_t i = 0; i < MSAA_SAMPLE_COUNTS.size(); i++)
+		{
+			VkDeviceSize idBytes = static_cast<VkDeviceSize>(extent.width) * extent.height * MSAA_SAMPLE_COUNTS[i] * sizeof(uint32_t);
+			statistics.msaaSweepAttachmentBytes[i] = VisBuffAttachmentBytes(static_cast<VkSampleCountFlagBits>(MSAA_SAMPLE_COUNTS[i]));
+			statistics.msaaSweepTrafficBytes[i] = statistics.msaaSweepAttachmentBytes[i] + idBytes;
+		}
+	};
+	desc.skip = [this](uint32_t step) { return !(statistics.msaaSupportedSampleCounts & MSAA_SAMPLE_COUNTS[step]); };
+	desc.apply = [this](uint32_t step)
+	{
+		VkSampleCountFlagBits sampleCount = static_cast<VkSampleCountFlagBits>(MSAA_SAMPLE_COUNTS[step]);
+		if (sampleCount != visBuffSampleCount)
+		{
+			visBuffSampleCount = sampleCount;
+			RecreateVisibilityBufferResources();
+		}
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ frameTime * 1000.0, forwardPassTime, deferredPassTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.msaaSweepFrameTimes[step] = averages[0];
+		statistics.msaaSweepForwardTimes[step] = averages[1];
+		statistics.msaaSweepDeferredTimes[step] = averages[2];
+	};
+	desc.finish = [this]()
+	{
+		if (msaaSweepRestoreSampleCount != visBuffSampleCount)
+		{
+			visBuffSampleCount = msaaSweepRestoreSampleCount;
+			RecreateVisibilityBufferResources();
+		}
+	};
+	sweeps[SWEEP_MSAA].Register(desc);
+}
+
+// Times the VRS deferred pass at each aggressiveness level from the same camera. After the timed frames of each level one more
+// frame also shades every reconstructed pixel at full rate, giving the error of that level without slowing the timed frames.
+void VulkanApplication::RegisterVrsSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(VRS_GRADIENT_THRESHOLDS.size());
+	desc.measureFrame = true;
+	desc.start = [this]()
+	{
+		statistics.vrsSweepDeferredTimes.fill(0.0);
+		statistics.vrsSweepShadedFractions.fill(0.0);
+		statistics.vrsSweepMeanSquaredErrors.fill(0.0);
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ deferredPassTime, (double)statistics.vrsShadedPixelCount }; };
+
+	// The measuring frame's error is read back once its fence has signalled
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		VkExtent2D extent = vulkan->Swapchain().Extent();
+		double screenPixels = (double)extent.width * extent.height;
+		const VrsCounters& counters = WaitForSubmittedCounters().vrs;
+		uint64_t squaredError = ((uint64_t)counters.squaredErrorHigh << 32) | counters.squaredErrorLow;
+		statistics.vrsSweepDeferredTimes[step] = averages[0];
+		statistics.vrsSweepShadedFractions[step] = averages[1] / screenPixels;
+		statistics.vrsSweepMeanSquaredErrors[step] = (double)squaredError / (screenPixels * 3.0);
+	};
+	sweeps[SWEEP_VRS].Register(desc);
+}
+
+// Measures the deferred pass sampling only the base level of the terrain texture and then its mip chain as the camera is pulled
+// back. Distant terrain minifies the texture, so the base level's fetches spread over more of it and miss the cache more often.
+// Even steps sample the base level, odd steps the mip chain.
+void VulkanApplication::RegisterTextureLodSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(TEXTURE_LOD_SWEEP_DISTANCES.size() * 2);
+	desc.start = [this]()
+	{
+		textureLodSweepOrigin = camera.Position();
+		textureLodSweepRestoreMips = useTextureMips;
+		statistics.textureLodSweepBaseLevelTimes.fill(0.0);
+		statistics.textureLodSweepMipmappedTimes.fill(0.0);
+	};
+	desc.apply = [this](uint32_t step)
+	{
+		useTextureMips = step % 2 == 1;
+		UpdateTextureDescriptors();
+		if (step % 2 == 0)
+			camera.SetPosition(textureLodSweepOrigin - camera.Forward() * TEXTURE_LOD_SWEEP_DISTANCES[step / 2]);
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ deferredPassTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		if (step % 2 == 1)
+			statistics.textureLodSweepMipmappedTimes[step / 2] = averages[0];
+		else
+			statistics.textureLodSweepBaseLevelTimes[step / 2] = averages[0];
+	};
+	desc.finish = [this]()
+	{
+		useTextureMips = textureLodSweepRestoreMips;
+		UpdateTextureDescriptors();
+		camera.SetPosition(textureLodSweepOrigin);
+	};
+	sweeps[SWEEP_TEXTURE_LOD].Register(desc);
+}
+
+// Times the temporal reuse deferred pass at each reuse budget while the camera pans, so every budget reprojects the same motion.
+// As with the VRS sweep, one more frame after the timed ones also shades the reused pixels to measure their error.
+void VulkanApplication::RegisterTemporalSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(TEMPORAL_REUSE_BUDGETS.size());
+	desc.measureFrame = true;
+	desc.start = [this]()
 	{
-		forwardPassTime = ((double)timestamps[1] - (double)timestamps[0]) / 1000000.0;
-		deferredPassTime = ((double)timestamps[3] - (double)timestamps[2]) / 1000000.0;
+		temporalSweepOrigin = camera.Rotation();
+		statistics.temporalSweepDeferredTimes.fill(0.0);
+		statistics.temporalSweepShadedFractions.fill(0.0);
+		statistics.temporalSweepMeanSquaredErrors.fill(0.0);
+	};
+
+	// Each budget pans from the original rotation, and the camera jumping back to it invalidates the history
+	desc.apply = [this](uint32_t)
+	{
+		camera.SetRotation(temporalSweepOrigin);
+		temporalHistoryValid = false;
+	};
+	desc.sample = [this](uint32_t, uint32_t frame)
+	{
+		camera.SetRotation(temporalSweepOrigin + glm::vec3(0.0f, TEMPORAL_SWEEP_PAN_RATE * (frame + 1), 0.0f));
+		return SweepSample{ deferredPassTime, (double)statistics.temporalShadedPixelCount };
+	};
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		VkExtent2D extent = vulkan->Swapchain().Extent();
+		double screenPixels = (double)extent.width * extent.height;
+		const TemporalCounters& counters = WaitForSubmittedCounters().temporal;
+		uint64_t squaredError = ((uint64_t)counters.squaredErrorHigh << 32) | counters.squaredErrorLow;
+		statistics.temporalSweepDeferredTimes[step] = averages[0];
+		statistics.temporalSweepShadedFractions[step] = averages[1] / screenPixels;
+		statistics.temporalSweepMeanSquaredErrors[step] = (double)squaredError / (screenPixels * 3.0);
+	};
+	desc.finish = [this]() { camera.SetRotation(temporalSweepOrigin); };
+	sweeps[SWEEP_TEMPORAL].Register(desc);
+}
+
+// Times frames with 1 to MAX_FRAMES_IN_FLIGHT frame contexts. The fence wait is the CPU stalled on the GPU, so the rest of the
+// frame time is CPU work, and the forward and deferred passes stand in for the GPU's share of it.
+void VulkanApplication::RegisterFramesInFlightSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(MAX_FRAMES_IN_FLIGHT);
+	desc.start = [this]()
+	{
+		framesInFlightRestore = framesInFlight;
+		statistics.framesInFlightSweepFrameTimes.fill(0.0);
+		statistics.framesInFlightSweepFenceWaits.fill(0.0);
+		statistics.framesInFlightSweepGpuTimes.fill(0.0);
+	};
+	desc.apply = [this](uint32_t step) { SetFramesInFlight(step + 1); };
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ frameTime * 1000.0, statistics.fenceWaitTime, forwardPassTime + deferredPassTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.framesInFlightSweepFrameTimes[step] = averages[0];
+		statistics.framesInFlightSweepFenceWaits[step] = averages[1];
+		statistics.framesInFlightSweepGpuTimes[step] = averages[2];
+	};
+	desc.finish = [this]() { SetFramesInFlight(framesInFlightRestore); };
+	sweeps[SWEEP_FRAMES_IN_FLIGHT].Register(desc);
+}
+
+// Times command recording and the CPU side of the frame while re-recording the scene every frame, then while replaying it.
+// Frames re-recording the scene still store what they recorded, so the cached step replays from its first frame.
+void VulkanApplication::RegisterRecordBenchmark()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(statistics.recordBenchmarkRecordTimes.size());
+	desc.start = [this]()
+	{
+		statistics.recordBenchmarkRecordTimes.fill(0.0);
+		statistics.recordBenchmarkCpuFrameTimes.fill(0.0);
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ statistics.commandRecordTime, statistics.cpuFrameTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.recordBenchmarkRecordTimes[step] = averages[0];
+		statistics.recordBenchmarkCpuFrameTimes[step] = averages[1];
+	};
+	sweeps[SWEEP_RECORD_BENCHMARK].Register(desc);
+}
+
+// Times command recording at each recording thread count and each number of indirect calls the material draws are split into.
+// The scene is re-recorded every frame of the sweep, with the material path forced on so the write subpass has draws to split.
+// Steps go through the draw call counts, then on to the next thread count after the last.
+void VulkanApplication::RegisterRecordSweep()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(RECORD_SWEEP_THREAD_COUNTS.size() * RECORD_SWEEP_DRAW_CALLS.size());
+	desc.stepFrames = SWEEP_STEP_FRAMES / 2; // Half the usual frames, as there's a step for every thread and draw call count
+	desc.start = [this]()
+	{
+		for (auto& times : statistics.recordSweepRecordTimes)
+			times.fill(0.0);
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ statistics.commandRecordTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		size_t drawCallCounts = RECORD_SWEEP_DRAW_CALLS.size();
+		statistics.recordSweepRecordTimes[step / drawCallCounts][step % drawCallCounts] = averages[0];
+	};
+	sweeps[SWEEP_RECORD].Register(desc);
+}
+
+// Times frames with the timestamp and statistics queries written and read back, then without them, to show measuring doesn't
+// change the frame time
+void VulkanApplication::RegisterTimingBenchmark()
+{
+	SweepDesc desc;
+	desc.stepCount = SCAST_U32(statistics.timingBenchmarkFrameTimes.size());
+	desc.stepFrames = SWEEP_STEP_FRAMES * 2; // Twice the usual frames, the difference being looked for is small
+	desc.start = [this]()
+	{
+		statistics.timingBenchmarkFrameTimes.fill(0.0);
+		statistics.timingBenchmarkCpuFrameTimes.fill(0.0);
+	};
+	desc.sample = [this](uint32_t, uint32_t) { return SweepSample{ frameTime * 1000.0, statistics.cpuFrameTime }; };
+	desc.report = [this](uint32_t step, const SweepSample& averages)
+	{
+		statistics.timingBenchmarkFrameTimes[step] = averages[0];
+		statistics.timingBenchmarkCpuFrameTimes[step] = averages[1];
+	};
+	sweeps[SWEEP_TIMING_BENCHMARK].Register(desc);
+}
+
+// Times the CPU side of a frame's uniform updates, mapping, copying into and unmapping a buffer per uniform as the buffers used to
+// be updated, against copying into a persistently mapped ring. Scratch buffers are used so no frame in flight sees the writes.
+void VulkanApplication::RunUniformUpdateBenchmark()
+{
+	DirectionalLightUBO lightUbo = light.UBOData();
+	std::array<Buffer, UNIFORM_REGION_COUNT> mappedBuffers;
+	mappedBuffers[UNIFORM_REGION_MVP].Create(sizeof(MVPUniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+	mappedBuffers[UNIFORM_REGION_SETTINGS].Create(sizeof(SettingsUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+	mappedBuffers[UNIFORM_REGION_LIGHT].Create(sizeof(DirectionalLightUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < UNIFORM_BENCHMARK_ITERATIONS; i++)
+	{
+		mappedBuffers[UNIFORM_REGION_MVP].MapData(&mvpUbo, allocator);
+		mappedBuffers[UNIFORM_REGION_SETTINGS].MapData(&renderSettingsUbo, allocator);
+		mappedBuffers[UNIFORM_REGION_LIGHT].MapData(&lightUbo, allocator);
+	}
+	statistics.uniformBenchmarkTimes[0] = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / UNIFORM_BENCHMARK_ITERATIONS;
+	for (Buffer& buffer : mappedBuffers)
+		buffer.CleanUp(allocator);
+
+	// Same regions and alignment as the frame ring, in a single slice
+	UniformRing ring;
+	std::vector<VkDeviceSize> regionSizes = { sizeof(MVPUniformBufferObject), sizeof(SettingsUBO), sizeof(DirectionalLightUBO) };
+	ring.Create(regionSizes, 1, vulkan->PhysDevice().MinUniformBufferOffsetAlignment(), allocator);
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < UNIFORM_BENCHMARK_ITERATIONS; i++)
+	{
+		ring.Write(0, UNIFORM_REGION_MVP, &mvpUbo);
+		ring.Write(0, UNIFORM_REGION_SETTINGS, &renderSettingsUbo);
+		ring.Write(0, UNIFORM_REGION_LIGHT, &lightUbo);
+		ring.FlushSlice(0, allocator);
 	}
+	statistics.uniformBenchmarkTimes[1] = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / UNIFORM_BENCHMARK_ITERATIONS;
+	ring.CleanUp(allocator);
+	statistics.uniformBenchmarkComplete = true;
 }
 #pragma endregion
 
@@ -343,16 +1184,22 @@ void VulkanApplication::SwitchPipeline(PipelineType type)
 {
 	if (currentPipeline != type)
 	{
-		// Command buffers are re-recorded every frame, so changing the local current pipeline will automatically bind the new pipeline and renderpass objects for the next frame. 
+		// Both pipelines' objects are built up front and the UI has its own render pass, so nothing in flight is touched. The
+		// pipeline is part of the scene record state, so each frame context re-records its cached scene the next time it's used.
+		auto switchStart = std::chrono::high_resolution_clock::now();
 		currentPipeline = type;
 
-		// Wait for current operations to be finished
-		vkDeviceWaitIdle(vulkan->Device());
-
+		// The old path, kept to compare against, waits for every frame in flight and then rebuilds ImGui as if it were tied to the
+		// pipeline's render pass
+		if (deviceIdleSwitch)
+		{
+			vkDeviceWaitIdle(vulkan->Device());
 #if IMGUI_ENABLED
-		// Need to reinitialise ImGui to be compatible with new renderpass
-		RecreateImGui(currentPipeline == VISIBILITYBUFFER ? visBuffRenderPass : tessRenderPass);
+			RecreateImGui();
 #endif
+		}
+		statistics.pipelineSwitchTimes[deviceIdleSwitch ? 1 : 0] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - switchStart).count();
+		pipelineSwitched = true;
 	}
 }
 #pragma endregion
@@ -368,21 +1215,67 @@ void VulkanApplication::RecreateSwapChain()
 		glfwWaitEvents();
 	}
 
-	// Wait for current operations to be finished
-	vkDeviceWaitIdle(vulkan->Device());
-
-	vulkan->Swapchain().CleanUpSwapChain(vulkan->Device());
-	CleanUpSwapChainResources();
+	// The old path, kept to compare against, waits for the device and then rebuilds the render passes, layouts and pipelines
+	// along with the size dependent objects
+	auto recreateStart = std::chrono::high_resolution_clock::now();
+	if (fullResize)
+	{
+		vkDeviceWaitIdle(vulkan->Device());
+		SwapChain oldSwapChain = vulkan->Swapchain();
+		vulkan->RecreateSwapchain(window);
+		oldSwapChain.CleanUpSwapChain(vulkan->Device());
+		RecreateVisibilityBufferResources();
+		statistics.resizeStallTimes[1] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recreateStart).count();
+		return;
+	}
 
-	// Recreate required objects
+	// Nothing is waited on. The old swapchain is handed to the new one, and it and the size dependent objects are retired until the
+	// frames already submitted have finished with them.
+	SwapChain oldSwapChain = vulkan->Swapchain();
 	vulkan->RecreateSwapchain(window);
-	CreateRenderPasses();
-	CreatePipelineCache();
-	CreatePipelineLayouts();
-	CreateWritePipelines();
-	CreateShadePipelines();
+	deletionQueue.Push(submittedFrameCount, [this, oldSwapChain]() mutable { oldSwapChain.CleanUpSwapChain(vulkan->Device()); });
+	RetireFrameBufferResources();
+
+	// Render passes only depend on the formats, which the surface doesn't change, and the viewport and scissor are dynamic, so the
+	// pipelines are kept. The descriptor sets reference the attachment views, so they're reallocated from a fresh pool.
+	CreateFrameBufferAttachments();
 	CreateFrameBuffers();
-	RecordCommandBuffers();
+	CreateDescriptorPool();
+	CreateShadePassDescriptorSets();
+	CreateWritePassDescriptorSet();
+	CreateTessWritePassDescriptorSet();
+	CreateTessFeedbackDescriptorSets();
+	CreateSwRasterDescriptorSet();
+	CreateTileShadeDescriptorSet();
+	temporalHistoryValid = false; // The history is laid out for the old extent
+	sceneResourceGeneration++; // The cached scene references the old frame buffers and descriptor sets
+	statistics.resizeStallTimes[0] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recreateStart).count();
+}
+
+// Hands the frame buffers, their attachments and the descriptor pool to the deletion queue, to be destroyed once every frame
+// submitted so far has finished
+void VulkanApplication::RetireFrameBufferResources()
+{
+	std::vector<VkFramebuffer> framebuffers = visBuffFramebuffers;
+	framebuffers.insert(framebuffers.end(), tessFramebuffers.begin(), tessFramebuffers.end());
+	framebuffers.insert(framebuffers.end(), uiFramebuffers.begin(), uiFramebuffers.end());
+	std::vector<Image> attachments = {
+		visibilityBuffer.visibility, visibilityBuffer.msaaVisibility, visibilityBuffer.msaaDepth,
+		tessVisibilityBuffer.visibility, tessVisibilityBuffer.tessCoords_v1XYZ_v2X, tessVisibilityBuffer.tessCoords_v2YZ_v3XY, tessVisibilityBuffer.tessCoords_v3Z,
+		depthImage, tileShadeOutput };
+	VkDescriptorPool retiredDescriptorPool = descriptorPool;
+	deletionQueue.Push(submittedFrameCount, [this, framebuffers, attachments, retiredDescriptorPool]() mutable
+	{
+		for (VkFramebuffer framebuffer : framebuffers)
+			vkDestroyFramebuffer(vulkan->Device(), framebuffer, nullptr);
+		for (Image& attachment : attachments)
+			attachment.CleanUp(allocator, vulkan->Device());
+		vkDestroyDescriptorPool(vulkan->Device(), retiredDescriptorPool, nullptr);
+	});
+
+	// The multisampled images are only recreated with MSAA on, so they're cleared rather than left holding the retired handles
+	visibilityBuffer.msaaVisibility = Image();
+	visibilityBuffer.msaaDepth = Image();
 }
 
 void VulkanApplication::CleanUpSwapChainResources()
@@ -392,40 +1285,275 @@ void VulkanApplication::CleanUpSwapChainResources()
 		vkDestroyFramebuffer(vulkan->Device(), visBuffFramebuffers[i], nullptr);
 	for (size_t i = 0; i < tessFramebuffers.size(); i++)
 		vkDestroyFramebuffer(vulkan->Device(), tessFramebuffers[i], nullptr);
+	for (size_t i = 0; i < uiFramebuffers.size(); i++)
+		vkDestroyFramebuffer(vulkan->Device(), uiFramebuffers[i], nullptr);
 
 	// Destroy visibility buffer images
 	visibilityBuffer.visibility.CleanUp(allocator, vulkan->Device());
+	visibilityBuffer.msaaVisibility.CleanUp(allocator, vulkan->Device());
+	visibilityBuffer.msaaDepth.CleanUp(allocator, vulkan->Device());
 	tessVisibilityBuffer.visibility.CleanUp(allocator, vulkan->Device());
 	tessVisibilityBuffer.tessCoords_v1XYZ_v2X.CleanUp(allocator, vulkan->Device());
 	tessVisibilityBuffer.tessCoords_v2YZ_v3XY.CleanUp(allocator, vulkan->Device());
 	tessVisibilityBuffer.tessCoords_v3Z.CleanUp(allocator, vulkan->Device());
 	depthImage.CleanUp(allocator, vulkan->Device());
+	tileShadeOutput.CleanUp(allocator, vulkan->Device());
 
-	// Free command buffers
-	vkFreeCommandBuffers(vulkan->Device(), commandPool, SCAST_U32(commandBuffers.size()), commandBuffers.data());
 	vkDestroyPipeline(vulkan->Device(), visBuffShadePipeline, nullptr);
 	vkDestroyPipeline(vulkan->Device(), visBuffWritePipeline, nullptr);
 	vkDestroyPipeline(vulkan->Device(), tessShadePipeline, nullptr);
 	vkDestroyPipeline(vulkan->Device(), tessWritePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessRecordShadePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessRecordWritePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessQuadShadePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessQuadWritePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessQuadRecordWritePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessDepthPrePassPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessQuadDepthPrePassPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessFeedbackCoveragePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessFeedbackResolvePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), swRasterBinPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), swRasterPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), swRasterMergePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tileClassifyPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tileShadeSkyPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tileShadeSinglePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tileShadeMultiPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tileCompositePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), vrsClassifyPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), vrsShadePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), temporalShadePipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), visBuffShadeCachedPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), triangleSetupPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), vertexTransformPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), visBuffWriteTransformedPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), visBuffShadeTransformedPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), visBuffShadeSubgroupPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), tessShadeSubgroupPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), visBuffShadeMsaaPipeline, nullptr);
+	visBuffShadeMsaaPipeline = VK_NULL_HANDLE; // Not recreated if the vis buff goes back to a single sample
+	vkDestroyPipeline(vulkan->Device(), materialCountPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), materialOffsetsPipeline, nullptr);
+	vkDestroyPipeline(vulkan->Device(), materialScatterPipeline, nullptr);
+	for (VkPipeline materialShadePipeline : materialShadePipelines)
+		vkDestroyPipeline(vulkan->Device(), materialShadePipeline, nullptr);
 	vkDestroyPipelineLayout(vulkan->Device(), visBuffShadePipelineLayout, nullptr);
 	vkDestroyPipelineLayout(vulkan->Device(), visBuffWritePipelineLayout, nullptr);
 	vkDestroyPipelineLayout(vulkan->Device(), tessShadePipelineLayout, nullptr);
 	vkDestroyPipelineLayout(vulkan->Device(), tessWritePipelineLayout, nullptr);
-	vkDestroyPipelineCache(vulkan->Device(), pipelineCache, nullptr);
+	vkDestroyPipelineLayout(vulkan->Device(), tessFeedbackPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(vulkan->Device(), swRasterPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(vulkan->Device(), tileShadePipelineLayout, nullptr);
 	vkDestroyRenderPass(vulkan->Device(), visBuffRenderPass, nullptr);
 	vkDestroyRenderPass(vulkan->Device(), tessRenderPass, nullptr);
+	vkDestroyRenderPass(vulkan->Device(), visBuffCompositeRenderPass, nullptr);
+	vkDestroyRenderPass(vulkan->Device(), visBuffResumeRenderPass, nullptr);
+	vkDestroyRenderPass(vulkan->Device(), uiRenderPass, nullptr);
+}
+
+// Rebuilds the attachments, pipelines and descriptor sets that depend on the visibility buffer format
+void VulkanApplication::RecreateVisibilityBufferResources()
+{
+	// Wait for current operations to be finished
+	vkDeviceWaitIdle(vulkan->Device());
+
+	CleanUpSwapChainResources();
+	vkDestroyDescriptorPool(vulkan->Device(), descriptorPool, nullptr);
+
+	// Recreate required objects
+	CreateFrameBufferAttachments();
+	CreateRenderPasses();
+	CreatePipelineLayouts();
+	auto rebuildStart = std::chrono::high_resolution_clock::now();
+	CreatePipelines();
+	statistics.pipelineRebuildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - rebuildStart).count();
+	CreateFrameBuffers();
+
+	// Descriptor sets reference the old attachment views, so reallocate them from a fresh pool
+	CreateDescriptorPool();
+	CreateShadePassDescriptorSets();
+	CreateWritePassDescriptorSet();
+	CreateTessWritePassDescriptorSet();
+	CreateTessFeedbackDescriptorSets();
+	CreateSwRasterDescriptorSet();
+	CreateTileShadeDescriptorSet();
+	resetTessFeedback = true;
+	temporalHistoryValid = false;
+	sceneResourceGeneration++;
+}
+
+// Highest sample count up to the requested one that the device supports for the visibility format
+VkSampleCountFlagBits VulkanApplication::SupportedVisBuffSampleCount(int requestedSamples, bool uintFormat)
+{
+	VkSampleCountFlags supportedSampleCounts = vulkan->PhysDevice().VisibilitySampleCounts(uintFormat);
+	int samples = requestedSamples;
+	while (samples > 1 && !(supportedSampleCounts & samples))
+		samples /= 2;
+	return samples > 1 ? static_cast<VkSampleCountFlagBits>(samples) : VK_SAMPLE_COUNT_1_BIT;
+}
+
+// Size of the vis buff visibility and depth attachments at a sample count, every sample stores an ID and a depth
+VkDeviceSize VulkanApplication::VisBuffAttachmentBytes(VkSampleCountFlagBits samples)
+{
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	VkDeviceSize depthBytes = depthImage.Format() == VK_FORMAT_D32_SFLOAT_S8_UINT ? 8 : 4; // The stencil is counted as padding the depth out to 8 bytes
+	return static_cast<VkDeviceSize>(extent.width) * extent.height * samples * (sizeof(uint32_t) + depthBytes);
 }
 #pragma endregion
 
 #pragma region Graphics Pipeline Functions
+// The cache lives for the whole run, so pipelines rebuilt for a new visibility buffer format are found in it too. It starts from
+// the file written by the last run when that was written by the same device and driver from the same shaders.
 void VulkanApplication::CreatePipelineCache()
 {
+	// Every .spv is read to hash it, so it's done once here and reused when the cache is saved
+	shaderContentHash = ShaderContentHash();
+
+	std::vector<char> cacheData;
+	std::ifstream file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+	if (file.is_open())
+	{
+		cacheData.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(cacheData.data(), cacheData.size());
+		file.close();
+	}
+	bool warm = ValidPipelineCacheData(cacheData);
+
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
 	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if (warm)
+	{
+		pipelineCacheCreateInfo.initialDataSize = cacheData.size() - sizeof(PipelineCacheFileHeader);
+		pipelineCacheCreateInfo.pInitialData = cacheData.data() + sizeof(PipelineCacheFileHeader);
+	}
 	if (vkCreatePipelineCache(vulkan->Device(), &pipelineCacheCreateInfo, nullptr, &pipelineCache) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create pipeline cache");
 	}
+	statistics.pipelineCacheWarm = warm;
+	statistics.pipelineCacheLoadedBytes = warm ? pipelineCacheCreateInfo.initialDataSize : 0;
+}
+
+// Rebuilds every pipeline from an empty cache, as a run without the cache file would, then from the run's cache. Startup only
+// differs in the pipeline build, so each startup time is this run's with its build swapped for the measured one.
+void VulkanApplication::RunPipelineCacheBenchmark()
+{
+	VkPipelineCache runCache = pipelineCache;
+	VkPipelineCacheCreateInfo emptyCacheCreateInfo = {};
+	emptyCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if (vkCreatePipelineCache(vulkan->Device(), &emptyCacheCreateInfo, nullptr, &pipelineCache) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline cache");
+	}
+	RecreateVisibilityBufferResources();
+	statistics.pipelineCacheBenchmarkTimes[0] = statistics.pipelineRebuildTime;
+
+	// Pipelines don't reference the cache they were built from, so the empty one can go before they do
+	vkDestroyPipelineCache(vulkan->Device(), pipelineCache, nullptr);
+	pipelineCache = runCache;
+	RecreateVisibilityBufferResources();
+	statistics.pipelineCacheBenchmarkTimes[1] = statistics.pipelineRebuildTime;
+
+	for (size_t i = 0; i < statistics.pipelineCacheStartupTimes.size(); i++)
+		statistics.pipelineCacheStartupTimes[i] = statistics.startupTime - startupPipelineBuildTime + statistics.pipelineCacheBenchmarkTimes[i];
+	statistics.pipelineCacheBenchmarkComplete = true;
+}
+
+// Writes the cache behind a PipelineCacheFileHeader. It's written to a temporary
+// file that then replaces the old one, so a run that dies part way through never leaves a truncated cache behind. Failing to
+// write it only costs the next run its warm start, so errors are ignored.
+void VulkanApplication::SavePipelineCache()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(vulkan->Device(), pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+		return;
+	std::vector<char> data(dataSize);
+	if (vkGetPipelineCacheData(vulkan->Device(), pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+		return;
+
+	PipelineCacheFileHeader header = { PIPELINE_CACHE_FILE_MAGIC, PIPELINE_CACHE_FILE_VERSION, shaderContentHash, dataSize };
+	std::string tempPath = PIPELINE_CACHE_PATH + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(data.data(), dataSize);
+		if (!file.good())
+			return;
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+	if (error)
+		std::filesystem::remove(tempPath, error);
+}
+
+// Checks the file header, then the Vulkan cache header against this device. Drivers should reject foreign data themselves, but not
+// all do, and a cache compiled from old shaders would only fill up with entries that are never hit.
+bool VulkanApplication::ValidPipelineCacheData(const std::vector<char>& data)
+{
+	const size_t vulkanHeaderSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+	if (data.size() < sizeof(PipelineCacheFileHeader) + vulkanHeaderSize)
+		return false;
+
+	PipelineCacheFileHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != PIPELINE_CACHE_FILE_MAGIC || header.version != PIPELINE_CACHE_FILE_VERSION || header.dataSize != data.size() - sizeof(header) || header.shaderHash != shaderContentHash)
+		return false;
+
+	// Header size, header version, vendor ID and device ID, then the cache UUID
+	const char* vulkanHeader = data.data() + sizeof(header);
+	std::array<uint32_t, 4> vulkanFields;
+	std::memcpy(vulkanFields.data(), vulkanHeader, sizeof(vulkanFields));
+	VkPhysicalDeviceProperties properties = vulkan->PhysDevice().Properties();
+	return vulkanFields[0] >= vulkanHeaderSize && vulkanFields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		vulkanFields[2] == properties.vendorID && vulkanFields[3] == properties.deviceID &&
+		std::memcmp(vulkanHeader + sizeof(vulkanFields), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+// FNV-1a over the name and contents of every compiled shader, in name order so the hash doesn't depend on the directory order
+uint64_t VulkanApplication::ShaderContentHash()
+{
+	std::vector<std::filesystem::path> shaderPaths;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("shaders", error))
+	{
+		if (entry.path().extension() == ".spv")
+			shaderPaths.push_back(entry.path());
+	}
+	std::sort(shaderPaths.begin(), shaderPaths.end());
+
+	uint64_t hash = 14695981039346656037ull;
+	auto hashBytes = [&hash](const char* bytes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			hash ^= static_cast<uint8_t>(bytes[i]);
+			hash *= 1099511628211ull;
+		}
+	};
+	for (const std::filesystem::path& path : shaderPaths)
+	{
+		std::string name = path.filename().string();
+		hashBytes(name.data(), name.size());
+		std::vector<char> code = ReadFile(path.string());
+		hashBytes(code.data(), code.size());
+	}
+	return hash;
+}
+
+// Describes every pipeline then compiles them together on the record threads
+void VulkanApplication::CreatePipelines()
+{
+	pipelineBatch.Begin(vulkan->Device(), pipelineCache);
+	CreateWritePipelines();
+	CreateShadePipelines();
+	CreateComputePipelines();
+	pipelineBatch.Build(recordThreadPool);
+	statistics.pipelineCount = pipelineBatch.PipelineCount();
+	statistics.pipelineBuildThreads = pipelineBatch.ThreadCount();
+	statistics.pipelineBuildTime = pipelineBatch.BuildTime();
 }
 
 // Creation of the graphics pipeline requires four objects:
@@ -435,15 +1563,9 @@ void VulkanApplication::CreatePipelineCache()
 // Render pass: the attachments referenced by the pipeline stages and their usage
 void VulkanApplication::CreateShadePipelines()
 {
-	// Create vis buff shade shader stages from compiled shader code
-	auto vertShaderCode = ReadFile("shaders/visbuffshade.vert.spv");
-	auto fragShaderCode = ReadFile("shaders/visbuffshade.frag.spv");
-
-	// Create shader modules
-	VkShaderModule vertShaderModule;
-	VkShaderModule fragShaderModule;
-	vertShaderModule = CreateShaderModule(vertShaderCode);
-	fragShaderModule = CreateShaderModule(fragShaderCode);
+	// Create vis buff shade shader modules from compiled shader code
+	VkShaderModule vertShaderModule = pipelineBatch.ShaderModule("shaders/visbuffshade.vert.spv");
+	VkShaderModule fragShaderModule = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffshade", "frag"));
 
 	// Create shader stages
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {}; // Vertex
@@ -539,25 +1661,55 @@ void VulkanApplication::CreateShadePipelines()
 	// Empty vertex input state, fullscreen triangle is generated by the vertex shader
 	VkPipelineVertexInputStateCreateInfo emptyInputState = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
 	pipelineInfo.pVertexInputState = &emptyInputState;
-	if (vkCreateGraphicsPipelines(vulkan->Device(), pipelineCache, 1, &pipelineInfo, nullptr, &visBuffShadePipeline) != VK_SUCCESS)
+	pipelineBatch.AddGraphics(pipelineInfo, &visBuffShadePipeline, "vis buff shade");
+
+	// Cached vis buff shade pipeline, evaluates the attribute planes written by the triangle setup pass
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffshadecached", "frag"));
+	shaderStages[1] = fragShaderStageInfo;
+	pipelineBatch.AddGraphics(pipelineInfo, &visBuffShadeCachedPipeline, "cached vis buff shade");
+
+	// Post-transform vis buff shade pipeline, reads the vertices transformed by the vertex transform pass
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffshadetransformed", "frag"));
+	shaderStages[1] = fragShaderStageInfo;
+	pipelineBatch.AddGraphics(pipelineInfo, &visBuffShadeTransformedPipeline, "post-transform vis buff shade");
+
+	// Subgroup fetch vis buff shade pipeline, shares each triangle fetch between the lanes of a subgroup. Left null on devices
+	// without the subgroup operations it needs.
+	if (subgroupFetchSupported)
+	{
+		fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffshadesubgroup", "frag"));
+		shaderStages[1] = fragShaderStageInfo;
+		pipelineBatch.AddGraphics(pipelineInfo, &visBuffShadeSubgroupPipeline, "subgroup fetch vis buff shade");
+	}
+
+	// MSAA vis buff shade pipeline, shades each distinct triangle in a pixel's samples once and weights it by coverage. The
+	// shader is specialised on the sample count, so it's only created when the vis buff is multisampled.
+	if (visBuffSampleCount != VK_SAMPLE_COUNT_1_BIT)
 	{
-		throw std::runtime_error("Failed to create vis buff shade pipeline");
+		int32_t sampleCount = static_cast<int32_t>(visBuffSampleCount);
+		VkSpecializationMapEntry specialisationEntry = { 0, 0, sizeof(int32_t) };
+		VkSpecializationInfo specialisationInfo = {};
+		specialisationInfo.mapEntryCount = 1;
+		specialisationInfo.pMapEntries = &specialisationEntry;
+		specialisationInfo.dataSize = sizeof(sampleCount);
+		specialisationInfo.pData = &sampleCount;
+		fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffshademsaa", "frag"));
+		fragShaderStageInfo.pSpecializationInfo = &specialisationInfo;
+		shaderStages[1] = fragShaderStageInfo;
+		pipelineBatch.AddGraphics(pipelineInfo, &visBuffShadeMsaaPipeline, "MSAA vis buff shade");
+		fragShaderStageInfo.pSpecializationInfo = nullptr;
 	}
 
-	// Clean up shader module objects
-	vkDestroyShaderModule(vulkan->Device(), vertShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), fragShaderModule, nullptr);
+	// Tile shade composite pipeline, copies the compute shaded image in the shade subpass of the compatible composite render pass
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule("shaders/tilecomposite.frag.spv");
+	shaderStages[1] = fragShaderStageInfo;
+	pipelineInfo.layout = tileShadePipelineLayout;
+	pipelineBatch.AddGraphics(pipelineInfo, &tileCompositePipeline, "tile shade composite");
 
 	// Tessellation shade pipeline
 	// Create shader stages
-	vertShaderCode = ReadFile("shaders/tessshade.vert.spv");
-	fragShaderCode = ReadFile("shaders/tessshade.frag.spv");
-	VkShaderModule tessVertShaderModule;
-	VkShaderModule tessFragShaderModule;
-	tessVertShaderModule = CreateShaderModule(vertShaderCode);
-	tessFragShaderModule = CreateShaderModule(fragShaderCode);
-	vertShaderStageInfo.module = tessVertShaderModule;
-	fragShaderStageInfo.module = tessFragShaderModule;
+	vertShaderStageInfo.module = pipelineBatch.ShaderModule("shaders/tessshade.vert.spv");
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("tessshade", "frag"));
 	shaderStages[0] = vertShaderStageInfo;
 	shaderStages[1] = fragShaderStageInfo;
 
@@ -565,27 +1717,33 @@ void VulkanApplication::CreateShadePipelines()
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.layout = tessShadePipelineLayout;
 	pipelineInfo.renderPass = tessRenderPass;
-	if (vkCreateGraphicsPipelines(vulkan->Device(), pipelineCache, 1, &pipelineInfo, nullptr, &tessShadePipeline) != VK_SUCCESS)
+	pipelineBatch.AddGraphics(pipelineInfo, &tessShadePipeline, "tess shade");
+
+	// Subgroup fetch tess shade pipeline, shares each patch's control point fetch between the lanes of a subgroup
+	if (subgroupFetchSupported)
 	{
-		throw std::runtime_error("Failed to create tess shade pipeline");
+		fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("tessshadesubgroup", "frag"));
+		shaderStages[1] = fragShaderStageInfo;
+		pipelineBatch.AddGraphics(pipelineInfo, &tessShadeSubgroupPipeline, "subgroup fetch tess shade");
 	}
 
-	// Clean up shader module objects
-	vkDestroyShaderModule(vulkan->Device(), tessVertShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), tessFragShaderModule, nullptr);
+	// Triangle record shade pipeline, same as the tess shade pipeline but reads displaced triangles from the record buffer
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("tessrecordshade", "frag"));
+	shaderStages[1] = fragShaderStageInfo;
+	pipelineBatch.AddGraphics(pipelineInfo, &tessRecordShadePipeline, "tess record shade");
+
+	// Quad patch shade pipeline, reconstructs the tessellated triangle from the four quad control points
+	fragShaderStageInfo.module = pipelineBatch.ShaderModule(VisibilityShaderPath("tessquadshade", "frag"));
+	shaderStages[1] = fragShaderStageInfo;
+	pipelineBatch.AddGraphics(pipelineInfo, &tessQuadShadePipeline, "tess quad shade");
 }
 
 void VulkanApplication::CreateWritePipelines()
 {
-	// Create visibility buffer write shader stages from compiled shader code
-	auto vertShaderCode = ReadFile("shaders/visbuffwrite.vert.spv");
-	auto fragShaderCode = ReadFile("shaders/visbuffwrite.frag.spv");
-
-	// Create shader modules
-	VkShaderModule vertShaderModule;
-	VkShaderModule fragShaderModule;
-	vertShaderModule = CreateShaderModule(vertShaderCode);
-	fragShaderModule = CreateShaderModule(fragShaderCode);
+	// Create visibility buffer write shader modules from compiled shader code
+	// Without draw parameters every fragment writes the pushed draw offset, which is only ever zero as material binning is off
+	VkShaderModule vertShaderModule = pipelineBatch.ShaderModule(drawParametersSupported ? "shaders/visbuffwrite.vert.spv" : "shaders/visbuffwrite.nodrawparams.vert.spv");
+	VkShaderModule fragShaderModule = pipelineBatch.ShaderModule(VisibilityShaderPath("visbuffwrite", "frag"));
 
 	// Create shader stages
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo = {}; // Vertex
@@ -644,11 +1802,12 @@ void VulkanApplication::CreateWritePipelines()
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
 	depthStencil.stencilTestEnable = VK_FALSE;
 
-	// Set up multisampling (disabled)
+	// Set up multisampling, the vis buff write subpass has the sample count of its attachments. There's no sample shading, the
+	// per-sample IDs come from coverage alone.
 	VkPipelineMultisampleStateCreateInfo multisampling = {};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.rasterizationSamples = visBuffSampleCount;
 
 	// We need to set up color blend attachments for all of the visibility buffer color attachments in the subpass
 	VkPipelineColorBlendAttachmentState emptyBlendAttachment = {};
@@ -689,33 +1848,47 @@ void VulkanApplication::CreateWritePipelines()
 	pipelineInfo.basePipelineIndex = -1;
 
 	// Now create the vis buff write pass pipeline
-	if (vkCreateGraphicsPipelines(vulkan->Device(), pipelineCache, 1, &pipelineInfo, nullptr, &visBuffWritePipeline) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create vis buff write pipeline");
-	}
-
-	// Clean up shader module objects
-	vkDestroyShaderModule(vulkan->Device(), vertShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), fragShaderModule, nullptr);
-
-	// Create visibility buffer tessellation write shader stages
-	vertShaderCode = ReadFile("shaders/tesswrite.vert.spv");
-	auto hullShaderCode = ReadFile("shaders/tesswrite.tesc.spv");
-	auto domainShaderCode = ReadFile("shaders/tesswrite.tese.spv");
-	auto geomShaderCode = ReadFile("shaders/tesswrite.geom.spv");
-	fragShaderCode = ReadFile("shaders/tesswrite.frag.spv");
-
-	// Create shader modules
-	VkShaderModule tessVertShaderModule;
-	VkShaderModule hullShaderModule;
-	VkShaderModule domainShaderModule;
-	VkShaderModule geometryShaderModule;
-	VkShaderModule tessFragShaderModule;
-	tessVertShaderModule = CreateShaderModule(vertShaderCode);
-	hullShaderModule = CreateShaderModule(hullShaderCode);
-	domainShaderModule = CreateShaderModule(domainShaderCode);
-	geometryShaderModule = CreateShaderModule(geomShaderCode);
-	tessFragShaderModule = CreateShaderModule(fragShaderCode);
+	pipelineBatch.AddGraphics(pipelineInfo, &visBuffWritePipeline, "vis buff write");
+
+	// Post-transform write pipeline, clip positions are fetched from the transformed vertex buffer so there's no vertex input
+	visBuffWriteShaderStages[0].module = pipelineBatch.ShaderModule(drawParametersSupported ? "shaders/visbuffwritetransformed.vert.spv" : "shaders/visbuffwritetransformed.nodrawparams.vert.spv");
+	VkPipelineVertexInputStateCreateInfo transformedInputState = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+	pipelineInfo.pVertexInputState = &transformedInputState;
+	pipelineBatch.AddGraphics(pipelineInfo, &visBuffWriteTransformedPipeline, "post-transform vis buff write");
+	visBuffWriteShaderStages[0].module = vertShaderModule;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+
+	// Software raster merge, a fullscreen triangle that copies the compute rasterised pixels into the attachments
+	VkPipelineShaderStageCreateInfo mergeShaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+	mergeShaderStages[0].module = pipelineBatch.ShaderModule("shaders/visbuffshade.vert.spv");
+	mergeShaderStages[1].module = pipelineBatch.ShaderModule(VisibilityShaderPath("swrastermerge", "frag"));
+
+	// No vertex input, no culling and the depth is written unconditionally from the fragment shader
+	VkPipelineVertexInputStateCreateInfo emptyVertexInputInfo = {};
+	emptyVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	VkPipelineRasterizationStateCreateInfo mergeRasterizer = rasterizer;
+	mergeRasterizer.cullMode = VK_CULL_MODE_NONE;
+	VkPipelineDepthStencilStateCreateInfo mergeDepthStencil = depthStencil;
+	mergeDepthStencil.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+
+	pipelineInfo.pStages = mergeShaderStages;
+	pipelineInfo.pVertexInputState = &emptyVertexInputInfo;
+	pipelineInfo.pRasterizationState = &mergeRasterizer;
+	pipelineInfo.pDepthStencilState = &mergeDepthStencil;
+	pipelineInfo.layout = swRasterPipelineLayout;
+	pipelineBatch.AddGraphics(pipelineInfo, &swRasterMergePipeline, "software raster merge");
+
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT; // The tessellation attachments are always single sampled
+
+	// Create visibility buffer tessellation write shader modules
+	VkShaderModule tessVertShaderModule = pipelineBatch.ShaderModule("shaders/tesswrite.vert.spv");
+	VkShaderModule hullShaderModule = pipelineBatch.ShaderModule("shaders/tesswrite.tesc.spv");
+	VkShaderModule domainShaderModule = pipelineBatch.ShaderModule("shaders/tesswrite.tese.spv");
+	VkShaderModule geometryShaderModule = pipelineBatch.ShaderModule("shaders/tesswrite.geom.spv");
+	VkShaderModule tessFragShaderModule = pipelineBatch.ShaderModule(VisibilityShaderPath("tesswrite", "frag"));
 
 	// Create shader stages
 	vertShaderStageInfo.module = tessVertShaderModule; // Vert
@@ -756,28 +1929,162 @@ void VulkanApplication::CreateWritePipelines()
 	pipelineInfo.pStages = tessWriteShaderStages;
 	pipelineInfo.stageCount = 5;
 	pipelineInfo.pTessellationState = &tessStateInfo;
-	if (vkCreateGraphicsPipelines(vulkan->Device(), pipelineCache, 1, &pipelineInfo, nullptr, &tessWritePipeline) != VK_SUCCESS)
+	pipelineBatch.AddGraphics(pipelineInfo, &tessWritePipeline, "tess write");
+
+	// Triangle record write pipeline, the geometry stage appends each displaced triangle to a storage buffer
+	VkShaderModule recordGeometryShaderModule = pipelineBatch.ShaderModule("shaders/tessrecordwrite.geom.spv");
+	VkShaderModule recordFragShaderModule = pipelineBatch.ShaderModule(VisibilityShaderPath("tessrecordwrite", "frag"));
+	tessWriteShaderStages[3].module = recordGeometryShaderModule;
+	tessWriteShaderStages[4].module = recordFragShaderModule;
+
+	// Only the swapchain and visibility attachments are written, tess coords attachments are left untouched
+	VkPipelineColorBlendAttachmentState maskedBlendAttachment = emptyBlendAttachment;
+	maskedBlendAttachment.colorWriteMask = 0;
+	std::array<VkPipelineColorBlendAttachmentState, 5> tessRecordBlendAttachments = { emptyBlendAttachment, emptyBlendAttachment, maskedBlendAttachment, maskedBlendAttachment, maskedBlendAttachment };
+	colourBlending.pAttachments = tessRecordBlendAttachments.data();
+	tessRecordWritePipeline = VK_NULL_HANDLE;
+	tessQuadRecordWritePipeline = VK_NULL_HANDLE;
+	if (tessRecordsSupported)
+		pipelineBatch.AddGraphics(pipelineInfo, &tessRecordWritePipeline, "tess record write");
+
+	// Quad patch write pipelines, same vertex and geometry stages with the quad domain control and evaluation stages
+	tessWriteShaderStages[1].module = pipelineBatch.ShaderModule("shaders/tessquadwrite.tesc.spv");
+	tessWriteShaderStages[2].module = pipelineBatch.ShaderModule("shaders/tessquadwrite.tese.spv");
+	tessWriteShaderStages[3].module = geometryShaderModule;
+	tessWriteShaderStages[4].module = pipelineBatch.ShaderModule(VisibilityShaderPath("tessquadwrite", "frag"));
+	tessStateInfo.patchControlPoints = 4;
+
+	// Quad domain coordinates only need two floats per vertex, so the third tess coords attachment is not written
+	std::array<VkPipelineColorBlendAttachmentState, 5> tessQuadBlendAttachments = { emptyBlendAttachment, emptyBlendAttachment, emptyBlendAttachment, emptyBlendAttachment, maskedBlendAttachment };
+	colourBlending.pAttachments = tessQuadBlendAttachments.data();
+	pipelineBatch.AddGraphics(pipelineInfo, &tessQuadWritePipeline, "tess quad write");
+
+	// Quad patch triangle record pipeline
+	tessWriteShaderStages[3].module = recordGeometryShaderModule;
+	tessWriteShaderStages[4].module = recordFragShaderModule;
+	colourBlending.pAttachments = tessRecordBlendAttachments.data();
+	if (tessRecordsSupported)
+		pipelineBatch.AddGraphics(pipelineInfo, &tessQuadRecordWritePipeline, "tess quad record write");
+
+	// Depth pre-pass pipelines, the same stages up to the geometry stage with no fragment stage or colour writes.
+	// The write pipelines already test with less or equal, so after the pre-pass only the visible fragment of each pixel passes
+	std::array<VkPipelineColorBlendAttachmentState, 5> depthOnlyBlendAttachments = { maskedBlendAttachment, maskedBlendAttachment, maskedBlendAttachment, maskedBlendAttachment, maskedBlendAttachment };
+	colourBlending.pAttachments = depthOnlyBlendAttachments.data();
+	tessWriteShaderStages[3].module = geometryShaderModule;
+	pipelineInfo.stageCount = 4;
+	pipelineBatch.AddGraphics(pipelineInfo, &tessQuadDepthPrePassPipeline, "tess quad depth pre-pass");
+	tessWriteShaderStages[1].module = hullShaderModule;
+	tessWriteShaderStages[2].module = domainShaderModule;
+	tessStateInfo.patchControlPoints = 3;
+	pipelineBatch.AddGraphics(pipelineInfo, &tessDepthPrePassPipeline, "tess depth pre-pass");
+}
+
+void VulkanApplication::CreateComputePipelines()
+{
+	// Tess factor feedback, a coverage histogram of the visibility buffer followed by a per patch factor resolve
+	VkShaderModule coverageShaderModule = pipelineBatch.ShaderModule(VisibilityShaderPath("tessfeedbackcoverage", "comp"));
+	VkShaderModule resolveShaderModule = pipelineBatch.ShaderModule("shaders/tessfeedbackresolve.comp.spv");
+
+	// Create shader stage
+	VkPipelineShaderStageCreateInfo compShaderStageInfo = {};
+	compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compShaderStageInfo.module = coverageShaderModule;
+	compShaderStageInfo.pName = "main";
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = compShaderStageInfo;
+	pipelineInfo.layout = tessFeedbackPipelineLayout;
+	pipelineBatch.AddCompute(pipelineInfo, &tessFeedbackCoveragePipeline, "tess feedback coverage");
+
+	pipelineInfo.stage.module = resolveShaderModule;
+	pipelineBatch.AddCompute(pipelineInfo, &tessFeedbackResolvePipeline, "tess feedback resolve");
+
+	// Software rasteriser, small triangle binning followed by the raster pass. Uses 64 bit atomics when available.
+	pipelineInfo.layout = swRasterPipelineLayout;
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule("shaders/swrasterbin.comp.spv");
+	pipelineBatch.AddCompute(pipelineInfo, &swRasterBinPipeline, "software raster bin");
+
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule(swRasterInt64 ? "shaders/swraster.comp.spv" : "shaders/swraster.fallback.comp.spv");
+	pipelineBatch.AddCompute(pipelineInfo, &swRasterPipeline, "software raster");
+
+	// Tile classified shading, a classify pass followed by a kernel per tile class. Sky tiles never read the visibility buffer.
+	std::array<std::string, 4> tileShaderPaths = { VisibilityShaderPath("tileclassify", "comp"), "shaders/tileshadesky.comp.spv", VisibilityShaderPath("tileshadesingle", "comp"), VisibilityShaderPath("tileshademulti", "comp") };
+	std::array<VkPipeline*, 4> tilePipelines = { &tileClassifyPipeline, &tileShadeSkyPipeline, &tileShadeSinglePipeline, &tileShadeMultiPipeline };
+	pipelineInfo.layout = tileShadePipelineLayout;
+	for (size_t i = 0; i < tileShaderPaths.size(); i++)
+	{
+		pipelineInfo.stage.module = pipelineBatch.ShaderModule(tileShaderPaths[i]);
+		pipelineBatch.AddCompute(pipelineInfo, tilePipelines[i], "tile shade");
+	}
+
+	// Variable rate shading, a classify pass picking each tile's rate followed by a single kernel shading every tile at its rate
+	std::array<std::string, 2> vrsShaderPaths = { VisibilityShaderPath("vrsclassify", "comp"), VisibilityShaderPath("vrsshade", "comp") };
+	std::array<VkPipeline*, 2> vrsPipelines = { &vrsClassifyPipeline, &vrsShadePipeline };
+	for (size_t i = 0; i < vrsShaderPaths.size(); i++)
+	{
+		pipelineInfo.stage.module = pipelineBatch.ShaderModule(vrsShaderPaths[i]);
+		pipelineBatch.AddCompute(pipelineInfo, vrsPipelines[i], "VRS");
+	}
+
+	// Temporal reuse, reprojecting into last frame's history and shading only what it can't reuse
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule(VisibilityShaderPath("temporalshade", "comp"));
+	pipelineBatch.AddCompute(pipelineInfo, &temporalShadePipeline, "temporal reuse");
+
+	// Material binning, count, offset and scatter passes sharing the tile shade layout
+	std::array<std::string, 3> materialBinShaderPaths = { VisibilityShaderPath("materialcount", "comp"), "shaders/materialoffsets.comp.spv", VisibilityShaderPath("materialscatter", "comp") };
+	std::array<VkPipeline*, 3> materialBinPipelines = { &materialCountPipeline, &materialOffsetsPipeline, &materialScatterPipeline };
+	for (size_t i = 0; i < materialBinShaderPaths.size(); i++)
+	{
+		pipelineInfo.stage.module = pipelineBatch.ShaderModule(materialBinShaderPaths[i]);
+		pipelineBatch.AddCompute(pipelineInfo, materialBinPipelines[i], "material binning");
+	}
+
+	// One shading kernel per bin, specialised on the bin and its material's shading model so no invocation branches on material
+	std::array<VkSpecializationMapEntry, 2> specialisationEntries = {};
+	specialisationEntries[0].constantID = 0;
+	specialisationEntries[0].offset = 0;
+	specialisationEntries[0].size = sizeof(uint32_t);
+	specialisationEntries[1].constantID = 1;
+	specialisationEntries[1].offset = sizeof(uint32_t);
+	specialisationEntries[1].size = sizeof(uint32_t);
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule("shaders/materialshade.comp.spv");
+	for (uint32_t i = 0; i < MATERIAL_BIN_COUNT; i++)
 	{
-		throw std::runtime_error("Failed to create tess write pipeline");
+		std::array<uint32_t, 2> specialisationData = { i, i > 0 ? SCENE_MATERIALS[i - 1].model : 0 };
+		VkSpecializationInfo specialisationInfo = {};
+		specialisationInfo.mapEntryCount = SCAST_U32(specialisationEntries.size());
+		specialisationInfo.pMapEntries = specialisationEntries.data();
+		specialisationInfo.dataSize = sizeof(specialisationData);
+		specialisationInfo.pData = specialisationData.data();
+		pipelineInfo.stage.pSpecializationInfo = &specialisationInfo;
+		pipelineBatch.AddCompute(pipelineInfo, &materialShadePipelines[i], "material shade");
 	}
+	pipelineInfo.stage.pSpecializationInfo = nullptr;
 
-	// Clean up shader module objects
-	vkDestroyShaderModule(vulkan->Device(), tessVertShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), hullShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), domainShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), geometryShaderModule, nullptr);
-	vkDestroyShaderModule(vulkan->Device(), tessFragShaderModule, nullptr);
+	// Triangle setup pass, also sharing the tile shade layout
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule(VisibilityShaderPath("trianglesetup", "comp"));
+	pipelineBatch.AddCompute(pipelineInfo, &triangleSetupPipeline, "triangle setup");
+
+	// Vertex transform pass for the post-transform buffer
+	pipelineInfo.stage.module = pipelineBatch.ShaderModule("shaders/vertextransform.comp.spv");
+	pipelineBatch.AddCompute(pipelineInfo, &vertexTransformPipeline, "vertex transform");
 }
 
 void VulkanApplication::CreatePipelineLayouts()
 {
-	// Vis Buff write layout
+	// Vis Buff write layout, its push constant offsets the draw ID of the material draws when they're split across several calls
+	VkPushConstantRange writePushConstantRange = {};
+	writePushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	writePushConstantRange.offset = 0;
+	writePushConstantRange.size = sizeof(WritePushConstants);
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = 1;
 	pipelineLayoutInfo.pSetLayouts = &visBuffWritePassDescSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &writePushConstantRange;
 	pipelineLayoutInfo.pNext = nullptr;
 	pipelineLayoutInfo.flags = 0;
 	if (vkCreatePipelineLayout(vulkan->Device(), &pipelineLayoutInfo, nullptr, &visBuffWritePipelineLayout) != VK_SUCCESS)
@@ -786,6 +2093,8 @@ void VulkanApplication::CreatePipelineLayouts()
 	}
 
 	// Vis Buff Shade Layout
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
 	pipelineLayoutInfo.pSetLayouts = &visBuffShadePassDescSetLayout;
 	if (vkCreatePipelineLayout(vulkan->Device(), &pipelineLayoutInfo, nullptr, &visBuffShadePipelineLayout) != VK_SUCCESS)
 	{
@@ -805,18 +2114,69 @@ void VulkanApplication::CreatePipelineLayouts()
 	{
 		throw std::runtime_error("Failed to create vis buff tess shade pipeline layout");
 	}
+
+	// Tess factor feedback compute layout
+	pipelineLayoutInfo.pSetLayouts = &tessFeedbackDescSetLayout;
+	if (vkCreatePipelineLayout(vulkan->Device(), &pipelineLayoutInfo, nullptr, &tessFeedbackPipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create tess feedback pipeline layout");
+	}
+
+	// Tile shade layout, shared by the compute passes and the composite draw. Only the VRS and temporal reuse passes use its push
+	// constants, so the range covers the larger of the two.
+	VkPushConstantRange tileShadePushConstantRange = {};
+	tileShadePushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	tileShadePushConstantRange.offset = 0;
+	tileShadePushConstantRange.size = SCAST_U32(std::max(sizeof(VrsPushConstants), sizeof(TemporalPushConstants)));
+	pipelineLayoutInfo.pSetLayouts = &tileShadeDescSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &tileShadePushConstantRange;
+	if (vkCreatePipelineLayout(vulkan->Device(), &pipelineLayoutInfo, nullptr, &tileShadePipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create tile shade pipeline layout");
+	}
+
+	// Software raster layout, shared by the compute passes and the merge draw
+	VkPushConstantRange swRasterPushConstantRange = {};
+	swRasterPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	swRasterPushConstantRange.offset = 0;
+	swRasterPushConstantRange.size = sizeof(SwRasterPushConstants);
+	pipelineLayoutInfo.pSetLayouts = &swRasterDescSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &swRasterPushConstantRange;
+	if (vkCreatePipelineLayout(vulkan->Device(), &pipelineLayoutInfo, nullptr, &swRasterPipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create software raster pipeline layout");
+	}
 }
 
-void VulkanApplication::CreateRenderPasses()
+// Images used as frame buffer attachments, the only objects besides the frame buffers that depend on the swapchain's size
+void VulkanApplication::CreateFrameBufferAttachments()
 {
-	// Setup images for use as frame buffer attachments
-	CreateFrameBufferAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &visibilityBuffer.visibility, allocator); // 32 bit uint will be unpacked into four 8bit floats
-	CreateFrameBufferAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &tessVisibilityBuffer.visibility, allocator); 
+	VkFormat visibilityFormat = useUintVisibility ? VK_FORMAT_R32_UINT : VK_FORMAT_R8G8B8A8_UNORM; // Either a native 32 bit uint, or a 32 bit uint unpacked into four 8bit floats
+	CreateFrameBufferAttachment(visibilityFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT, &visibilityBuffer.visibility, allocator); // Storage for the tile classified compute shade pass
+	CreateFrameBufferAttachment(visibilityFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT, &tessVisibilityBuffer.visibility, allocator); // Storage for the tess factor feedback coverage pass
 	CreateFrameBufferAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &tessVisibilityBuffer.tessCoords_v1XYZ_v2X, allocator);
 	CreateFrameBufferAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &tessVisibilityBuffer.tessCoords_v2YZ_v3XY, allocator);
 	CreateFrameBufferAttachment(VK_FORMAT_R8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &tessVisibilityBuffer.tessCoords_v3Z, allocator);
 	CreateDepthResources();
+	CreateFrameBufferAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_STORAGE_BIT, &tileShadeOutput, allocator); // Compute shade pass output, composited in the shade subpass
+	attachmentLayoutsPending = true; // The depth and tile shade output layouts are set at the start of the next frame
+
+	// Multisampled vis buff attachments. The single sampled visibility image is still created for the compute descriptor sets, and the
+	// tessellation pipeline keeps the single sampled depth image.
+	if (visBuffSampleCount != VK_SAMPLE_COUNT_1_BIT)
+	{
+		CreateFrameBufferAttachment(visibilityFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, &visibilityBuffer.msaaVisibility, allocator, visBuffSampleCount);
+		visibilityBuffer.msaaDepth.Create(vulkan->Swapchain().Extent().width, vulkan->Swapchain().Extent().height, depthImage.Format(), VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator, visBuffSampleCount);
+		visibilityBuffer.msaaDepth.CreateImageView(vulkan->Device(), VK_IMAGE_ASPECT_DEPTH_BIT);
+	}
+	statistics.msaaSampleCount = SCAST_U32(visBuffSampleCount);
+	statistics.msaaAttachmentBytes = VisBuffAttachmentBytes(visBuffSampleCount);
+}
 
+void VulkanApplication::CreateRenderPasses()
+{
 	// Create attachment descriptions
 	// Swapchain image attachment
 	VkAttachmentDescription swapChainAttachmentDesc = {};
@@ -858,16 +2218,26 @@ void VulkanApplication::CreateRenderPasses()
 	depthAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	depthAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	// Vis buff attachments, multisampled when MSAA is on
+	VkAttachmentDescription visBuffVisibilityAttachmentDesc = visibilityAttachmentDesc;
+	visBuffVisibilityAttachmentDesc.samples = visBuffSampleCount;
+	VkAttachmentDescription visBuffDepthAttachmentDesc = depthAttachmentDesc;
+	visBuffDepthAttachmentDesc.samples = visBuffSampleCount;
 
 	// Subpass dependencies will be the same for both renderpasses
-	std::array<VkSubpassDependency, 3> dependencies = {};
+	std::array<VkSubpassDependency, 4> dependencies = {};
+
+	// The depth and visibility attachments are shared by every frame context, so the previous frame's attachment writes and its
+	// shader and compute reads of them finish before they're cleared. Not by region, the compute passes read whole images.
 	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dependencyFlags = 0;
 
 	// Transition the vis buffer from color attachment to shader read
 	dependencies[1].srcSubpass = 0;
@@ -886,11 +2256,22 @@ void VulkanApplication::CreateRenderPasses()
 	dependencies[2].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 	dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+	// Storage buffers written by the write subpass, such as the triangle records and their counter, are read by the shade subpass.
+	// Not by region, a record is read by whichever pixel its triangle covers rather than where it was written.
+	dependencies[3].srcSubpass = 0;
+	dependencies[3].dstSubpass = 1;
+	dependencies[3].srcStageMask = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
+		VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[3].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[3].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	dependencies[3].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	dependencies[3].dependencyFlags = 0;
+
 	// Visibility Buffer RenderPass =============================================
 	std::array<VkAttachmentDescription, 3> visBuffAttachments = {};
 	visBuffAttachments[0] = swapChainAttachmentDesc;
-	visBuffAttachments[1] = visibilityAttachmentDesc;
-	visBuffAttachments[2] = depthAttachmentDesc;
+	visBuffAttachments[1] = visBuffVisibilityAttachmentDesc;
+	visBuffAttachments[2] = visBuffDepthAttachmentDesc;
 
 	// Two subpasses
 	std::array<VkSubpassDescription, 2> visBuffSubpassDescriptions{};
@@ -898,8 +2279,10 @@ void VulkanApplication::CreateRenderPasses()
 	// First Subpass: Visibility Buffer Write
 	// --------------------------------------
 	// Attachment references 
+	// A single sampled swapchain can't share a multisampled subpass, so the write shader's dummy colour output is discarded instead
+	bool msaa = visBuffSampleCount != VK_SAMPLE_COUNT_1_BIT;
 	std::vector<VkAttachmentReference> visBuffWriteColorReferences;
-	visBuffWriteColorReferences.push_back({ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+	visBuffWriteColorReferences.push_back({ msaa ? VK_ATTACHMENT_UNUSED : 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
 	visBuffWriteColorReferences.push_back({ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }); // Visibility Buffer attachment
 	VkAttachmentReference depthReference = { 2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
 
@@ -921,7 +2304,7 @@ void VulkanApplication::CreateRenderPasses()
 	visBuffSubpassDescriptions[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	visBuffSubpassDescriptions[1].colorAttachmentCount = SCAST_U32(visBuffShadeColourReferences.size());
 	visBuffSubpassDescriptions[1].pColorAttachments = visBuffShadeColourReferences.data();
-	visBuffSubpassDescriptions[1].pDepthStencilAttachment = &depthReference;
+	visBuffSubpassDescriptions[1].pDepthStencilAttachment = msaa ? nullptr : &depthReference; // Nor can the multisampled depth
 	// Input attachments from vis buff write subpass
 	visBuffSubpassDescriptions[1].inputAttachmentCount = SCAST_U32(inputReferences.size());
 	visBuffSubpassDescriptions[1].pInputAttachments = inputReferences.data();
@@ -942,6 +2325,28 @@ void VulkanApplication::CreateRenderPasses()
 	{
 		throw std::runtime_error("Failed to create render pass");
 	}
+
+	// Composite render pass, begun again after the tile shade compute passes. Only the load and store operations differ so it
+	// stays compatible with the vis buff framebuffers and pipelines, the swapchain is fully overwritten by the composite draw.
+	for (VkAttachmentDescription& attachment : visBuffAttachments)
+	{
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+	visBuffAttachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	visBuffAttachments[2].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	if (vkCreateRenderPass(vulkan->Device(), &visBuffRenderPassInfo, nullptr, &visBuffCompositeRenderPass) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create composite render pass");
+	}
+
+	// Resume render pass, begun again after the triangle setup pass. The visibility buffer is loaded for the shade subpass.
+	visBuffAttachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	visBuffAttachments[1].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	if (vkCreateRenderPass(vulkan->Device(), &visBuffRenderPassInfo, nullptr, &visBuffResumeRenderPass) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create resume render pass");
+	}
 	// ==========================================================================
 
 	// Tessellataion RenderPass =================================================
@@ -1010,29 +2415,56 @@ void VulkanApplication::CreateRenderPasses()
 		throw std::runtime_error("Failed to create tessellation render pass");
 	}
 	// ==========================================================================
-}
-
-VkShaderModule VulkanApplication::CreateShaderModule(const std::vector<char>& code)
-{
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(vulkan->Device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	// UI RenderPass ============================================================
+	// Loads the shaded image both pipelines leave ready to present. It doesn't change with the visibility buffer, so the ImGui
+	// pipeline built against the first one stays compatible with every recreation.
+	VkAttachmentDescription uiAttachmentDesc = swapChainAttachmentDesc;
+	uiAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	uiAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	VkAttachmentReference uiColourReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription uiSubpassDescription = {};
+	uiSubpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	uiSubpassDescription.colorAttachmentCount = 1;
+	uiSubpassDescription.pColorAttachments = &uiColourReference;
+
+	// Wait for the shade subpass's writes before blending over them
+	VkSubpassDependency uiDependency = {};
+	uiDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	uiDependency.dstSubpass = 0;
+	uiDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	uiDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	uiDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	uiDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	uiDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+	VkRenderPassCreateInfo uiRenderPassInfo = {};
+	uiRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	uiRenderPassInfo.attachmentCount = 1;
+	uiRenderPassInfo.pAttachments = &uiAttachmentDesc;
+	uiRenderPassInfo.subpassCount = 1;
+	uiRenderPassInfo.pSubpasses = &uiSubpassDescription;
+	uiRenderPassInfo.dependencyCount = 1;
+	uiRenderPassInfo.pDependencies = &uiDependency;
+	if (vkCreateRenderPass(vulkan->Device(), &uiRenderPassInfo, nullptr, &uiRenderPass) != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to create shader module");
+		throw std::runtime_error("Failed to create UI render pass");
 	}
+	// ==========================================================================
+}
 
-	return shaderModule;
+// Shaders that read or write the visibility buffer are compiled twice, once with VISIBILITY_UINT defined for the R32_UINT attachment format
+std::string VulkanApplication::VisibilityShaderPath(const std::string& name, const std::string& stage)
+{
+	return "shaders/" + name + (useUintVisibility ? ".uint." : ".") + stage + ".spv";
 }
 #pragma endregion
 
 #pragma region Drawing Functions
 void VulkanApplication::InitCamera()
 {
-	camera.SetPerspective(45.0f, (float)vulkan->Swapchain().Extent().width / (float)vulkan->Swapchain().Extent().height, 0.1f, 500.0f, true);
+	camera.SetPerspective(CAMERA_FOV, (float)vulkan->Swapchain().Extent().width / (float)vulkan->Swapchain().Extent().height, 0.1f, 500.0f, true);
 	camera.SetRotation(glm::vec3(10.0f, 310.0f, 0.0f), true);
 	camera.SetPosition(glm::vec3(-2.0f, -6.0f, -1.5f), true);
 }
@@ -1044,13 +2476,14 @@ void VulkanApplication::InitLight()
 	lightInfo.diffuse = glm::vec4(0.818f, 0.713f, 0.556f, 1.0f);
 	lightInfo.ambient = glm::vec4(0.4f, 0.3f, 0.3f, 1.0f);
 
-	light.Init(lightInfo, allocator);
+	light.Init(lightInfo);
 }
 
 void VulkanApplication::CreateFrameBuffers()
 {
 	// Create Visibility Buffer frame buffers
 	std::array<VkImageView, 3> visBuffAttachments = {};
+	bool msaa = visBuffSampleCount != VK_SAMPLE_COUNT_1_BIT;
 
 	VkFramebufferCreateInfo visBuffFramebufferInfo = {};
 	visBuffFramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -1066,8 +2499,8 @@ void VulkanApplication::CreateFrameBuffers()
 	for (size_t i = 0; i < vulkan->Swapchain().ImageViews().size(); i++)
 	{
 		visBuffAttachments[0] = vulkan->Swapchain().ImageViews()[i];
-		visBuffAttachments[1] = visibilityBuffer.visibility.ImageView();
-		visBuffAttachments[2] = depthImage.ImageView();
+		visBuffAttachments[1] = msaa ? visibilityBuffer.msaaVisibility.ImageView() : visibilityBuffer.visibility.ImageView();
+		visBuffAttachments[2] = msaa ? visibilityBuffer.msaaDepth.ImageView() : depthImage.ImageView();
 
 		if (vkCreateFramebuffer(vulkan->Device(), &visBuffFramebufferInfo, nullptr, &visBuffFramebuffers[i]) != VK_SUCCESS)
 		{
@@ -1103,16 +2536,36 @@ void VulkanApplication::CreateFrameBuffers()
 			throw std::runtime_error("Failed to create tessellation frame buffer");
 		}
 	}
+
+	// UI, just the swapchain image
+	VkFramebufferCreateInfo uiFramebufferInfo = {};
+	uiFramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	uiFramebufferInfo.renderPass = uiRenderPass;
+	uiFramebufferInfo.attachmentCount = 1;
+	uiFramebufferInfo.width = vulkan->Swapchain().Extent().width;
+	uiFramebufferInfo.height = vulkan->Swapchain().Extent().height;
+	uiFramebufferInfo.layers = 1;
+
+	uiFramebuffers.resize(vulkan->Swapchain().ImageViews().size());
+	for (size_t i = 0; i < vulkan->Swapchain().ImageViews().size(); i++)
+	{
+		VkImageView uiAttachment = vulkan->Swapchain().ImageViews()[i];
+		uiFramebufferInfo.pAttachments = &uiAttachment;
+		if (vkCreateFramebuffer(vulkan->Device(), &uiFramebufferInfo, nullptr, &uiFramebuffers[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create UI frame buffer");
+		}
+	}
 }
 
-void VulkanApplication::CreateFrameBufferAttachment(VkFormat format, VkImageUsageFlags usage, Image* attachment, VmaAllocator& allocator)
+void VulkanApplication::CreateFrameBufferAttachment(VkFormat format, VkImageUsageFlags usage, Image* attachment, VmaAllocator& allocator, VkSampleCountFlagBits samples)
 {
 	// Create image
-	attachment->Create(vulkan->Swapchain().Extent().width, vulkan->Swapchain().Extent().height, format, VK_IMAGE_TILING_OPTIMAL, usage, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	attachment->Create(vulkan->Swapchain().Extent().width, vulkan->Swapchain().Extent().height, format, VK_IMAGE_TILING_OPTIMAL, usage, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator, samples);
 
 	// Create image view
 	VkImageAspectFlags aspectMask = 0;
-	if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+	if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT))
 		aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
 		aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
@@ -1124,8 +2577,42 @@ void VulkanApplication::CreateFrameBufferAttachment(VkFormat format, VkImageUsag
 // Return image to swap chain for presentation
 void VulkanApplication::DrawFrame()
 {
-	// Wait for previous frame to finish
+	// Pick up the queries of any frames the GPU has finished since the last one, without waiting for the rest
+	PollQueryResults();
+
+	// Wait for the last frame recorded into this frame context to finish, the only point the CPU waits on the GPU
+	FrameContext& frame = frames[currentFrame];
+	auto waitStart = std::chrono::high_resolution_clock::now();
 	vkWaitForFences(vulkan->Device(), 1, &vulkan->Fences()[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+#if IMGUI_ENABLED && defined(IMGUI_VK_QUEUED_FRAMES)
+	// The ImGui backend rewrites one of only IMGUI_VK_QUEUED_FRAMES vertex buffers each time it's recorded, so the frame that
+	// last used the one it's about to rewrite has to be finished too
+	if (framesInFlight > SCAST_U32(IMGUI_VK_QUEUED_FRAMES))
+	{
+		size_t imGuiFrame = (currentFrame + framesInFlight - IMGUI_VK_QUEUED_FRAMES) % framesInFlight;
+		vkWaitForFences(vulkan->Device(), 1, &vulkan->Fences()[imGuiFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+#endif
+	statistics.fenceWaitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+
+	// Submissions finish in order, so everything up to the context's last one is done with whatever was retired before it
+	completedFrameCount = std::max(completedFrameCount, frame.submitFrame);
+	deletionQueue.Flush(completedFrameCount);
+	statistics.retiredObjectCount = SCAST_U32(deletionQueue.Size());
+
+	// The context's last submission has finished, so its queries are available if the poll didn't get to them. They're reset when
+	// it's recorded again, so results still missing are dropped rather than waited on.
+	if (frame.queriesPending)
+	{
+		if (!GetQueryResults(frame))
+			statistics.droppedQueryResults++;
+		frame.queriesPending = false;
+	}
+	if (frame.submitted)
+	{
+		GetCounterResults(frame);
+		frame.submitted = false;
+	}
 
 	// Acquire image from swap chain. ImageAvailableSemaphore will be signaled when the image is ready to be drawn to. Check if we have to recreate the swap chain
 	uint32_t imageIndex;
@@ -1142,11 +2629,15 @@ void VulkanApplication::DrawFrame()
 		throw std::runtime_error("Failed to acquire swap chain image");
 	}
 
+	// The context's uniform slice is rewritten below. The fence wait at the top of the frame means its last submission is done
+	// with it.
+
 	// We reset fences here in the case that the swap chain needs rebuilding
 	vkResetFences(vulkan->Device(), 1, &vulkan->Fences()[currentFrame]);
 
-	// Update the uniform buffers
+	// Update the uniform buffer contents and write them into this frame context's slice
 	UpdateUniformBuffers();
+	WriteUniformSlice(SCAST_U32(currentFrame));
 
 	// Submit the command buffer. Waits for the provided semaphores to be signaled before beginning execution
 	VkSubmitInfo submitInfo = {};
@@ -1160,16 +2651,23 @@ void VulkanApplication::DrawFrame()
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = &renderFinishedSemaphore;
 
-	// Update command buffer (for ImGui)
-	RecordCommandBuffers();
+	// Record this frame context's command buffer against the acquired image (also picks up ImGui)
+	auto recordStart = std::chrono::high_resolution_clock::now();
+	RecordCommandBuffer(imageIndex);
+	statistics.commandRecordTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
 
 	// Submit to queue
-	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+	submitInfo.pCommandBuffers = &frame.commandBuffer;
 	submitInfo.commandBufferCount = 1;
 	if (vkQueueSubmit(vulkan->PhysDevice().Queues()->graphics, 1, &submitInfo, vulkan->Fences()[currentFrame]) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to submit visBuff command buffer");
 	}
+	frame.submitted = true;
+	lastSubmittedFrame = currentFrame;
+	frame.queriesPending = frame.sceneState.gpuQueries;
+	frame.querySubmitFrame = ++submittedFrameCount;
+	frame.submitFrame = submittedFrameCount;
 
 	// Now submit the resulting image back to the swap chain
 	VkPresentInfoKHR presentInfo = {};
@@ -1196,7 +2694,15 @@ void VulkanApplication::DrawFrame()
 	}
 
 	// Progress the current frame
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	currentFrame = (currentFrame + 1) % framesInFlight;
+}
+
+// Changes the number of frame contexts in use. Every context is idle afterwards, so the rotation can restart from the first.
+void VulkanApplication::SetFramesInFlight(uint32_t count)
+{
+	vkDeviceWaitIdle(vulkan->Device());
+	framesInFlight = std::min(std::max(count, 1u), SCAST_U32(MAX_FRAMES_IN_FLIGHT));
+	currentFrame = 0;
 }
 #pragma endregion
 
@@ -1216,25 +2722,67 @@ void VulkanApplication::CreateCommandPool()
 	{
 		throw std::runtime_error("failed to create command pool!");
 	}
+
+	// Command pools can only be used by one thread at a time, so each recording thread gets its own in every frame context
+	for (FrameContext& frame : frames)
+	{
+		for (VkCommandPool& threadCommandPool : frame.threadCommandPools)
+		{
+			if (vkCreateCommandPool(vulkan->Device(), &poolInfo, nullptr, &threadCommandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create recording thread command pool");
+			}
+		}
+	}
 }
 
+// One command buffer per frame context rather than per swapchain image, a buffer is only re-recorded once its context's fence
+// has signalled. They don't depend on the swapchain, so they live until clean up.
 void VulkanApplication::AllocateCommandBuffers()
 {
-	commandBuffers.resize(vulkan->Swapchain().ImageViews().size());
-
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = commandPool;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = SCAST_U32(commandBuffers.size());
+	allocInfo.commandBufferCount = 1;
 
-	if (vkAllocateCommandBuffers(vulkan->Device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+	// Each frame context gets a primary, the secondaries the scene is cached in and one for the UI
+	VkCommandBufferAllocateInfo secondaryAllocInfo = allocInfo;
+	secondaryAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+	for (FrameContext& frame : frames)
 	{
-		throw std::runtime_error("Failed to allocate vis buffer command buffers");
+		if (vkAllocateCommandBuffers(vulkan->Device(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate vis buffer command buffers");
+		}
+		secondaryAllocInfo.commandBufferCount = SCENE_COMMAND_BUFFER_COUNT;
+		if (vkAllocateCommandBuffers(vulkan->Device(), &secondaryAllocInfo, frame.sceneCommandBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate scene command buffers");
+		}
+		secondaryAllocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(vulkan->Device(), &secondaryAllocInfo, &frame.uiCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate ImGui command buffer");
+		}
+
+		// Each recording thread's scene command buffers come from its own pool
+		VkCommandBufferAllocateInfo threadAllocInfo = secondaryAllocInfo;
+		threadAllocInfo.commandBufferCount = SCENE_COMMAND_BUFFER_COUNT;
+		for (size_t i = 0; i < frame.threadCommandPools.size(); i++)
+		{
+			threadAllocInfo.commandPool = frame.threadCommandPools[i];
+			if (vkAllocateCommandBuffers(vulkan->Device(), &threadAllocInfo, frame.threadSceneCommandBuffers[i].data()) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate recording thread command buffers");
+			}
+		}
+		frame.sceneRecorded = false;
 	}
 }
 
-void VulkanApplication::RecordCommandBuffers()
+void VulkanApplication::RecordCommandBuffer(uint32_t imageIndex)
 {
 	// Define clear values
 	std::array<VkClearValue, 3> visBuffClearValues = {};
@@ -1249,136 +2797,1082 @@ void VulkanApplication::RecordCommandBuffers()
 	tessClearValues[4].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 	tessClearValues[5].depthStencil = { 1.0f, 0 };
 
-	// Begin recording command buffers
-	for (size_t i = 0; i < commandBuffers.size(); i++)
+	// A running sweep forces on the path it measures at its current step. The setup cache and subgroup fetch sweeps measure the
+	// shade subpass, so the compute shading paths are all off while they run.
+	const Sweep& swRasterSweep = sweeps[SWEEP_SW_RASTER];
+	const Sweep& materialSweep = sweeps[SWEEP_MATERIAL];
+	const Sweep& setupCacheSweep = sweeps[SWEEP_SETUP_CACHE];
+	const Sweep& postTransformBenchmark = sweeps[SWEEP_POST_TRANSFORM];
+	const Sweep& subgroupFetchSweep = sweeps[SWEEP_SUBGROUP_FETCH];
+	const Sweep& vrsSweep = sweeps[SWEEP_VRS];
+	const Sweep& temporalSweep = sweeps[SWEEP_TEMPORAL];
+	const Sweep& recordBenchmark = sweeps[SWEEP_RECORD_BENCHMARK];
+	const Sweep& recordSweep = sweeps[SWEEP_RECORD];
+	const Sweep& timingBenchmark = sweeps[SWEEP_TIMING_BENCHMARK];
+	bool shadeSubpassSweep = setupCacheSweep.Running() || subgroupFetchSweep.Running();
+
+	// Small triangles are binned and rasterised in compute before the render pass, the rest go through the write pipeline.
+	// The software visibility buffer is sized at startup, so the hybrid path is skipped if the swapchain has grown past it.
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	SwRasterPushConstants swRasterConstants = {};
+	swRasterConstants.screenWidth = extent.width;
+	swRasterConstants.screenHeight = extent.height;
+	swRasterConstants.maxTriangleSize = swRasterSweep.Running() ? SCAST_U32(SW_RASTER_SWEEP_SIZES[swRasterSweep.Step()]) : swRasterMaxTriangleSize;
+	swRasterConstants.triangleCount = SCAST_U32(visBuffTerrainTriCount);
+	swRasterConstants.pass = 0;
+
+	// The compute paths and the other shade pipelines all read a single sampled visibility buffer, so MSAA turns them off
+	bool msaa = currentPipeline == VISIBILITYBUFFER && visBuffSampleCount != VK_SAMPLE_COUNT_1_BIT;
+	bool computeShadePaths = currentPipeline == VISIBILITYBUFFER && !msaa && !shadeSubpassSweep;
+
+	// Material binning splits the terrain into several draws, the software rasteriser writes draw 0 with terrain wide triangle IDs so
+	// it's left off while binning. Pixel lists are sized at startup like the tile lists below.
+	bool materialShade = computeShadePaths && drawParametersSupported && (useMaterialShading || materialSweep.Running() || recordSweep.Running()) && !vrsSweep.Running() && !temporalSweep.Running() && extent.width <= materialShadeExtent.width && extent.height <= materialShadeExtent.height;
+	uint32_t shadedMaterialCount = materialSweep.Running() ? materialSweep.Step() + 1 : materialCount;
+	bool swRaster = currentPipeline == VISIBILITYBUFFER && !msaa && (useSwRaster || swRasterSweep.Running()) && !materialShade && swRasterConstants.maxTriangleSize > 0 && extent.width <= swRasterExtent.width && extent.height <= swRasterExtent.height;
+
+	// VRS shades the same tiles as the tile classified path, so it shares its size limit and takes precedence over it
+	bool vrs = computeShadePaths && (useVrs || vrsSweep.Running()) && !materialShade && !temporalSweep.Running() && extent.width <= tileShadeExtent.width && extent.height <= tileShadeExtent.height;
+	VrsPushConstants vrsConstants = {};
+	vrsConstants.gradientThreshold = VRS_GRADIENT_THRESHOLDS[vrsSweep.Running() ? vrsSweep.Step() : vrsLevel];
+	vrsConstants.measureError = vrsSweep.Measuring();
+
+	// Temporal reuse shades every pixel of the tile shade output and sizes its history from it. The history is only valid for the
+	// next frame if this frame writes it.
+	bool temporalReuse = computeShadePaths && (useTemporalReuse || temporalSweep.Running()) && !materialShade && !vrs && extent.width <= tileShadeExtent.width && extent.height <= tileShadeExtent.height;
+	TemporalPushConstants temporalConstants = {};
+	temporalConstants.previousMvp = previousMvp;
+	temporalConstants.frameIndex = temporalFrameIndex++;
+	temporalConstants.reuseBudget = temporalSweep.Running() ? TEMPORAL_REUSE_BUDGETS[temporalSweep.Step()] : temporalReuseBudget;
+	temporalConstants.cameraMoved = previousMvp != currentMvp;
+	temporalConstants.resetHistory = !temporalHistoryValid;
+	temporalConstants.measureError = temporalSweep.Measuring();
+	temporalHistoryValid = temporalReuse;
+
+	// Tile lists are also sized at startup, fall back to the shade subpass if the swapchain has outgrown them
+	bool tileShade = computeShadePaths && useTileShading && !materialShade && !vrs && !temporalReuse && extent.width <= tileShadeExtent.width && extent.height <= tileShadeExtent.height;
+
+	// The setup cache is indexed by terrain wide triangle IDs, so like the software rasteriser it's left off while binning materials
+	bool setupCache = currentPipeline == VISIBILITYBUFFER && !msaa && !tileShade && !materialShade && !vrs && !temporalReuse && (setupCacheSweep.Running() ? setupCacheSweep.Step() % 2 == 1 : useSetupCache && !subgroupFetchSweep.Running());
+
+	// Tessellated vertices only exist after the evaluation stage, so the post-transform buffer is for the vis buff terrain only
+	bool postTransform = currentPipeline == VISIBILITYBUFFER && !msaa && (postTransformBenchmark.Running() ? postTransformBenchmark.Step() == 1 : usePostTransform && !subgroupFetchSweep.Running());
+
+	// Replaces the per pixel fetch of the default shade passes, so the other vis buff shading paths take precedence
+	bool subgroupFetch = subgroupFetchSupported && !msaa && (subgroupFetchSweep.Running() ? subgroupFetchSweep.Step() % 2 == 1 : useSubgroupFetch);
+
+	// Everything the cached scene command buffers are recorded from. The temporal constants change every frame, so that pass
+	// is recorded into the primary instead.
+	SceneRecordState state = {};
+	state.pipeline = currentPipeline;
+	state.resourceGeneration = sceneResourceGeneration;
+	state.msaa = msaa;
+	state.materialShade = materialShade;
+	state.shadedMaterialCount = shadedMaterialCount;
+	state.swRaster = swRaster;
+	state.swRasterConstants = swRasterConstants;
+	state.vrs = vrs;
+	state.vrsConstants = vrsConstants;
+	state.temporalReuse = temporalReuse;
+	state.tileShade = tileShade;
+	state.setupCache = setupCache;
+	state.postTransform = postTransform;
+	state.subgroupFetch = subgroupFetch;
+	state.recordTriangles = currentPipeline == VB_TESSELLATION && useTessRecords;
+	state.tessFeedback = currentPipeline == VB_TESSELLATION && useTessFeedback;
+	state.resetTessFeedback = state.tessFeedback && resetTessFeedback;
+	state.quadPatches = useQuadPatches;
+	state.depthPrePass = useDepthPrePass;
+	state.recordThreads = recordSweep.Running() ? RECORD_SWEEP_THREAD_COUNTS[recordSweep.Step() / RECORD_SWEEP_DRAW_CALLS.size()] : recordThreads;
+	state.writeDrawCalls = recordSweep.Running() ? RECORD_SWEEP_DRAW_CALLS[recordSweep.Step() % RECORD_SWEEP_DRAW_CALLS.size()] : writeDrawCalls;
+	state.gpuQueries = timingBenchmark.Running() ? timingBenchmark.Step() == 0 : useGpuQueries;
+	state.uniformOffset = uniformRing.SliceOffset(SCAST_U32(currentFrame));
+
+	// Scene command buffers write the frame context's queries, so each context caches its own
+	FrameContext& frame = frames[currentFrame];
+	bool cacheScene = recordBenchmark.Running() ? recordBenchmark.Step() == 1 : useSceneCache && !recordSweep.Running();
+	if (!cacheScene || !frame.sceneRecorded || !(frame.sceneState == state))
+	{
+		frame.sceneRecorded = false;
+		RecordSceneCommandBuffers(frame, state);
+		frame.sceneState = state;
+		frame.sceneRecorded = true;
+	}
+	VkRenderPass shadeRenderPass = SceneShadeRenderPass(state);
+
+#if IMGUI_ENABLED
+	// The UI changes every frame, so it gets a fresh secondary drawn in its own render pass after the scene's
+	BeginSecondaryCommandBuffer(frame.uiCommandBuffer, uiRenderPass, 0, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	imGui.DrawFrame(frame.uiCommandBuffer);
+	if (vkEndCommandBuffer(frame.uiCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record ImGui command buffer");
+	}
+#endif
+
+	// The primary only records per frame work and executes the rest, its last submission has finished so it can be reset
+	VkCommandBuffer commandBuffer = frame.commandBuffer;
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording vis buffer shade command buffer");
+	}
+
+	// Newly created attachments are transitioned by the first frame that uses them rather than by a submission of their own. The
+	// tile shade output starts out in the general layout as the VRS pass reads the previous frame's output, so it can't transition
+	// from undefined.
+	if (attachmentLayoutsPending)
+	{
+		depthImage.TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		tileShadeOutput.TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		attachmentLayoutsPending = false;
+	}
+	RecordSharedResourceBarriers(commandBuffer);
+
+	// Reset timestamp and statistics queries, they can't be reset inside the render pass the scene writes them in
+	if (state.gpuQueries)
+	{
+		vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, 8);
+		if (pipelineStatisticsSupported)
+			vkCmdResetQueryPool(commandBuffer, frame.pipelineStatisticsPool, 0, MAX_RECORD_THREADS);
+	}
+	vkCmdExecuteCommands(commandBuffer, 1, &frame.recordedSceneCommandBuffers[SCENE_PRE_PASS]);
+
+	// Start the render pass
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = vulkan->Swapchain().Extent();
+	if (currentPipeline == VISIBILITYBUFFER)
+	{
+		renderPassInfo.renderPass = visBuffRenderPass;
+		renderPassInfo.framebuffer = visBuffFramebuffers[imageIndex];
+		renderPassInfo.clearValueCount = SCAST_U32(visBuffClearValues.size());
+		renderPassInfo.pClearValues = visBuffClearValues.data();
+	}
+	else
+	{
+		renderPassInfo.renderPass = tessRenderPass;
+		renderPassInfo.framebuffer = tessFramebuffers[imageIndex];
+		renderPassInfo.clearValueCount = SCAST_U32(tessClearValues.size());
+		renderPassInfo.pClearValues = tessClearValues.data();
+	}
+
+	// First Subpass: Write to visibility buffer
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	vkCmdExecuteCommands(commandBuffer, frame.writeSliceCount, frame.writeSliceCommandBuffers.data());
+	vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	// Compute shading can't be recorded inside a render pass, so it ends here and the composite render pass is begun for the
+	// shade subpass afterwards. Same again for the setup pass, but the resume render pass keeps the visibility buffer.
+	if (tileShade || materialShade || vrs || temporalReuse || setupCache)
+	{
+		vkCmdEndRenderPass(commandBuffer);
+		if (state.gpuQueries)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 2);
+		if (temporalReuse)
+			RecordTemporalShadeCommands(commandBuffer, temporalConstants, state.uniformOffset);
+		else
+			vkCmdExecuteCommands(commandBuffer, 1, &frame.recordedSceneCommandBuffers[SCENE_RESOLVE]);
+		renderPassInfo.renderPass = shadeRenderPass;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	}
+
+	// Second Subpass: Shading pass
+	vkCmdExecuteCommands(commandBuffer, 1, &frame.recordedSceneCommandBuffers[SCENE_SHADE_SUBPASS]);
+
+	// Now end the render pass
+	vkCmdEndRenderPass(commandBuffer);
+
+#if IMGUI_ENABLED
+	// Then the UI over the shaded image
+	VkRenderPassBeginInfo uiRenderPassInfo = {};
+	uiRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	uiRenderPassInfo.renderPass = uiRenderPass;
+	uiRenderPassInfo.framebuffer = uiFramebuffers[imageIndex];
+	uiRenderPassInfo.renderArea.offset = { 0, 0 };
+	uiRenderPassInfo.renderArea.extent = vulkan->Swapchain().Extent();
+	vkCmdBeginRenderPass(commandBuffer, &uiRenderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	vkCmdExecuteCommands(commandBuffer, 1, &frame.uiCommandBuffer);
+	vkCmdEndRenderPass(commandBuffer);
+#endif
+	vkCmdExecuteCommands(commandBuffer, 1, &frame.recordedSceneCommandBuffers[SCENE_POST_PASS]);
+	RecordCounterReadback(commandBuffer, frame);
+
+	// And end recording of command buffers
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record vis Buff Shade command buffer");
+	}
+
+	// The reset is only recorded once, the cached scene is re-recorded without it next frame as its state no longer matches
+	if (currentPipeline == VB_TESSELLATION && useTessFeedback)
+		resetTessFeedback = false;
+}
+
+// Storage buffers and the tile shade output are shared between frame contexts while each pass only orders its own accesses within
+// the frame, so the frame submitted before this one finishes with them first. The depth and visibility attachments are ordered by
+// the render passes' external dependency instead.
+void VulkanApplication::RecordSharedResourceBarriers(VkCommandBuffer commandBuffer)
+{
+	std::array<Buffer*, 22> sharedBuffers = { &tessRecordBuffer, &tessRecordCounterBuffer, &tessPatchCoverageBuffer, &tessPatchFactorBuffer, &tessVertexFactorBuffer,
+		&swRasterIndexBuffer, &swRasterTriangleBuffer, &swRasterDispatchBuffer, &swRasterVisibilityBuffer, &tileListBuffer, &tileDispatchBuffer, &materialBinBuffer,
+		&materialPixelBuffer, &triangleSetupBuffer, &visibleTriangleBuffer, &triangleSetupCounterBuffer, &transformedVertexBuffer, &subgroupFetchCounterBuffer,
+		&vrsRateBuffer, &vrsCounterBuffer, &temporalHistoryBuffer, &temporalCounterBuffer };
+	std::array<VkBufferMemoryBarrier, 22> bufferBarriers = {};
+	for (size_t i = 0; i < sharedBuffers.size(); i++)
+	{
+		bufferBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarriers[i].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarriers[i].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+			VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarriers[i].buffer = sharedBuffers[i]->VkHandle();
+		bufferBarriers[i].offset = 0;
+		bufferBarriers[i].size = VK_WHOLE_SIZE;
+	}
+
+	// The VRS pass reads the tile shade output of the previous frame
+	VkImageMemoryBarrier outputBarrier = {};
+	outputBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	outputBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	outputBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	outputBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	outputBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	outputBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	outputBarrier.image = tileShadeOutput.VkHandle();
+	outputBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	outputBarrier.subresourceRange.baseMipLevel = 0;
+	outputBarrier.subresourceRange.levelCount = 1;
+	outputBarrier.subresourceRange.baseArrayLayer = 0;
+	outputBarrier.subresourceRange.layerCount = 1;
+
+	VkPipelineStageFlags storageStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+		VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT |
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	vkCmdPipelineBarrier(commandBuffer, storageStages, storageStages, 0, 0, nullptr, SCAST_U32(bufferBarriers.size()), bufferBarriers.data(), 1, &outputBarrier);
+}
+
+// Copies the counters the frame wrote into its context's readback buffer, so the host reads them once the context's fence has
+// signalled while later frames reuse the counter buffers
+void VulkanApplication::RecordCounterReadback(VkCommandBuffer commandBuffer, FrameContext& frame)
+{
+	// Counters are written by shaders and reset by fills, whichever ran last
+	VkMemoryBarrier counterBarrier = {};
+	counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	counterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	counterBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	VkPipelineStageFlags counterStages = VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	vkCmdPipelineBarrier(commandBuffer, counterStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &counterBarrier, 0, nullptr, 0, nullptr);
+
+	VkBuffer readback = frame.counterReadback.VkHandle();
+	auto copy = [&](Buffer& counters, VkDeviceSize size, VkDeviceSize offset)
 	{
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		VkBufferCopy region = { 0, offset, size };
+		vkCmdCopyBuffer(commandBuffer, counters.VkHandle(), readback, 1, &region);
+	};
+	copy(swRasterDispatchBuffer, sizeof(CounterReadback::swRasterDispatch), offsetof(CounterReadback, swRasterDispatch));
+	copy(tileDispatchBuffer, sizeof(CounterReadback::tileDispatches), offsetof(CounterReadback, tileDispatches));
+	copy(materialBinBuffer, sizeof(CounterReadback::materialBins), offsetof(CounterReadback, materialBins));
+	copy(triangleSetupCounterBuffer, sizeof(CounterReadback::triangleSetup), offsetof(CounterReadback, triangleSetup));
+	copy(subgroupFetchCounterBuffer, sizeof(CounterReadback::subgroupFetch), offsetof(CounterReadback, subgroupFetch));
+	copy(vrsCounterBuffer, sizeof(CounterReadback::vrs), offsetof(CounterReadback, vrs));
+	copy(temporalCounterBuffer, sizeof(CounterReadback::temporal), offsetof(CounterReadback, temporal));
+	copy(tessRecordCounterBuffer, sizeof(CounterReadback::tessRecordCount), offsetof(CounterReadback, tessRecordCount));
+
+	VkMemoryBarrier hostBarrier = {};
+	hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+}
+
+// Returns the render pass the shade subpass is recorded in, the compute and setup paths resume the frame in their own render passes
+VkRenderPass VulkanApplication::SceneShadeRenderPass(const SceneRecordState& state)
+{
+	if (state.tileShade || state.materialShade || state.vrs || state.temporalReuse)
+		return visBuffCompositeRenderPass;
+	if (state.setupCache)
+		return visBuffResumeRenderPass;
+	return state.pipeline == VISIBILITYBUFFER ? visBuffRenderPass : tessRenderPass;
+}
+
+// Secondaries recorded for a subpass continue the given render pass, the framebuffer is left for the primary to provide
+void VulkanApplication::BeginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkRenderPass renderPass, uint32_t subpass, VkCommandBufferUsageFlags flags)
+{
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = subpass;
+	inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = flags | (renderPass != VK_NULL_HANDLE ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : 0);
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording secondary command buffer");
+	}
+}
+
+// Secondaries don't inherit dynamic state, so each subpass sets its own
+void VulkanApplication::SetViewportAndScissor(VkCommandBuffer commandBuffer)
+{
+	VkViewport viewport = {};
+	viewport.width = (float)vulkan->Swapchain().Extent().width;
+	viewport.height = (float)vulkan->Swapchain().Extent().height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor = {};
+	scissor.extent = vulkan->Swapchain().Extent();
+	scissor.offset = { 0, 0 };
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
 
-		if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
+// Binds a set whose first uniformRegionCount uniform bindings are regions of the uniform ring, all offset to the same frame slice.
+// Dynamic offsets are consumed in binding order, and every region shares the slice so the order doesn't matter.
+void VulkanApplication::BindUniformRingDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, VkDescriptorSet descriptorSet, uint32_t uniformRegionCount, uint32_t uniformOffset)
+{
+	std::array<uint32_t, UNIFORM_REGION_COUNT> dynamicOffsets;
+	dynamicOffsets.fill(uniformOffset);
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, 0, 1, &descriptorSet, uniformRegionCount, dynamicOffsets.data());
+}
+
+// Records everything but the temporal pass and the UI into the frame context's secondaries: the passes
+// before the render pass, the write subpass, the compute resolve, the shade subpass and the passes after the render pass. With
+// more than one recording thread each thread records into its own pool, and the write subpass is split into a slice per thread.
+void VulkanApplication::RecordSceneCommandBuffers(FrameContext& frame, const SceneRecordState& state)
+{
+	VkRenderPass writeRenderPass = state.pipeline == VISIBILITYBUFFER ? visBuffRenderPass : tessRenderPass;
+	std::array<VkRenderPass, SCENE_COMMAND_BUFFER_COUNT> renderPasses = { VK_NULL_HANDLE, writeRenderPass, VK_NULL_HANDLE, SceneShadeRenderPass(state), VK_NULL_HANDLE };
+	std::array<uint32_t, SCENE_COMMAND_BUFFER_COUNT> subpasses = { 0, 0, 0, 1, 0 };
+
+	// Only the material path's multi-draw has more than one draw to split, the other paths write in a single slice
+	uint32_t threadCount = std::min(state.recordThreads, recordThreadPool.ThreadCount());
+	frame.writeSliceCount = state.materialShade ? std::min(threadCount, state.writeDrawCalls) : 1;
+
+	// Jobs are the write slices, then the other scene command buffers. Each thread takes at most one job of each kind, so it
+	// records into its own command buffer for that kind.
+	const std::array<SceneCommandBuffer, SCENE_COMMAND_BUFFER_COUNT - 1> otherCommandBuffers = { SCENE_PRE_PASS, SCENE_RESOLVE, SCENE_SHADE_SUBPASS, SCENE_POST_PASS };
+	uint32_t jobCount = frame.writeSliceCount + SCAST_U32(otherCommandBuffers.size());
+	auto recordCommandBuffer = [&](uint32_t job, uint32_t thread)
+	{
+		std::array<VkCommandBuffer, SCENE_COMMAND_BUFFER_COUNT>& commandBuffers = threadCount > 1 ? frame.threadSceneCommandBuffers[thread] : frame.sceneCommandBuffers;
+		SceneCommandBuffer kind = job < frame.writeSliceCount ? SCENE_WRITE_SUBPASS : otherCommandBuffers[job - frame.writeSliceCount];
+		VkCommandBuffer commandBuffer = commandBuffers[kind];
+		BeginSecondaryCommandBuffer(commandBuffer, renderPasses[kind], subpasses[kind]);
+		switch (kind)
 		{
-			throw std::runtime_error("Failed to begin recording vis buffer shade command buffer");
+			case SCENE_PRE_PASS:
+				RecordScenePrePass(commandBuffer, frame, state);
+				break;
+			case SCENE_WRITE_SUBPASS:
+				RecordSceneWriteSlice(commandBuffer, frame, state, job);
+				break;
+			case SCENE_RESOLVE:
+				RecordSceneResolve(commandBuffer, state);
+				break;
+			case SCENE_SHADE_SUBPASS:
+				RecordSceneShadeSubpass(commandBuffer, frame, state);
+				break;
+			case SCENE_POST_PASS:
+				RecordScenePostPass(commandBuffer, state);
+				break;
 		}
-
-		// Start the render pass
-		VkRenderPassBeginInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = vulkan->Swapchain().Extent();
-		if (currentPipeline == VISIBILITYBUFFER)
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 		{
-			renderPassInfo.renderPass = visBuffRenderPass;
-			renderPassInfo.framebuffer = visBuffFramebuffers[i];
-			renderPassInfo.clearValueCount = SCAST_U32(visBuffClearValues.size());
-			renderPassInfo.pClearValues = visBuffClearValues.data();
+			throw std::runtime_error("Failed to record scene command buffers");
 		}
+
+		if (kind == SCENE_WRITE_SUBPASS)
+			frame.writeSliceCommandBuffers[job] = commandBuffer;
 		else
+			frame.recordedSceneCommandBuffers[kind] = commandBuffer;
+	};
+
+	// A failed job is caught on its worker and rethrown here once the run has finished. Jobs that haven't started yet are skipped
+	// as the frame can't be submitted anyway, and the caller leaves the context unrecorded.
+	std::exception_ptr recordError;
+	std::mutex recordErrorMutex;
+	auto recordJob = [&](uint32_t job, uint32_t thread)
+	{
+		{
+			std::lock_guard<std::mutex> lock(recordErrorMutex);
+			if (recordError)
+				return;
+		}
+		try
+		{
+			recordCommandBuffer(job, thread);
+		}
+		catch (...)
 		{
-			renderPassInfo.renderPass = tessRenderPass;
-			renderPassInfo.framebuffer = tessFramebuffers[i];
-			renderPassInfo.clearValueCount = SCAST_U32(tessClearValues.size());
-			renderPassInfo.pClearValues = tessClearValues.data();
+			std::lock_guard<std::mutex> lock(recordErrorMutex);
+			if (!recordError)
+				recordError = std::current_exception();
 		}
+	};
 
-		// Reset timestamp queries
-		vkCmdResetQueryPool(commandBuffers[i], timestampPool, 0, 4);		
+	if (threadCount > 1)
+	{
+		recordThreadPool.Run(threadCount, jobCount, recordJob);
+	}
+	else
+	{
+		for (uint32_t job = 0; job < jobCount; job++)
+			recordJob(job, 0);
+	}
+	if (recordError)
+		std::rethrow_exception(recordError);
+}
 
-		// Begin the render pass
-		vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+// Counter resets and the compute passes before the render pass
+void VulkanApplication::RecordScenePrePass(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state)
+{
+	// Reset the triangle record counter before the geometry stage starts appending
+	if (state.recordTriangles)
+	{
+		vkCmdFillBuffer(commandBuffer, tessRecordCounterBuffer.VkHandle(), 0, sizeof(uint32_t), 0);
+		VkBufferMemoryBarrier counterBarrier = {};
+		counterBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		counterBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		counterBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		counterBarrier.buffer = tessRecordCounterBuffer.VkHandle();
+		counterBarrier.offset = 0;
+		counterBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT, 0, 0, nullptr, 1, &counterBarrier, 0, nullptr);
+	}
 
-		VkViewport viewport = {};
-		viewport.width = (float)vulkan->Swapchain().Extent().width;
-		viewport.height = (float)vulkan->Swapchain().Extent().height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffers[i], 0, 1, &viewport);
+	// Reset the subgroup fetch counters before the shade subpass starts counting
+	if (state.subgroupFetch)
+	{
+		vkCmdFillBuffer(commandBuffer, subgroupFetchCounterBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+		VkBufferMemoryBarrier counterBarrier = {};
+		counterBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		counterBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		counterBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		counterBarrier.buffer = subgroupFetchCounterBuffer.VkHandle();
+		counterBarrier.offset = 0;
+		counterBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &counterBarrier, 0, nullptr);
+	}
+
+	// Tess factors resolved at the end of the previous frame are read by the control stage
+	if (state.tessFeedback)
+	{
+		if (state.resetTessFeedback)
+		{
+			vkCmdFillBuffer(commandBuffer, tessPatchFactorBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+			vkCmdFillBuffer(commandBuffer, tessVertexFactorBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+		}
+		VkMemoryBarrier factorBarrier = {};
+		factorBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		factorBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		factorBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &factorBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Software raster passes, timestamps are written even when they're skipped so every query of the frame becomes available
+	if (state.gpuQueries)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 4);
+	if (state.swRaster)
+		RecordSwRasterCommands(commandBuffer, state.swRasterConstants, state.uniformOffset);
+	if (state.gpuQueries)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 5);
+
+	// Vertex transform pass, read by both subpasses
+	if (state.gpuQueries)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 6);
+	if (state.postTransform)
+		RecordVertexTransformCommands(commandBuffer, state.uniformOffset);
+	if (state.gpuQueries)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 7);
+}
 
-		VkRect2D scissor = {};
-		scissor.extent = vulkan->Swapchain().Extent();
-		scissor.offset = { 0, 0 };
-		vkCmdSetScissor(commandBuffers[i], 0, 1, &scissor);
+// One slice of the write subpass. The first slice writes the start timestamp and the last the end one, each slice counts its own
+// draws in its own pipeline statistics query as a query can't span secondaries.
+void VulkanApplication::RecordSceneWriteSlice(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state, uint32_t slice)
+{
+	SetViewportAndScissor(commandBuffer);
 
-		// First Subpass: Write to visibility buffer using one of two pipelines
-		// -----------------------------------------
-		// Record start timestamp
-		vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 0);
+	// Record start timestamp
+	if (state.gpuQueries)
+	{
+		if (slice == 0)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 0);
+		if (pipelineStatisticsSupported)
+			vkCmdBeginQuery(commandBuffer, frame.pipelineStatisticsPool, slice, 0);
+	}
 
-		// Decide which pipeline to bind
-		switch (currentPipeline)
+	// Decide which pipeline to bind
+	switch (state.pipeline)
+	{
+		case VISIBILITYBUFFER:
 		{
-			case VISIBILITYBUFFER:
+			// Copy the software rasterised pixels in first so the hardware triangles depth test against them, then
+			// draw with the binned index buffer where the software triangles are degenerate. Only the first slice merges.
+			VkBuffer indexBuffer = state.swRaster ? swRasterIndexBuffer.VkHandle() : visBuffTerrain.IndexBuffer().VkHandle();
+			if (state.swRaster && slice == 0)
 			{
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffWritePipelineLayout, 0, 1, &visBuffWritePassDescSet, 0, nullptr);
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffWritePipeline);
-				VkDeviceSize offsets[1] = { 0 };
-				VkBuffer vertexBuffers[] = { visBuffTerrain.VertexBuffer().VkHandle() };
-				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-				vkCmdBindIndexBuffer(commandBuffers[i], visBuffTerrain.IndexBuffer().VkHandle(), 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(commandBuffers[i], SCAST_U32(visBuffTerrain.Indices().size()), 1, 0, 0, 0);
-				break;
+				BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, swRasterPipelineLayout, swRasterDescSet, 1, state.uniformOffset);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, swRasterMergePipeline);
+				vkCmdPushConstants(commandBuffer, swRasterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SwRasterPushConstants), &state.swRasterConstants);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 			}
-			case VB_TESSELLATION:
+
+			BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffWritePipelineLayout, visBuffWritePassDescSet, 1, state.uniformOffset);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.postTransform ? visBuffWriteTransformedPipeline : visBuffWritePipeline);
+			VkDeviceSize offsets[1] = { 0 };
+			VkBuffer vertexBuffers[] = { visBuffTerrain.VertexBuffer().VkHandle() };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			WritePushConstants writeConstants = {};
+			if (state.materialShade)
 			{
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tessWritePipelineLayout, 0, 1, &tessWritePassDescSet, 0, nullptr);
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tessWritePipeline);
-				VkDeviceSize offsets[1] = { 0 };
-				VkBuffer vertexBuffers[] = { tessTerrain.VertexBuffer().VkHandle() };
-				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-				vkCmdBindIndexBuffer(commandBuffers[i], tessTerrain.IndexBuffer().VkHandle(), 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(commandBuffers[i], SCAST_U32(tessTerrain.Indices().size()), 1, 0, 0, 0);
-				break;
+				// The material draws are issued in as many indirect calls as asked for and the calls are shared out between the
+				// slices. The draw ID restarts at zero in each call, so the call's first draw is pushed to offset it. Without
+				// multi-draw indirect every call holds a single draw.
+				uint32_t drawCalls = multiDrawIndirectSupported ? std::min(state.writeDrawCalls, MATERIAL_DRAW_COUNT) : MATERIAL_DRAW_COUNT;
+				uint32_t firstCall = slice * drawCalls / frame.writeSliceCount;
+				uint32_t endCall = (slice + 1) * drawCalls / frame.writeSliceCount;
+				for (uint32_t call = firstCall; call < endCall; call++)
+				{
+					uint32_t firstDraw = call * MATERIAL_DRAW_COUNT / drawCalls;
+					uint32_t endDraw = (call + 1) * MATERIAL_DRAW_COUNT / drawCalls;
+					writeConstants.drawOffset = firstDraw;
+					vkCmdPushConstants(commandBuffer, visBuffWritePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(WritePushConstants), &writeConstants);
+					vkCmdDrawIndexedIndirect(commandBuffer, visBuffDrawCommandBuffer.VkHandle(), firstDraw * sizeof(VkDrawIndexedIndirectCommand), endDraw - firstDraw, sizeof(VkDrawIndexedIndirectCommand));
+				}
+			}
+			else
+			{
+				vkCmdPushConstants(commandBuffer, visBuffWritePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(WritePushConstants), &writeConstants);
+				vkCmdDrawIndexed(commandBuffer, SCAST_U32(visBuffTerrain.Indices().size()), 1, 0, 0, 0);
+			}
+			break;
+		}
+		case VB_TESSELLATION:
+		{
+			// Triangle and quad patches share the write layout and render pass, only the pipeline and terrain differ
+			Terrain& terrain = state.quadPatches ? tessQuadTerrain : tessTerrain;
+			VkPipeline writePipeline = state.quadPatches ? (state.recordTriangles ? tessQuadRecordWritePipeline : tessQuadWritePipeline) : (state.recordTriangles ? tessRecordWritePipeline : tessWritePipeline);
+			BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tessWritePipelineLayout, tessWritePassDescSet, 2, state.uniformOffset);
+			VkDeviceSize offsets[1] = { 0 };
+			VkBuffer vertexBuffers[] = { terrain.VertexBuffer().VkHandle() };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, terrain.IndexBuffer().VkHandle(), 0, VK_INDEX_TYPE_UINT32);
+
+			// Lay down depth first so the write pass only fills the attachments once per pixel
+			if (state.depthPrePass)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.quadPatches ? tessQuadDepthPrePassPipeline : tessDepthPrePassPipeline);
+				vkCmdDrawIndexed(commandBuffer, SCAST_U32(terrain.Indices().size()), 1, 0, 0, 0);
 			}
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, writePipeline);
+			vkCmdDrawIndexed(commandBuffer, SCAST_U32(terrain.Indices().size()), 1, 0, 0, 0);
+			break;
 		}
+	}
+
+	// Record end timestamp
+	if (state.gpuQueries)
+	{
+		if (pipelineStatisticsSupported)
+			vkCmdEndQuery(commandBuffer, frame.pipelineStatisticsPool, slice);
+		if (slice == frame.writeSliceCount - 1)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 1);
+	}
+}
 
-		// Record end timestamp
-		vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
-		// -----------------------------------------
+// Compute resolve between the render passes, the temporal pass is recorded into the primary
+void VulkanApplication::RecordSceneResolve(VkCommandBuffer commandBuffer, const SceneRecordState& state)
+{
+	if (state.materialShade)
+		RecordMaterialShadeCommands(commandBuffer, state.shadedMaterialCount, state.uniformOffset);
+	else if (state.vrs)
+		RecordVrsShadeCommands(commandBuffer, state.vrsConstants, state.uniformOffset);
+	else if (state.tileShade)
+		RecordTileShadeCommands(commandBuffer, state.uniformOffset);
+	else if (state.setupCache)
+		RecordTriangleSetupCommands(commandBuffer, state.uniformOffset);
+}
 
-		// Second Subpass: Shading Pass using one of two pipelines
-		// -----------------------------------------
-		vkCmdNextSubpass(commandBuffers[i], VK_SUBPASS_CONTENTS_INLINE);
+// Shading subpass using one of two pipelines
+void VulkanApplication::RecordSceneShadeSubpass(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state)
+{
+	SetViewportAndScissor(commandBuffer);
 
-		// Record start timestamp
-		vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2);
+	// Record start timestamp, the resolve paths write it in the primary before the compute work
+	bool computeResolve = state.tileShade || state.materialShade || state.vrs || state.temporalReuse;
+	if (state.gpuQueries && !computeResolve && !state.setupCache)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 2);
 
-		// Decide which pipeline to bind
-		switch (currentPipeline)
+	// Decide which pipeline to bind. Every image's shade set holds the same descriptors, so the cached pass binds the first.
+	switch (state.pipeline)
+	{
+		case VISIBILITYBUFFER:
 		{
-			case VISIBILITYBUFFER:
-			{
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffShadePipelineLayout, 0, 1, &visBuffShadePassDescSets[i], 0, nullptr);
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffShadePipeline);
-				vkCmdDraw(commandBuffers[i], 3, 1, 0, 0); // Vertex shader calculates positions of fullscreen triangle based on index, so no need to bind vertex/index buffers to create a fullscreen quad
-				break;
-			}
-			case VB_TESSELLATION:
+			if (computeResolve)
 			{
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tessShadePipelineLayout, 0, 1, &tessShadePassDescSets[i], 0, nullptr);
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tessShadePipeline);
-				vkCmdDraw(commandBuffers[i], 3, 1, 0, 0); // Vertex shader calculates positions of fullscreen triangle based on index, so no need to bind vertex/index buffers to create a fullscreen quad
+				BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tileShadePipelineLayout, tileShadeDescSet, 3, state.uniformOffset);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tileCompositePipeline);
+				vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 				break;
 			}
+			BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visBuffShadePipelineLayout, visBuffShadePassDescSets[0], 3, state.uniformOffset);
+			VkPipeline shadePipeline = visBuffShadePipeline;
+			if (state.msaa)
+				shadePipeline = visBuffShadeMsaaPipeline;
+			else if (state.setupCache)
+				shadePipeline = visBuffShadeCachedPipeline;
+			else if (state.postTransform)
+				shadePipeline = visBuffShadeTransformedPipeline;
+			else if (state.subgroupFetch)
+				shadePipeline = visBuffShadeSubgroupPipeline;
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadePipeline);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0); // Vertex shader calculates positions of fullscreen triangle based on index, so no need to bind vertex/index buffers to create a fullscreen quad
+			break;
+		}
+		case VB_TESSELLATION:
+		{
+			VkDescriptorSet shadeDescSet = state.quadPatches ? tessQuadShadePassDescSets[0] : tessShadePassDescSets[0];
+			VkPipeline shadePipeline = state.recordTriangles ? tessRecordShadePipeline : (state.quadPatches ? tessQuadShadePipeline : (state.subgroupFetch ? tessShadeSubgroupPipeline : tessShadePipeline));
+			BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tessShadePipelineLayout, shadeDescSet, 3, state.uniformOffset);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadePipeline);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0); // Vertex shader calculates positions of fullscreen triangle based on index, so no need to bind vertex/index buffers to create a fullscreen quad
+			break;
 		}
+	}
 
-		// Record end timestamp
-		vkCmdWriteTimestamp(commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 3);
-		// -----------------------------------------
+	// Record end timestamp
+	if (state.gpuQueries)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 3);
+}
 
-#if IMGUI_ENABLED
-		// Imgui pass
-		imGui.DrawFrame(commandBuffers[i]);
-#endif
+// Tess feedback passes after the render pass, the counters are copied to the host by RecordCounterReadback
+void VulkanApplication::RecordScenePostPass(VkCommandBuffer commandBuffer, const SceneRecordState& state)
+{
+	// Measure patch coverage for next frame's tess factors, record IDs are not patch IDs so the factors are held while recording
+	if (state.tessFeedback && !state.recordTriangles)
+		RecordTessFeedbackCommands(commandBuffer, state.uniformOffset);
+}
 
-		// Now end the render pass
-		vkCmdEndRenderPass(commandBuffers[i]);
+// Histograms the pixels covered by each patch in the tess visibility buffer, then resolves them into per patch and per vertex tess factors
+void VulkanApplication::RecordTessFeedbackCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset)
+{
+	// Coverage and vertex factors are rebuilt every frame, wait for the previous readers before clearing them
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, tessPatchCoverageBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+	vkCmdFillBuffer(commandBuffer, tessVertexFactorBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+
+	// Make the cleared buffers and the visibility buffer written by the render pass available to the compute stage
+	VkMemoryBarrier fillBarrier = {};
+	fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	VkImageMemoryBarrier visibilityBarrier = {};
+	visibilityBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	visibilityBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	visibilityBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	visibilityBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	visibilityBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	visibilityBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	visibilityBarrier.image = tessVisibilityBuffer.visibility.VkHandle();
+	visibilityBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	visibilityBarrier.subresourceRange.baseMipLevel = 0;
+	visibilityBarrier.subresourceRange.levelCount = 1;
+	visibilityBarrier.subresourceRange.baseArrayLayer = 0;
+	visibilityBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 1, &visibilityBarrier);
+
+	// Coverage pass, one invocation per pixel
+	VkDescriptorSet feedbackDescSet = tessFeedbackDescSets[useQuadPatches ? 1 : 0];
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tessFeedbackPipelineLayout, feedbackDescSet, 1, uniformOffset);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tessFeedbackCoveragePipeline);
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+
+	// Resolve pass, one invocation per patch
+	VkMemoryBarrier coverageBarrier = {};
+	coverageBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	coverageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	coverageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &coverageBarrier, 0, nullptr, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tessFeedbackResolvePipeline);
+	vkCmdDispatch(commandBuffer, (renderSettingsUbo.tessFeedbackPatchCount + 63) / 64, 1, 1);
+}
 
-		// And end recording of command buffers
-		if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to record vis Buff Shade command buffer");
-		}
+// Classifies the vis buff into sky, single triangle and multi triangle tiles then shades each class with its own kernel
+void VulkanApplication::RecordTileShadeCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset)
+{
+	// The previous frame's indirect dispatches must finish before their arguments are reset
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	std::array<uint32_t, TILE_SHADE_CLASS_COUNT * 3> dispatchReset = { 0, 1, 1, 0, 1, 1, 0, 1, 1 }; // No tiles in any class
+	vkCmdUpdateBuffer(commandBuffer, tileDispatchBuffer.VkHandle(), 0, sizeof(dispatchReset), dispatchReset.data());
+
+	// Make the reset arguments and the visibility buffer written by the render pass available to the compute stage. The previous
+	// output is discarded as every tile is written by one of the class kernels.
+	VkMemoryBarrier resetBarrier = {};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+	imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].image = visibilityBuffer.visibility.VkHandle();
+	imageBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarriers[0].subresourceRange.baseMipLevel = 0;
+	imageBarriers[0].subresourceRange.levelCount = 1;
+	imageBarriers[0].subresourceRange.baseArrayLayer = 0;
+	imageBarriers[0].subresourceRange.layerCount = 1;
+	imageBarriers[1] = imageBarriers[0];
+	imageBarriers[1].srcAccessMask = 0;
+	imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarriers[1].image = tileShadeOutput.VkHandle();
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, SCAST_U32(imageBarriers.size()), imageBarriers.data());
+
+	// Classify pass, one workgroup per tile
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileClassifyPipeline);
+	vkCmdDispatch(commandBuffer, (extent.width + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE, (extent.height + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE, 1);
+
+	// Class kernels, one workgroup per tile in each list
+	VkMemoryBarrier classifyBarrier = {};
+	classifyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	classifyBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	classifyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &classifyBarrier, 0, nullptr, 0, nullptr);
+	std::array<VkPipeline, TILE_SHADE_CLASS_COUNT> classPipelines = { tileShadeSkyPipeline, tileShadeSinglePipeline, tileShadeMultiPipeline };
+	for (uint32_t i = 0; i < TILE_SHADE_CLASS_COUNT; i++)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, classPipelines[i]);
+		vkCmdDispatchIndirect(commandBuffer, tileDispatchBuffer.VkHandle(), sizeof(VkDispatchIndirectCommand) * i);
+	}
+
+	// Shaded image is read by the composite draw
+	VkMemoryBarrier shadeBarrier = {};
+	shadeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	shadeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	shadeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &shadeBarrier, 0, nullptr, 0, nullptr);
+}
+
+// Counts and compacts the vis buff's pixels into one list per material, then shades each list with that material's kernel
+void VulkanApplication::RecordMaterialShadeCommands(VkCommandBuffer commandBuffer, uint32_t shadedMaterialCount, uint32_t uniformOffset)
+{
+	// The previous frame's indirect dispatches must finish before the bins are cleared
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, materialBinBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+
+	// Make the cleared bins and the visibility buffer written by the render pass available to the compute stage. The previous
+	// output is discarded as every pixel is in exactly one bin.
+	VkMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+	imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].image = visibilityBuffer.visibility.VkHandle();
+	imageBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarriers[0].subresourceRange.baseMipLevel = 0;
+	imageBarriers[0].subresourceRange.levelCount = 1;
+	imageBarriers[0].subresourceRange.baseArrayLayer = 0;
+	imageBarriers[0].subresourceRange.layerCount = 1;
+	imageBarriers[1] = imageBarriers[0];
+	imageBarriers[1].srcAccessMask = 0;
+	imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarriers[1].image = tileShadeOutput.VkHandle();
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, SCAST_U32(imageBarriers.size()), imageBarriers.data());
+
+	// Count, offset and scatter passes, each reading what the one before it wrote
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	VkMemoryBarrier binBarrier = {};
+	binBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	binBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	binBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, materialCountPipeline);
+	vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &binBarrier, 0, nullptr, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, materialOffsetsPipeline);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &binBarrier, 0, nullptr, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, materialScatterPipeline);
+	vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+
+	// Material kernels, sized by the offset pass. Bins past the shaded material count are always empty so they're skipped.
+	VkMemoryBarrier scatterBarrier = {};
+	scatterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	scatterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	scatterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &scatterBarrier, 0, nullptr, 0, nullptr);
+	for (uint32_t i = 0; i <= shadedMaterialCount; i++)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, materialShadePipelines[i]);
+		vkCmdDispatchIndirect(commandBuffer, materialBinBuffer.VkHandle(), offsetof(MaterialBinCounters, dispatches) + sizeof(VkDispatchIndirectCommand) * i);
+	}
+
+	// Shaded image is read by the composite draw
+	VkMemoryBarrier shadeBarrier = {};
+	shadeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	shadeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	shadeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &shadeBarrier, 0, nullptr, 0, nullptr);
+}
+
+// Sets up each triangle visible in the vis buff once, so the shade subpass only has to evaluate the stored attribute planes
+void VulkanApplication::RecordTriangleSetupCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset)
+{
+	// The previous frame's setup pass and shade subpass must be finished with the buffers before they're cleared
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, visibleTriangleBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+	vkCmdFillBuffer(commandBuffer, triangleSetupCounterBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+
+	// Make the cleared buffers and the visibility buffer written by the render pass available to the compute stage
+	VkMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	VkImageMemoryBarrier visibilityBarrier = {};
+	visibilityBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	visibilityBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	visibilityBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	visibilityBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	visibilityBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	visibilityBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	visibilityBarrier.image = visibilityBuffer.visibility.VkHandle();
+	visibilityBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	visibilityBarrier.subresourceRange.baseMipLevel = 0;
+	visibilityBarrier.subresourceRange.levelCount = 1;
+	visibilityBarrier.subresourceRange.baseArrayLayer = 0;
+	visibilityBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 1, &visibilityBarrier);
+
+	// One invocation per pixel
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, triangleSetupPipeline);
+	vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+
+	// Setups are read by the shade subpass. The visibility buffer goes back to the layout the resume
+	// render pass loads it from.
+	VkMemoryBarrier setupBarrier = {};
+	setupBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	setupBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	setupBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	visibilityBarrier.srcAccessMask = 0;
+	visibilityBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	visibilityBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	visibilityBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &setupBarrier, 0, nullptr, 1, &visibilityBarrier);
+}
+
+// Transforms and displaces every vis buff terrain vertex once, for the write pass to fetch and the shade pass to interpolate
+void VulkanApplication::RecordVertexTransformCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset)
+{
+	// The previous frame's subpasses must be finished reading the buffer before it's overwritten
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vertexTransformPipeline);
+	vkCmdDispatch(commandBuffer, (SCAST_U32(visBuffTerrainVertexCount) + 63) / 64, 1, 1);
+
+	VkMemoryBarrier transformBarrier = {};
+	transformBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	transformBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	transformBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &transformBarrier, 0, nullptr, 0, nullptr);
+}
+
+// Picks a shading rate for each tile from the vis buff and the previous frame's output, then shades one pixel per rate block and
+// reconstructs the rest from the pixels on the same triangle
+void VulkanApplication::RecordVrsShadeCommands(VkCommandBuffer commandBuffer, VrsPushConstants constants, uint32_t uniformOffset)
+{
+	// The previous frame's shade pass must finish before the counters are reset
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, vrsCounterBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+
+	// Make the reset counters and the visibility buffer written by the render pass available to the compute stage. Unlike the tile
+	// shade path the output stays in the general layout, as the classify pass reads what the previous frame's composite draw read.
+	VkMemoryBarrier resetBarrier = {};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+	imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].image = visibilityBuffer.visibility.VkHandle();
+	imageBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarriers[0].subresourceRange.baseMipLevel = 0;
+	imageBarriers[0].subresourceRange.levelCount = 1;
+	imageBarriers[0].subresourceRange.baseArrayLayer = 0;
+	imageBarriers[0].subresourceRange.layerCount = 1;
+	imageBarriers[1] = imageBarriers[0];
+	imageBarriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[1].image = tileShadeOutput.VkHandle();
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, SCAST_U32(imageBarriers.size()), imageBarriers.data());
+
+	// Classify pass, one workgroup per tile
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	uint32_t tilesX = (extent.width + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE;
+	uint32_t tilesY = (extent.height + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE;
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdPushConstants(commandBuffer, tileShadePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(VrsPushConstants), &constants);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vrsClassifyPipeline);
+	vkCmdDispatch(commandBuffer, tilesX, tilesY, 1);
+
+	// Shade pass over the same tiles. Its writes to the output also wait for the classify pass to finish reading it.
+	VkMemoryBarrier classifyBarrier = {};
+	classifyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	classifyBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	classifyBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &classifyBarrier, 0, nullptr, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vrsShadePipeline);
+	vkCmdDispatch(commandBuffer, tilesX, tilesY, 1);
+
+	// Shaded image is read by the composite draw
+	VkMemoryBarrier shadeBarrier = {};
+	shadeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	shadeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	shadeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &shadeBarrier, 0, nullptr, 0, nullptr);
+}
+
+void VulkanApplication::RecordTemporalShadeCommands(VkCommandBuffer commandBuffer, TemporalPushConstants constants, uint32_t uniformOffset)
+{
+	// The previous frame's pass must finish before the counters are reset
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, temporalCounterBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+
+	// Make the reset counters, the history written by the previous frame and the visibility buffer written by the render pass
+	// available to the compute stage. The output is only written, but stays in the general layout like the VRS path.
+	VkMemoryBarrier resetBarrier = {};
+	resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+	imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarriers[0].image = visibilityBuffer.visibility.VkHandle();
+	imageBarriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarriers[0].subresourceRange.baseMipLevel = 0;
+	imageBarriers[0].subresourceRange.levelCount = 1;
+	imageBarriers[0].subresourceRange.baseArrayLayer = 0;
+	imageBarriers[0].subresourceRange.layerCount = 1;
+	imageBarriers[1] = imageBarriers[0];
+	imageBarriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarriers[1].image = tileShadeOutput.VkHandle();
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &resetBarrier, 0, nullptr, SCAST_U32(imageBarriers.size()), imageBarriers.data());
+
+	// One thread per pixel in 8x8 groups, reusing or shading it and writing this frame's half of the history
+	VkExtent2D extent = vulkan->Swapchain().Extent();
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tileShadePipelineLayout, tileShadeDescSet, 3, uniformOffset);
+	vkCmdPushConstants(commandBuffer, tileShadePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(TemporalPushConstants), &constants);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, temporalShadePipeline);
+	vkCmdDispatch(commandBuffer, (extent.width + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE, (extent.height + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE, 1);
+
+	// Shaded image is read by the composite draw
+	VkMemoryBarrier shadeBarrier = {};
+	shadeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	shadeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	shadeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &shadeBarrier, 0, nullptr, 0, nullptr);
+}
+
+// Bins the vis buff terrain's triangles by screen size and rasterises the small ones into the software visibility buffer
+void VulkanApplication::RecordSwRasterCommands(VkCommandBuffer commandBuffer, SwRasterPushConstants constants, uint32_t uniformOffset)
+{
+	// The previous frame's merge draw, index fetch and indirect dispatch must finish before the buffers are reset
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, swRasterVisibilityBuffer.VkHandle(), 0, VK_WHOLE_SIZE, 0);
+	std::array<uint32_t, 4> dispatchReset = { 0, 1, 1, 0 }; // No workgroups and no small triangles
+	vkCmdUpdateBuffer(commandBuffer, swRasterDispatchBuffer.VkHandle(), 0, sizeof(dispatchReset), dispatchReset.data());
+
+	VkMemoryBarrier fillBarrier = {};
+	fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+	// Bin pass, one invocation per triangle
+	BindUniformRingDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, swRasterPipelineLayout, swRasterDescSet, 1, uniformOffset);
+	vkCmdPushConstants(commandBuffer, swRasterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SwRasterPushConstants), &constants);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, swRasterBinPipeline);
+	vkCmdDispatch(commandBuffer, (constants.triangleCount + 63) / 64, 1, 1);
+
+	// Raster pass, one invocation per small triangle, dispatched from the group count written by the bin pass
+	VkMemoryBarrier binBarrier = {};
+	binBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	binBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	binBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &binBarrier, 0, nullptr, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, swRasterPipeline);
+	vkCmdDispatchIndirect(commandBuffer, swRasterDispatchBuffer.VkHandle(), 0);
+
+	// Without 64 bit atomics the first pass only resolves depth, run it again to write the IDs of the nearest triangles
+	if (!swRasterInt64)
+	{
+		VkMemoryBarrier depthBarrier = {};
+		depthBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		depthBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &depthBarrier, 0, nullptr, 0, nullptr);
+		constants.pass = 1;
+		vkCmdPushConstants(commandBuffer, swRasterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SwRasterPushConstants), &constants);
+		vkCmdDispatchIndirect(commandBuffer, swRasterDispatchBuffer.VkHandle(), 0);
 	}
+
+	// Software visibility buffer is read by the merge draw, and the binned indices by the write pass
+	VkMemoryBarrier rasterBarrier = {};
+	rasterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	rasterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	rasterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &rasterBarrier, 0, nullptr, 0, nullptr);
 }
 #pragma endregion
 
@@ -1391,9 +3885,6 @@ void VulkanApplication::CreateDepthResources()
 	// Create Image and ImageView objects
 	depthImage.Create(vulkan->Swapchain().Extent().width, vulkan->Swapchain().Extent().height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
 	depthImage.CreateImageView(vulkan->Device(), VK_IMAGE_ASPECT_DEPTH_BIT);
-
-	// Transition depth image for shader usage
-	depthImage.TransitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, vulkan->Device(), vulkan->PhysDevice(), commandPool);
 }
 
 VkFormat VulkanApplication::FindDepthFormat()
@@ -1429,15 +3920,196 @@ VkFormat VulkanApplication::FindSupportedFormat(const std::vector<VkFormat>& can
 #pragma region Buffer Functions
 void VulkanApplication::CreateUniformBuffers()
 {
-	VkDeviceSize bufferSize = sizeof(MVPUniformBufferObject);
+	// Terrain transform matrices, render settings and the directional light share one persistently mapped ring. Each frame
+	// context writes its own slice, so the host never touches memory a frame still in flight is reading.
+	std::vector<VkDeviceSize> regionSizes(UNIFORM_REGION_COUNT);
+	regionSizes[UNIFORM_REGION_MVP] = sizeof(MVPUniformBufferObject);
+	regionSizes[UNIFORM_REGION_SETTINGS] = sizeof(SettingsUBO);
+	regionSizes[UNIFORM_REGION_LIGHT] = sizeof(DirectionalLightUBO);
+	uniformRing.Create(regionSizes, MAX_FRAMES_IN_FLIGHT, vulkan->PhysDevice().MinUniformBufferOffsetAlignment(), allocator);
+	statistics.uniformRingDeviceLocal = uniformRing.DeviceLocal();
+}
+
+// Storage for the displaced triangles appended by the tessellation geometry stage when triangle records are enabled. The full
+// buffer is only allocated once records are first enabled, until then a single record keeps the descriptors valid.
+void VulkanApplication::CreateTessRecordBuffers()
+{
+	renderSettingsUbo.tessRecordCapacity = 0;
+	tessRecordBuffer.Create(sizeof(TessTriangleRecord), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// Counter is reset on the GPU each frame and copied out for the host
+	tessRecordCounterBuffer.Create(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	statistics.tessRecordCapacity = renderSettingsUbo.tessRecordCapacity;
+	statistics.tessRecordBufferSize = 0;
+}
+
+// Replaces the placeholder record buffer with one sized for every patch tessellated at the maximum factor, so it can never
+// overflow from the UI, and points the write and shade sets at it
+void VulkanApplication::GrowTessRecordBuffer()
+{
+	if (renderSettingsUbo.tessRecordCapacity > 0)
+		return;
+
+	int maxTriangleCount = std::max(tessTerrainTriCount * CalculateTriangleSubdivision(MAX_TESSELLATION_FACTOR), tessQuadPatchCount * CalculateQuadSubdivision(MAX_TESSELLATION_FACTOR));
+	VkDeviceSize bufferSize = sizeof(TessTriangleRecord) * SCAST_U32(maxTriangleCount);
+	vkDeviceWaitIdle(vulkan->Device());
+	tessRecordBuffer.CleanUp(allocator);
+	tessRecordBuffer.Create(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	renderSettingsUbo.tessRecordCapacity = SCAST_U32(maxTriangleCount);
+
+	std::vector<VkWriteDescriptorSet> recordWrites;
+	tessRecordBuffer.SetupDescriptor();
+	tessRecordBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	recordWrites.push_back(tessRecordBuffer.WriteDescriptorSet());
+	for (size_t i = 0; i < tessShadePassDescSets.size(); i++)
+	{
+		tessRecordBuffer.SetupDescriptorWriteSet(tessShadePassDescSets[i], 12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		recordWrites.push_back(tessRecordBuffer.WriteDescriptorSet());
+		tessRecordBuffer.SetupDescriptorWriteSet(tessQuadShadePassDescSets[i], 12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		recordWrites.push_back(tessRecordBuffer.WriteDescriptorSet());
+	}
+	vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(recordWrites.size()), recordWrites.data(), 0, nullptr);
+	sceneResourceGeneration++; // The cached scene binds the sets that were just updated
+
+	statistics.tessRecordCapacity = renderSettingsUbo.tessRecordCapacity;
+	statistics.tessRecordBufferSize = bufferSize;
+}
+
+// Per patch coverage and tess factors, and per vertex tess factors, for feedback-driven tessellation
+void VulkanApplication::CreateTessFeedbackBuffers()
+{
+	// Sized for whichever patch terrain is larger so both can share the buffers
+	VkDeviceSize patchBufferSize = sizeof(uint32_t) * std::max(tessTerrainTriCount, tessQuadPatchCount);
+	tessPatchCoverageBuffer.Create(patchBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	tessPatchFactorBuffer.Create(patchBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	VkDeviceSize vertexBufferSize = sizeof(float) * std::max(tessTerrain.Vertices().size(), tessQuadTerrain.Vertices().size());
+	tessVertexFactorBuffer.Create(vertexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
+
+// Binned index buffer, small triangle list, indirect raster dispatch and per pixel depth and ID pairs for the software rasteriser
+void VulkanApplication::CreateSwRasterBuffers()
+{
+	VkDeviceSize indexBufferSize = sizeof(uint32_t) * visBuffTerrain.Indices().size();
+	swRasterIndexBuffer.Create(indexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	swRasterTriangleBuffer.Create(sizeof(uint32_t) * visBuffTerrainTriCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// Dispatch arguments are reset on the GPU each frame and the small triangle count is copied out for the host
+	swRasterDispatchBuffer.Create(sizeof(uint32_t) * 4, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// 64 bits per pixel for the startup swapchain size
+	swRasterExtent = vulkan->Swapchain().Extent();
+	VkDeviceSize visibilityBufferSize = sizeof(uint64_t) * swRasterExtent.width * swRasterExtent.height;
+	swRasterVisibilityBuffer.Create(visibilityBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
+
+// Per class tile lists and the indirect dispatch arguments written by the classify pass
+void VulkanApplication::CreateTileShadeBuffers()
+{
+	tileShadeExtent = vulkan->Swapchain().Extent();
+	VkDeviceSize tileCount = ((tileShadeExtent.width + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE) * ((tileShadeExtent.height + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE);
+	tileListBuffer.Create(sizeof(uint32_t) * 2 * tileCount * TILE_SHADE_CLASS_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// Tile counts are copied out for statistics
+	tileDispatchBuffer.Create(sizeof(VkDispatchIndirectCommand) * TILE_SHADE_CLASS_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
+
+// Bin counters, the compacted pixel lists, the material ID and material tables, and the indirect draws of the multi-material scene
+void VulkanApplication::CreateMaterialShadeBuffers()
+{
+	// Bin sizes are copied out for statistics
+	materialBinBuffer.Create(sizeof(MaterialBinCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// Packed pixel coordinates and visibility ID per pixel for the startup swapchain size
+	materialShadeExtent = vulkan->Swapchain().Extent();
+	materialPixelBuffer.Create(sizeof(uint32_t) * 2 * materialShadeExtent.width * materialShadeExtent.height, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	std::array<MaterialInfo, MATERIAL_COUNT_MAX> materials = SCENE_MATERIALS;
+	materialBuffer.Create(sizeof(MaterialInfo) * MATERIAL_COUNT_MAX, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+	materialBuffer.MapData(materials.data(), allocator);
+	materialDrawBuffer.Create(sizeof(MaterialDrawInfo) * MATERIAL_DRAW_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+	UpdateMaterialDrawTable(materialCount);
+
+	// Split the vis buff terrain into contiguous runs of triangles, drawn with one multi draw so each gets its own draw ID
+	uint32_t triangleCount = SCAST_U32(visBuffTerrainTriCount);
+	uint32_t trianglesPerDraw = (triangleCount + MATERIAL_DRAW_COUNT - 1) / MATERIAL_DRAW_COUNT;
+	std::array<VkDrawIndexedIndirectCommand, MATERIAL_DRAW_COUNT> drawCommands = {};
+	for (uint32_t i = 0; i < MATERIAL_DRAW_COUNT; i++)
+	{
+		uint32_t firstTriangle = std::min(i * trianglesPerDraw, triangleCount);
+		drawCommands[i].indexCount = std::min(trianglesPerDraw, triangleCount - firstTriangle) * 3;
+		drawCommands[i].instanceCount = 1;
+		drawCommands[i].firstIndex = firstTriangle * 3;
+	}
+	visBuffDrawCommandBuffer.Create(sizeof(VkDrawIndexedIndirectCommand) * MATERIAL_DRAW_COUNT, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+	visBuffDrawCommandBuffer.MapData(drawCommands.data(), allocator);
+}
+
+// Fills the material ID table, materials are assigned to the scene's draws round robin so each one covers several bands of terrain
+void VulkanApplication::UpdateMaterialDrawTable(uint32_t tableMaterialCount)
+{
+	// The table is read by the binning and shading passes, so wait until the last frame is done with it
+	vkDeviceWaitIdle(vulkan->Device());
+
+	uint32_t trianglesPerDraw = (SCAST_U32(visBuffTerrainTriCount) + MATERIAL_DRAW_COUNT - 1) / MATERIAL_DRAW_COUNT;
+	std::array<MaterialDrawInfo, MATERIAL_DRAW_COUNT> drawTable = {};
+	for (uint32_t i = 0; i < MATERIAL_DRAW_COUNT; i++)
+	{
+		drawTable[i].firstTriangle = i * trianglesPerDraw;
+		drawTable[i].materialID = i % tableMaterialCount;
+	}
+	materialDrawBuffer.MapData(drawTable.data(), allocator);
+}
+
+// Attribute planes for every vis buff terrain triangle, the visible triangle bitmask and the setup pass counters
+void VulkanApplication::CreateTriangleSetupBuffers()
+{
+	VkDeviceSize triangleCount = SCAST_U32(visBuffTerrainTriCount);
+	triangleSetupBuffer.Create(sizeof(TriangleSetupEntry) * triangleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	visibleTriangleBuffer.Create(sizeof(uint32_t) * ((triangleCount + 31) / 32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+
+	// Counts are copied out for statistics
+	triangleSetupCounterBuffer.Create(sizeof(TriangleSetupCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
+
+// One transformed vertex per vis buff terrain vertex
+void VulkanApplication::CreatePostTransformBuffers()
+{
+	transformedVertexBuffer.Create(sizeof(TransformedVertex) * SCAST_U32(visBuffTerrainVertexCount), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
+
+// Counts are copied out for statistics
+void VulkanApplication::CreateSubgroupFetchBuffers()
+{
+	subgroupFetchCounterBuffer.Create(sizeof(SubgroupFetchCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
 
-	// Create uniform buffer terrain transform matrices
-	mvpUniformBuffer.Create(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+// Rates are sized for the tile lists' extent, counts are copied out for statistics
+void VulkanApplication::CreateVrsBuffers()
+{
+	VkDeviceSize tileCount = ((tileShadeExtent.width + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE) * ((tileShadeExtent.height + TILE_SHADE_SIZE - 1) / TILE_SHADE_SIZE);
+	vrsRateBuffer.Create(sizeof(uint32_t) * tileCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	vrsCounterBuffer.Create(sizeof(VrsCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
 
-	bufferSize = sizeof(SettingsUBO);
+void VulkanApplication::CreateTemporalBuffers()
+{
+	// Two frames of history for the largest extent the tile shade output covers
+	VkDeviceSize pixelCount = (VkDeviceSize)tileShadeExtent.width * tileShadeExtent.height;
+	temporalHistoryBuffer.Create(sizeof(glm::uvec2) * pixelCount * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+	temporalCounterBuffer.Create(sizeof(TemporalCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocator);
+}
 
-	// Create tess factor UBO for tessellation pipeline
-	settingsBuffer.Create(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+// One persistently mapped readback per frame context, zeroed so a context read before it's been submitted reports nothing
+void VulkanApplication::CreateCounterReadbackBuffers()
+{
+	for (FrameContext& frame : frames)
+	{
+		frame.counterReadback.Create(sizeof(CounterReadback), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocator);
+		frame.counterReadback.Map(allocator);
+		memset(frame.counterReadback.mappedRange, 0, sizeof(CounterReadback));
+	}
 }
 
 void VulkanApplication::UpdateUniformBuffers()
@@ -1454,20 +4126,26 @@ void VulkanApplication::UpdateUniformBuffers()
 	projMatrix[1][1] *= -1; // Flip Y of projection matrix to account for OpenGL's flipped Y clip axis
 	glm::mat4 inverseViewProj = glm::inverse((projMatrix * viewMatrix));
 
-	// Fill MVP Uniform Buffer
-	MVPUniformBufferObject ubo = {};
-	ubo.mvp = (projMatrix * viewMatrix) * modelMatrix;
-	ubo.proj = projMatrix;
-	//ubo.invViewProj = inverseViewProj;
-
-	// Now map the memory to mvp uniform buffer
-	mvpUniformBuffer.MapData(&ubo, allocator);
-
-	// Map rendering settings to ubo
-	settingsBuffer.MapData(&renderSettingsUbo, allocator);
+	// Fill MVP Uniform Buffer contents, written into the frame context's ring slice before its command buffer is submitted
+	mvpUbo = {};
+	mvpUbo.mvp = (projMatrix * viewMatrix) * modelMatrix;
+	mvpUbo.proj = projMatrix;
+	//mvpUbo.invViewProj = inverseViewProj;
+	previousMvp = currentMvp; // Kept for the temporal reuse pass to reproject into last frame's history
+	currentMvp = mvpUbo.mvp;
+}
 
-	// Update light ubo
-	light.UpdateUBO(allocator);
+// Copies this frame's uniforms into its slice of the ring. Host writes made before the submit are visible to the frame without
+// a barrier, and the slice's last reader has finished as the frame context's fence was waited on.
+void VulkanApplication::WriteUniformSlice(uint32_t slice)
+{
+	auto writeStart = std::chrono::high_resolution_clock::now();
+	DirectionalLightUBO lightUbo = light.UBOData();
+	uniformRing.Write(slice, UNIFORM_REGION_MVP, &mvpUbo);
+	uniformRing.Write(slice, UNIFORM_REGION_SETTINGS, &renderSettingsUbo);
+	uniformRing.Write(slice, UNIFORM_REGION_LIGHT, &lightUbo);
+	uniformRing.FlushSlice(slice, allocator);
+	statistics.uniformWriteTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - writeStart).count();
 }
 
 void VulkanApplication::CreateVmaAllocator()
@@ -1477,26 +4155,37 @@ void VulkanApplication::CreateVmaAllocator()
 	allocatorInfo.device = vulkan->Device();
 	vmaCreateAllocator(&allocatorInfo, &allocator);
 }
+
+// Uploads use the transfer queue's family when the device has one just for transfers, the graphics family otherwise
+void VulkanApplication::CreateUploadManager()
+{
+	QueueFamilyIndices queueFamilyIndices = PhysicalDevice::FindQueueFamilies(vulkan->PhysDevice().VkHandle(), vulkan->Swapchain().Surface());
+	uint32_t graphicsFamily = queueFamilyIndices.graphicsFamily.value();
+	DeviceQueues queues = *vulkan->PhysDevice().Queues();
+	uploadManager.Init(vulkan->Device(), graphicsFamily, queueFamilyIndices.transferFamily.value_or(graphicsFamily), &queues, allocator);
+}
 #pragma endregion
 
 #pragma region Descriptor Functions
 void VulkanApplication::CreateDescriptorPool()
 {
-	std::array<VkDescriptorPoolSize, 4> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 6) + 3; // mvp UBO, light UBO and settings UBO per swapchain image plus mvp ubo for the write pass plus mvp ubo and settings for tess write pass
+	std::array<VkDescriptorPoolSize, 5> poolSizes = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSizes[0].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 9) + 9; // mvp UBO, light UBO and settings UBO per swapchain image per shade set plus mvp ubo for the write pass plus mvp ubo and settings for tess write pass plus settings for both feedback sets plus mvp ubo for the software raster set plus mvp, light and settings for the tile shade set
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 6) + 2; // terrain texture and heightmap and normalmap per swapchain image per pipeline plus two for the write pipelines
+	poolSizes[1].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 9) + 6; // terrain texture and heightmap and normalmap per swapchain image per shade set plus two for the write pipelines plus heightmap for the software raster set plus texture, heightmap and normalmap for the tile shade set
 	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	poolSizes[2].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 2) * 2; // 2 storage buffers per swapchain image per shade pass
+	poolSizes[2].descriptorCount = (SCAST_U32(vulkan->Swapchain().Images().size()) * 4) * 3 + SCAST_U32(vulkan->Swapchain().Images().size()) + 1 + 3 + 8 + 6 + 16; // index, attribute, subgroup fetch counter and record or setup cache buffers per swapchain image per shade set plus transformed vertices for the vis buff shade sets, plus transformed vertices for the write pass, plus record, counter and vertex factor buffers for the tess write pass, plus 4 per feedback set, plus 6 for the software raster set, plus 16 for the tile, material, triangle setup, vertex transform, VRS and temporal reuse set
 	poolSizes[3].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	poolSizes[3].descriptorCount = SCAST_U32(vulkan->Swapchain().Images().size()) * 5; // 5 input attachment per swapchain image (vis buff + tessvisbuff + 3 tesscoords)
+	poolSizes[3].descriptorCount = SCAST_U32(vulkan->Swapchain().Images().size()) * 9; // 9 input attachments per swapchain image (vis buff + 2 * (tessvisbuff + 3 tesscoords))
+	poolSizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[4].descriptorCount = 4; // Tess vis buff for each feedback set, vis buff and shaded output for the tile shade set
 
 	VkDescriptorPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.poolSizeCount = SCAST_U32(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = (SCAST_U32(vulkan->Swapchain().Images().size()) * 2) + 2; // 2 descriptor set per swapchain image, one for the write pass and one for the tess write pass
+	poolInfo.maxSets = (SCAST_U32(vulkan->Swapchain().Images().size()) * 3) + 6; // 3 shade descriptor sets per swapchain image, one for the write pass, one for the tess write pass, two for tess feedback, one for the software rasteriser and one for tile shading
 
 	if (vkCreateDescriptorPool(vulkan->Device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
 	{
@@ -1524,7 +4213,7 @@ void VulkanApplication::CreateShadePassDescriptorSetLayouts()
 	// Binding 2: MVP Uniform Buffer
 	VkDescriptorSetLayoutBinding modelUboLayoutBinding = {};
 	modelUboLayoutBinding.binding = 2;
-	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	modelUboLayoutBinding.descriptorCount = 1;
 	modelUboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT; 
 
@@ -1545,7 +4234,7 @@ void VulkanApplication::CreateShadePassDescriptorSetLayouts()
 	// Binding 5: Render Settings Buffer
 	VkDescriptorSetLayoutBinding settingsBufferBinding = {};
 	settingsBufferBinding.binding = 5;
-	settingsBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	settingsBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	settingsBufferBinding.descriptorCount = 1;
 	settingsBufferBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -1566,7 +4255,7 @@ void VulkanApplication::CreateShadePassDescriptorSetLayouts()
 	// Binding 8: Directional light UBO
 	VkDescriptorSetLayoutBinding lightUboBinding = {};
 	lightUboBinding.binding = 8;
-	lightUboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	lightUboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	lightUboBinding.descriptorCount = 1;
 	lightUboBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -1591,8 +4280,27 @@ void VulkanApplication::CreateShadePassDescriptorSetLayouts()
 	tessBufferBinding3.descriptorCount = 1;
 	tessBufferBinding3.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+	// Binding 12: Triangle record buffer (Tessellation pipeline only)
+	VkDescriptorSetLayoutBinding tessRecordBufferBinding = {};
+	tessRecordBufferBinding.binding = 12;
+	tessRecordBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	tessRecordBufferBinding.descriptorCount = 1;
+	tessRecordBufferBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	// Binding 9: Triangle setup cache (Visibility Buffer pipeline only)
+	VkDescriptorSetLayoutBinding triangleSetupBinding = tessRecordBufferBinding;
+	triangleSetupBinding.binding = 9;
+
+	// Binding 10: Transformed vertex buffer (Visibility Buffer pipeline only)
+	VkDescriptorSetLayoutBinding transformedVertexBinding = tessRecordBufferBinding;
+	transformedVertexBinding.binding = 10;
+
+	// Binding 13: Subgroup fetch counters (both pipelines)
+	VkDescriptorSetLayoutBinding subgroupFetchCounterBinding = tessRecordBufferBinding;
+	subgroupFetchCounterBinding.binding = 13;
+
 	// Create descriptor set layout for Visibility Buffer Pipeline
-	std::array<VkDescriptorSetLayoutBinding, 9> visBuffBindings = { modelUboLayoutBinding, textureSamplerBinding, visBufferBinding, indexBufferBinding, attributeBufferBinding, settingsBufferBinding, heightmapLayoutBinding, normalmapLayoutBinding, lightUboBinding };
+	std::array<VkDescriptorSetLayoutBinding, 12> visBuffBindings = { modelUboLayoutBinding, textureSamplerBinding, visBufferBinding, indexBufferBinding, attributeBufferBinding, settingsBufferBinding, heightmapLayoutBinding, normalmapLayoutBinding, lightUboBinding, triangleSetupBinding, transformedVertexBinding, subgroupFetchCounterBinding };
 	VkDescriptorSetLayoutCreateInfo visBuffLayoutInfo = {};
 	visBuffLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	visBuffLayoutInfo.bindingCount = SCAST_U32(visBuffBindings.size());
@@ -1603,7 +4311,7 @@ void VulkanApplication::CreateShadePassDescriptorSetLayouts()
 	}
 
 	// Create descriptor set layout for Tessellation Pipeline
-	std::array<VkDescriptorSetLayoutBinding, 12> tessBindings = { modelUboLayoutBinding, textureSamplerBinding, visBufferBinding, indexBufferBinding, attributeBufferBinding, settingsBufferBinding, heightmapLayoutBinding, normalmapLayoutBinding, lightUboBinding, tessBufferBinding1, tessBufferBinding2, tessBufferBinding3 };
+	std::array<VkDescriptorSetLayoutBinding, 14> tessBindings = { modelUboLayoutBinding, textureSamplerBinding, visBufferBinding, indexBufferBinding, attributeBufferBinding, settingsBufferBinding, heightmapLayoutBinding, normalmapLayoutBinding, lightUboBinding, tessBufferBinding1, tessBufferBinding2, tessBufferBinding3, tessRecordBufferBinding, subgroupFetchCounterBinding };
 	VkDescriptorSetLayoutCreateInfo tessLayoutInfo = {};
 	tessLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	tessLayoutInfo.bindingCount = SCAST_U32(tessBindings.size());
@@ -1620,7 +4328,7 @@ void VulkanApplication::CreateVisBuffWritePassDescriptorSetLayout()
 	// Binding 0: Vertex Shader Uniform Buffer of loaded model
 	VkDescriptorSetLayoutBinding modelUboLayoutBinding = {};
 	modelUboLayoutBinding.binding = 0;
-	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	modelUboLayoutBinding.descriptorCount = 1;
 	modelUboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Specify that this descriptor will be used in the vertex shader
 
@@ -1631,8 +4339,15 @@ void VulkanApplication::CreateVisBuffWritePassDescriptorSetLayout()
 	heightmapLayoutBinding.descriptorCount = 1;
 	heightmapLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
+	// Binding 2: Transformed vertex buffer, read by the post-transform write pipeline
+	VkDescriptorSetLayoutBinding transformedVertexBinding = {};
+	transformedVertexBinding.binding = 2;
+	transformedVertexBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	transformedVertexBinding.descriptorCount = 1;
+	transformedVertexBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
 	// Create descriptor set layout
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = { modelUboLayoutBinding, heightmapLayoutBinding };
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings = { modelUboLayoutBinding, heightmapLayoutBinding, transformedVertexBinding };
 	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = SCAST_U32(bindings.size());
@@ -1650,14 +4365,14 @@ void VulkanApplication::CreateTessWritePassDescriptorSetLayout()
 	// Binding 0: Render settings UBO for hull shader tess factor
 	VkDescriptorSetLayoutBinding tessFactorLayoutBinding = {};
 	tessFactorLayoutBinding.binding = 0;
-	tessFactorLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	tessFactorLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	tessFactorLayoutBinding.descriptorCount = 1;
-	tessFactorLayoutBinding.stageFlags = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; // Specify that this descriptor will be used in the hull shader
+	tessFactorLayoutBinding.stageFlags = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_GEOMETRY_BIT; // Specify that this descriptor will be used in the hull shader and record capacity in the geometry shader
 
 	// Binding 1: Domain Shader MVP Buffer of terrain
 	VkDescriptorSetLayoutBinding modelUboLayoutBinding = {};
 	modelUboLayoutBinding.binding = 1;
-	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	modelUboLayoutBinding.descriptorCount = 1;
 	modelUboLayoutBinding.stageFlags = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; // Specify that this descriptor will be used in the domain shader
 
@@ -1668,8 +4383,29 @@ void VulkanApplication::CreateTessWritePassDescriptorSetLayout()
 	heightmapLayoutBinding.descriptorCount = 1;
 	heightmapLayoutBinding.stageFlags = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
 
+	// Binding 3: Triangle record buffer
+	VkDescriptorSetLayoutBinding recordBufferLayoutBinding = {};
+	recordBufferLayoutBinding.binding = 3;
+	recordBufferLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	recordBufferLayoutBinding.descriptorCount = 1;
+	recordBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
+
+	// Binding 4: Triangle record counter
+	VkDescriptorSetLayoutBinding recordCounterLayoutBinding = {};
+	recordCounterLayoutBinding.binding = 4;
+	recordCounterLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	recordCounterLayoutBinding.descriptorCount = 1;
+	recordCounterLayoutBinding.stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
+
+	// Binding 5: Feedback tess factor per terrain vertex
+	VkDescriptorSetLayoutBinding vertexFactorLayoutBinding = {};
+	vertexFactorLayoutBinding.binding = 5;
+	vertexFactorLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vertexFactorLayoutBinding.descriptorCount = 1;
+	vertexFactorLayoutBinding.stageFlags = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+
 	// Create descriptor set layout
-	std::array<VkDescriptorSetLayoutBinding, 3> bindings = { tessFactorLayoutBinding, modelUboLayoutBinding, heightmapLayoutBinding };
+	std::array<VkDescriptorSetLayoutBinding, 6> bindings = { tessFactorLayoutBinding, modelUboLayoutBinding, heightmapLayoutBinding, recordBufferLayoutBinding, recordCounterLayoutBinding, vertexFactorLayoutBinding };
 	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = SCAST_U32(bindings.size());
@@ -1681,6 +4417,198 @@ void VulkanApplication::CreateTessWritePassDescriptorSetLayout()
 	}
 }
 
+void VulkanApplication::CreateTessFeedbackDescriptorSetLayout()
+{
+	// Descriptor layout for the tess factor feedback compute passes
+	// Binding 0: Render settings UBO for feedback parameters
+	VkDescriptorSetLayoutBinding settingsLayoutBinding = {};
+	settingsLayoutBinding.binding = 0;
+	settingsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	settingsLayoutBinding.descriptorCount = 1;
+	settingsLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// Binding 1: Tess visibility buffer
+	VkDescriptorSetLayoutBinding visibilityLayoutBinding = {};
+	visibilityLayoutBinding.binding = 1;
+	visibilityLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	visibilityLayoutBinding.descriptorCount = 1;
+	visibilityLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// Binding 2 - 5: Patch coverage, patch factors, vertex factors and terrain index buffer
+	VkDescriptorSetLayoutBinding coverageLayoutBinding = {};
+	coverageLayoutBinding.binding = 2;
+	coverageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	coverageLayoutBinding.descriptorCount = 1;
+	coverageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutBinding patchFactorLayoutBinding = coverageLayoutBinding;
+	patchFactorLayoutBinding.binding = 3;
+	VkDescriptorSetLayoutBinding vertexFactorLayoutBinding = coverageLayoutBinding;
+	vertexFactorLayoutBinding.binding = 4;
+	VkDescriptorSetLayoutBinding indexBufferLayoutBinding = coverageLayoutBinding;
+	indexBufferLayoutBinding.binding = 5;
+
+	// Create descriptor set layout
+	std::array<VkDescriptorSetLayoutBinding, 6> bindings = { settingsLayoutBinding, visibilityLayoutBinding, coverageLayoutBinding, patchFactorLayoutBinding, vertexFactorLayoutBinding, indexBufferLayoutBinding };
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = SCAST_U32(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(vulkan->Device(), &layoutInfo, nullptr, &tessFeedbackDescSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create tess feedback descriptor set layout");
+	}
+}
+
+void VulkanApplication::CreateSwRasterDescriptorSetLayout()
+{
+	// Descriptor layout for the software raster compute passes and merge draw
+	// Binding 0: Vertex Shader Uniform Buffer of loaded model
+	VkDescriptorSetLayoutBinding modelUboLayoutBinding = {};
+	modelUboLayoutBinding.binding = 0;
+	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	modelUboLayoutBinding.descriptorCount = 1;
+	modelUboLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// Binding 1: Heightmap texture sampler
+	VkDescriptorSetLayoutBinding heightmapLayoutBinding = {};
+	heightmapLayoutBinding.binding = 1;
+	heightmapLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	heightmapLayoutBinding.descriptorCount = 1;
+	heightmapLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// Binding 2 - 6: Attribute and index buffers of the terrain, binned index buffer, small triangle list and raster dispatch arguments
+	VkDescriptorSetLayoutBinding attributeBufferLayoutBinding = {};
+	attributeBufferLayoutBinding.binding = 2;
+	attributeBufferLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	attributeBufferLayoutBinding.descriptorCount = 1;
+	attributeBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutBinding indexBufferLayoutBinding = attributeBufferLayoutBinding;
+	indexBufferLayoutBinding.binding = 3;
+	VkDescriptorSetLayoutBinding binnedIndexBufferLayoutBinding = attributeBufferLayoutBinding;
+	binnedIndexBufferLayoutBinding.binding = 4;
+	VkDescriptorSetLayoutBinding triangleBufferLayoutBinding = attributeBufferLayoutBinding;
+	triangleBufferLayoutBinding.binding = 5;
+	VkDescriptorSetLayoutBinding dispatchBufferLayoutBinding = attributeBufferLayoutBinding;
+	dispatchBufferLayoutBinding.binding = 6;
+
+	// Binding 7: Software visibility buffer, also read by the merge draw
+	VkDescriptorSetLayoutBinding visibilityBufferLayoutBinding = attributeBufferLayoutBinding;
+	visibilityBufferLayoutBinding.binding = 7;
+	visibilityBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	// Create descriptor set layout
+	std::array<VkDescriptorSetLayoutBinding, 8> bindings = { modelUboLayoutBinding, heightmapLayoutBinding, attributeBufferLayoutBinding, indexBufferLayoutBinding, binnedIndexBufferLayoutBinding, triangleBufferLayoutBinding, dispatchBufferLayoutBinding, visibilityBufferLayoutBinding };
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = SCAST_U32(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(vulkan->Device(), &layoutInfo, nullptr, &swRasterDescSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create software raster descriptor set layout");
+	}
+}
+
+void VulkanApplication::CreateTileShadeDescriptorSetLayout()
+{
+	// Descriptor layout for the tile and material shade compute passes and composite draw, follows the shade pass bindings where they overlap
+	// Binding 0: Model texture sampler
+	VkDescriptorSetLayoutBinding textureSamplerBinding = {};
+	textureSamplerBinding.binding = 0;
+	textureSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureSamplerBinding.descriptorCount = 1;
+	textureSamplerBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// Binding 1: Visibility Buffer, transitioned to general layout after the write subpass
+	VkDescriptorSetLayoutBinding visBufferBinding = textureSamplerBinding;
+	visBufferBinding.binding = 1;
+	visBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+	// Binding 2: MVP Uniform Buffer
+	VkDescriptorSetLayoutBinding modelUboLayoutBinding = textureSamplerBinding;
+	modelUboLayoutBinding.binding = 2;
+	modelUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+	// Binding 3 - 4: Index and Vertex Attribute Buffers
+	VkDescriptorSetLayoutBinding indexBufferBinding = textureSamplerBinding;
+	indexBufferBinding.binding = 3;
+	indexBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	VkDescriptorSetLayoutBinding attributeBufferBinding = indexBufferBinding;
+	attributeBufferBinding.binding = 4;
+
+	// Binding 5: Render Settings Buffer
+	VkDescriptorSetLayoutBinding settingsBufferBinding = modelUboLayoutBinding;
+	settingsBufferBinding.binding = 5;
+
+	// Binding 6 - 7: Heightmap and Normalmap texture samplers
+	VkDescriptorSetLayoutBinding heightmapLayoutBinding = textureSamplerBinding;
+	heightmapLayoutBinding.binding = 6;
+	VkDescriptorSetLayoutBinding normalmapLayoutBinding = textureSamplerBinding;
+	normalmapLayoutBinding.binding = 7;
+
+	// Binding 8: Directional light UBO
+	VkDescriptorSetLayoutBinding lightUboBinding = modelUboLayoutBinding;
+	lightUboBinding.binding = 8;
+
+	// Binding 9: Shaded output, also read by the composite draw
+	VkDescriptorSetLayoutBinding outputBinding = visBufferBinding;
+	outputBinding.binding = 9;
+	outputBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	// Binding 10 - 11: Tile lists and class dispatch arguments
+	VkDescriptorSetLayoutBinding tileListBinding = indexBufferBinding;
+	tileListBinding.binding = 10;
+	VkDescriptorSetLayoutBinding tileDispatchBinding = indexBufferBinding;
+	tileDispatchBinding.binding = 11;
+
+	// Binding 12 - 15: Material bins, compacted pixel lists, material ID table and materials, used by the material binned shading passes
+	VkDescriptorSetLayoutBinding materialBinBinding = indexBufferBinding;
+	materialBinBinding.binding = 12;
+	VkDescriptorSetLayoutBinding materialPixelBinding = indexBufferBinding;
+	materialPixelBinding.binding = 13;
+	VkDescriptorSetLayoutBinding materialDrawBinding = indexBufferBinding;
+	materialDrawBinding.binding = 14;
+	VkDescriptorSetLayoutBinding materialBinding = indexBufferBinding;
+	materialBinding.binding = 15;
+
+	// Binding 16 - 18: Triangle setup cache, visible triangle bitmask and counters, written by the triangle setup pass
+	VkDescriptorSetLayoutBinding triangleSetupBinding = indexBufferBinding;
+	triangleSetupBinding.binding = 16;
+	VkDescriptorSetLayoutBinding visibleTriangleBinding = indexBufferBinding;
+	visibleTriangleBinding.binding = 17;
+	VkDescriptorSetLayoutBinding triangleSetupCounterBinding = indexBufferBinding;
+	triangleSetupCounterBinding.binding = 18;
+
+	// Binding 19: Transformed vertex buffer, written by the vertex transform pass
+	VkDescriptorSetLayoutBinding transformedVertexBinding = indexBufferBinding;
+	transformedVertexBinding.binding = 19;
+
+	// Binding 20 - 21: Tile shading rates and counters, used by the VRS passes
+	VkDescriptorSetLayoutBinding vrsRateBinding = indexBufferBinding;
+	vrsRateBinding.binding = 20;
+	VkDescriptorSetLayoutBinding vrsCounterBinding = indexBufferBinding;
+	vrsCounterBinding.binding = 21;
+
+	// Binding 22 - 23: History and counters, used by the temporal reuse pass
+	VkDescriptorSetLayoutBinding temporalHistoryBinding = indexBufferBinding;
+	temporalHistoryBinding.binding = 22;
+	VkDescriptorSetLayoutBinding temporalCounterBinding = indexBufferBinding;
+	temporalCounterBinding.binding = 23;
+
+	// Create descriptor set layout
+	std::array<VkDescriptorSetLayoutBinding, 24> bindings = { textureSamplerBinding, visBufferBinding, modelUboLayoutBinding, indexBufferBinding, attributeBufferBinding, settingsBufferBinding, heightmapLayoutBinding, normalmapLayoutBinding, lightUboBinding, outputBinding, tileListBinding, tileDispatchBinding, materialBinBinding, materialPixelBinding, materialDrawBinding, materialBinding, triangleSetupBinding, visibleTriangleBinding, triangleSetupCounterBinding, transformedVertexBinding, vrsRateBinding, vrsCounterBinding, temporalHistoryBinding, temporalCounterBinding };
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = SCAST_U32(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(vulkan->Device(), &layoutInfo, nullptr, &tileShadeDescSetLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create tile shade descriptor set layout");
+	}
+}
+
 // Create the descriptor sets for the shade pass, containing the visibility buffer images (for each swapchain image)
 void VulkanApplication::CreateShadePassDescriptorSets()
 {
@@ -1708,59 +4636,68 @@ void VulkanApplication::CreateShadePassDescriptorSets()
 		throw std::runtime_error("Failed to allocate tess shade pass descriptor sets");
 	}
 
+	// Allocate tess quad patch shade pass descriptor set, same layout but bound to the quad terrain buffers
+	tessQuadShadePassDescSets.resize(vulkan->Swapchain().Images().size());
+	if (vkAllocateDescriptorSets(vulkan->Device(), &shadePassAllocInfo, tessQuadShadePassDescSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate tess quad shade pass descriptor sets");
+	}
+
 	// Configure the descriptors
 	for (size_t i = 0; i < vulkan->Swapchain().Images().size(); i++)
 	{
 		// Terrain texture sampler
-		visBuffTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
+		visBuffTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
 
-		// Visibility Buffer attachment
-		visibilityBuffer.visibility.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE);
-		visibilityBuffer.visibility.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1);
-
-		// Terrain UBO
-		mvpUniformBuffer.SetupDescriptor(sizeof(MVPUniformBufferObject), 0);
-		mvpUniformBuffer.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
+		// Visibility Buffer attachment, the per-sample one when multisampled
+		Image& visibilityAttachment = visBuffSampleCount == VK_SAMPLE_COUNT_1_BIT ? visibilityBuffer.visibility : visibilityBuffer.msaaVisibility;
+		visibilityAttachment.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE);
+		visibilityAttachment.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1);
 
 		// Terrain buffers
 		visBuffTerrain.SetupIndexBufferDescriptor(visBuffShadePassDescSets[i], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
 		visBuffTerrain.SetupAttributeBufferDescriptor(visBuffShadePassDescSets[i], 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
 
-		// Settings UBO
-		settingsBuffer.SetupDescriptor(sizeof(SettingsUBO), 0);
-		settingsBuffer.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
-
 		// Heightmap texture
 		visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffShadePassDescSets[i], 6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
 
 		// Normalmap texture
 		visBuffTerrain.SetupNormalmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffShadePassDescSets[i], 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
 
-		// Directional light ubo
-		light.SetupUBODescriptors(visBuffShadePassDescSets[i], 8, 1);
+		// Triangle setup cache, only read by the cached shade pipeline
+		triangleSetupBuffer.SetupDescriptor();
+		triangleSetupBuffer.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 9, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+		// Transformed vertices, only read by the post-transform shade pipeline
+		transformedVertexBuffer.SetupDescriptor();
+		transformedVertexBuffer.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 10, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+		// Subgroup fetch counters, only written by the subgroup fetch shade pipeline
+		subgroupFetchCounterBuffer.SetupDescriptor();
+		subgroupFetchCounterBuffer.SetupDescriptorWriteSet(visBuffShadePassDescSets[i], 13, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
 
 		// Create a descriptor writes for each descriptor in the set
-		std::array<VkWriteDescriptorSet, 9> visBuffShadePassDescriptorWrites = {};
+		std::array<VkWriteDescriptorSet, 12> visBuffShadePassDescriptorWrites = {};
 		visBuffShadePassDescriptorWrites[0] = visBuffTerrain.GetTexture().WriteDescriptorSet();
-		visBuffShadePassDescriptorWrites[1] = visibilityBuffer.visibility.WriteDescriptorSet();
-		visBuffShadePassDescriptorWrites[2] = mvpUniformBuffer.WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[1] = visibilityAttachment.WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[2] = uniformRing.RegionWriteDescriptorSet(visBuffShadePassDescSets[i], 2, UNIFORM_REGION_MVP);
 		visBuffShadePassDescriptorWrites[3] = visBuffTerrain.IndexBuffer().WriteDescriptorSet();
 		visBuffShadePassDescriptorWrites[4] = visBuffTerrain.AttributeBuffer().WriteDescriptorSet();
-		visBuffShadePassDescriptorWrites[5] = settingsBuffer.WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[5] = uniformRing.RegionWriteDescriptorSet(visBuffShadePassDescSets[i], 5, UNIFORM_REGION_SETTINGS);
 		visBuffShadePassDescriptorWrites[6] = visBuffTerrain.Heightmap().WriteDescriptorSet();
 		visBuffShadePassDescriptorWrites[7] = visBuffTerrain.Normalmap().WriteDescriptorSet();
-		visBuffShadePassDescriptorWrites[8] = light.UBO().WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[8] = uniformRing.RegionWriteDescriptorSet(visBuffShadePassDescSets[i], 8, UNIFORM_REGION_LIGHT);
+		visBuffShadePassDescriptorWrites[9] = triangleSetupBuffer.WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[10] = transformedVertexBuffer.WriteDescriptorSet();
+		visBuffShadePassDescriptorWrites[11] = subgroupFetchCounterBuffer.WriteDescriptorSet();
 		vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(visBuffShadePassDescriptorWrites.size()), visBuffShadePassDescriptorWrites.data(), 0, nullptr);
 
 		// Now for the tessellation pipeline
-		tessTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
-		mvpUniformBuffer.SetupDescriptorWriteSet(tessShadePassDescSets[i], 2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
+		tessTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
 		tessTerrain.SetupIndexBufferDescriptor(tessShadePassDescSets[i], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
 		tessTerrain.SetupAttributeBufferDescriptor(tessShadePassDescSets[i], 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
-		settingsBuffer.SetupDescriptorWriteSet(tessShadePassDescSets[i], 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
 		visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessShadePassDescSets[i], 6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
 		visBuffTerrain.SetupNormalmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessShadePassDescSets[i], 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
-		light.SetupUBODescriptors(tessShadePassDescSets[i], 8, 1);
 		// Tess Visibility Buffer attachment
 		tessVisibilityBuffer.visibility.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE);
 		tessVisibilityBuffer.visibility.SetupDescriptorWriteSet(tessShadePassDescSets[i], 1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1);
@@ -1770,20 +4707,34 @@ void VulkanApplication::CreateShadePassDescriptorSets()
 		tessVisibilityBuffer.tessCoords_v2YZ_v3XY.SetupDescriptorWriteSet(tessShadePassDescSets[i], 10, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1);
 		tessVisibilityBuffer.tessCoords_v3Z.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE);
 		tessVisibilityBuffer.tessCoords_v3Z.SetupDescriptorWriteSet(tessShadePassDescSets[i], 11, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1);
+		tessRecordBuffer.SetupDescriptor();
+		tessRecordBuffer.SetupDescriptorWriteSet(tessShadePassDescSets[i], 12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		subgroupFetchCounterBuffer.SetupDescriptorWriteSet(tessShadePassDescSets[i], 13, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
 
-		std::array<VkWriteDescriptorSet, 12> tessShadePassDescriptorWrites = {};
+		std::array<VkWriteDescriptorSet, 14> tessShadePassDescriptorWrites = {};
 		tessShadePassDescriptorWrites[0] = tessTerrain.GetTexture().WriteDescriptorSet();
 		tessShadePassDescriptorWrites[1] = tessVisibilityBuffer.visibility.WriteDescriptorSet();
-		tessShadePassDescriptorWrites[2] = mvpUniformBuffer.WriteDescriptorSet();
+		tessShadePassDescriptorWrites[2] = uniformRing.RegionWriteDescriptorSet(tessShadePassDescSets[i], 2, UNIFORM_REGION_MVP);
 		tessShadePassDescriptorWrites[3] = tessTerrain.IndexBuffer().WriteDescriptorSet();
 		tessShadePassDescriptorWrites[4] = tessTerrain.AttributeBuffer().WriteDescriptorSet();
-		tessShadePassDescriptorWrites[5] = settingsBuffer.WriteDescriptorSet();
+		tessShadePassDescriptorWrites[5] = uniformRing.RegionWriteDescriptorSet(tessShadePassDescSets[i], 5, UNIFORM_REGION_SETTINGS);
 		tessShadePassDescriptorWrites[6] = visBuffTerrain.Heightmap().WriteDescriptorSet();
 		tessShadePassDescriptorWrites[7] = visBuffTerrain.Normalmap().WriteDescriptorSet();
-		tessShadePassDescriptorWrites[8] = light.UBO().WriteDescriptorSet();
+		tessShadePassDescriptorWrites[8] = uniformRing.RegionWriteDescriptorSet(tessShadePassDescSets[i], 8, UNIFORM_REGION_LIGHT);
 		tessShadePassDescriptorWrites[9] = tessVisibilityBuffer.tessCoords_v1XYZ_v2X.WriteDescriptorSet();
 		tessShadePassDescriptorWrites[10] = tessVisibilityBuffer.tessCoords_v2YZ_v3XY.WriteDescriptorSet();
 		tessShadePassDescriptorWrites[11] = tessVisibilityBuffer.tessCoords_v3Z.WriteDescriptorSet();
+		tessShadePassDescriptorWrites[12] = tessRecordBuffer.WriteDescriptorSet();
+		tessShadePassDescriptorWrites[13] = subgroupFetchCounterBuffer.WriteDescriptorSet();
+		vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(tessShadePassDescriptorWrites.size()), tessShadePassDescriptorWrites.data(), 0, nullptr);
+
+		// Quad patch set only differs by the terrain index and attribute buffers
+		for (auto& write : tessShadePassDescriptorWrites)
+			write.dstSet = tessQuadShadePassDescSets[i];
+		tessQuadTerrain.SetupIndexBufferDescriptor(tessQuadShadePassDescSets[i], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		tessQuadTerrain.SetupAttributeBufferDescriptor(tessQuadShadePassDescSets[i], 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		tessShadePassDescriptorWrites[3] = tessQuadTerrain.IndexBuffer().WriteDescriptorSet();
+		tessShadePassDescriptorWrites[4] = tessQuadTerrain.AttributeBuffer().WriteDescriptorSet();
 		vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(tessShadePassDescriptorWrites.size()), tessShadePassDescriptorWrites.data(), 0, nullptr);
 	}
 }
@@ -1806,22 +4757,25 @@ void VulkanApplication::CreateWritePassDescriptorSet()
 		throw std::runtime_error("Failed to allocate write pass descriptor sets");
 	}
 
-	// Terrain UBO
-	mvpUniformBuffer.SetupDescriptor(sizeof(MVPUniformBufferObject), 0);
-	mvpUniformBuffer.SetupDescriptorWriteSet(visBuffWritePassDescSet, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
-
 	// Heightmap texture
 	visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffWritePassDescSet, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
 
+	// Transformed vertices
+	transformedVertexBuffer.SetupDescriptor();
+	transformedVertexBuffer.SetupDescriptorWriteSet(visBuffWritePassDescSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
 	// Create a descriptor write for each descriptor in the set
-	std::array<VkWriteDescriptorSet, 2> writePassDescriptorWrites = {};
+	std::array<VkWriteDescriptorSet, 3> writePassDescriptorWrites = {};
 
 	// Binding 0: MVP Uniform Buffer of terrain
-	writePassDescriptorWrites[0] = mvpUniformBuffer.WriteDescriptorSet();
+	writePassDescriptorWrites[0] = uniformRing.RegionWriteDescriptorSet(visBuffWritePassDescSet, 0, UNIFORM_REGION_MVP);
 
 	// Binding 1: Heightmap texture
 	writePassDescriptorWrites[1] = visBuffTerrain.Heightmap().WriteDescriptorSet();
 
+	// Binding 2: Transformed vertices
+	writePassDescriptorWrites[2] = transformedVertexBuffer.WriteDescriptorSet();
+
 	vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(writePassDescriptorWrites.size()), writePassDescriptorWrites.data(), 0, nullptr);
 }
 
@@ -1843,31 +4797,254 @@ void VulkanApplication::CreateTessWritePassDescriptorSet()
 		throw std::runtime_error("Failed to allocate tess write pass descriptor sets");
 	}
 
-	// Settings UBO
-	settingsBuffer.SetupDescriptor(sizeof(SettingsUBO), 0);
-	settingsBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
-
-	// Terrain UBO
-	mvpUniformBuffer.SetupDescriptor(sizeof(MVPUniformBufferObject), 0);
-	mvpUniformBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1);
-
 	// Heightmap texture
 	visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessWritePassDescSet, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
 
+	// Triangle record buffer and counter
+	tessRecordBuffer.SetupDescriptor();
+	tessRecordBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	tessRecordCounterBuffer.SetupDescriptor();
+	tessRecordCounterBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Feedback tess factors
+	tessVertexFactorBuffer.SetupDescriptor();
+	tessVertexFactorBuffer.SetupDescriptorWriteSet(tessWritePassDescSet, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
 	// Create a descriptor write for each descriptor in the set
-	std::array<VkWriteDescriptorSet, 3> tessWritePassDescriptorWrites = {};
+	std::array<VkWriteDescriptorSet, 6> tessWritePassDescriptorWrites = {};
 
 	// Binding 0: Rendering settings
-	tessWritePassDescriptorWrites[0] = settingsBuffer.WriteDescriptorSet();
+	tessWritePassDescriptorWrites[0] = uniformRing.RegionWriteDescriptorSet(tessWritePassDescSet, 0, UNIFORM_REGION_SETTINGS);
 
 	// Binding 1: MVP Uniform Buffer of terrain
-	tessWritePassDescriptorWrites[1] = mvpUniformBuffer.WriteDescriptorSet();
+	tessWritePassDescriptorWrites[1] = uniformRing.RegionWriteDescriptorSet(tessWritePassDescSet, 1, UNIFORM_REGION_MVP);
 
 	// Binding 2: Heightmap texture
 	tessWritePassDescriptorWrites[2] = visBuffTerrain.Heightmap().WriteDescriptorSet();
 
+	// Binding 3 & 4: Triangle record buffer and counter
+	tessWritePassDescriptorWrites[3] = tessRecordBuffer.WriteDescriptorSet();
+	tessWritePassDescriptorWrites[4] = tessRecordCounterBuffer.WriteDescriptorSet();
+
+	// Binding 5: Feedback tess factors
+	tessWritePassDescriptorWrites[5] = tessVertexFactorBuffer.WriteDescriptorSet();
+
 	vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(tessWritePassDescriptorWrites.size()), tessWritePassDescriptorWrites.data(), 0, nullptr);
 }
+
+void VulkanApplication::CreateTessFeedbackDescriptorSets()
+{
+	// One set per patch terrain, they only differ by the index buffer used to find patch vertices
+	std::vector<VkDescriptorSetLayout> feedbackLayouts(tessFeedbackDescSets.size(), tessFeedbackDescSetLayout);
+	VkDescriptorSetAllocateInfo feedbackAllocInfo = {};
+	feedbackAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	feedbackAllocInfo.descriptorPool = descriptorPool;
+	feedbackAllocInfo.descriptorSetCount = SCAST_U32(feedbackLayouts.size());
+	feedbackAllocInfo.pSetLayouts = feedbackLayouts.data();
+
+	if (vkAllocateDescriptorSets(vulkan->Device(), &feedbackAllocInfo, tessFeedbackDescSets.data()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate tess feedback descriptor sets");
+	}
+
+	std::array<Terrain*, 2> terrains = { &tessTerrain, &tessQuadTerrain };
+	for (size_t i = 0; i < tessFeedbackDescSets.size(); i++)
+	{
+		// Tess visibility buffer, transitioned to general layout after the render pass
+		tessVisibilityBuffer.visibility.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE);
+		tessVisibilityBuffer.visibility.SetupDescriptorWriteSet(tessFeedbackDescSets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1);
+
+		// Feedback buffers
+		tessPatchCoverageBuffer.SetupDescriptor();
+		tessPatchCoverageBuffer.SetupDescriptorWriteSet(tessFeedbackDescSets[i], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		tessPatchFactorBuffer.SetupDescriptor();
+		tessPatchFactorBuffer.SetupDescriptorWriteSet(tessFeedbackDescSets[i], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+		tessVertexFactorBuffer.SetupDescriptor();
+		tessVertexFactorBuffer.SetupDescriptorWriteSet(tessFeedbackDescSets[i], 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+		// Terrain index buffer
+		terrains[i]->SetupIndexBufferDescriptor(tessFeedbackDescSets[i], 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+		std::array<VkWriteDescriptorSet, 6> feedbackDescriptorWrites = {};
+		feedbackDescriptorWrites[0] = uniformRing.RegionWriteDescriptorSet(tessFeedbackDescSets[i], 0, UNIFORM_REGION_SETTINGS);
+		feedbackDescriptorWrites[1] = tessVisibilityBuffer.visibility.WriteDescriptorSet();
+		feedbackDescriptorWrites[2] = tessPatchCoverageBuffer.WriteDescriptorSet();
+		feedbackDescriptorWrites[3] = tessPatchFactorBuffer.WriteDescriptorSet();
+		feedbackDescriptorWrites[4] = tessVertexFactorBuffer.WriteDescriptorSet();
+		feedbackDescriptorWrites[5] = terrains[i]->IndexBuffer().WriteDescriptorSet();
+		vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(feedbackDescriptorWrites.size()), feedbackDescriptorWrites.data(), 0, nullptr);
+	}
+}
+
+void VulkanApplication::CreateSwRasterDescriptorSet()
+{
+	std::vector<VkDescriptorSetLayout> swRasterLayouts = { swRasterDescSetLayout };
+	VkDescriptorSetAllocateInfo swRasterAllocInfo = {};
+	swRasterAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	swRasterAllocInfo.descriptorPool = descriptorPool;
+	swRasterAllocInfo.descriptorSetCount = 1;
+	swRasterAllocInfo.pSetLayouts = swRasterLayouts.data();
+
+	if (vkAllocateDescriptorSets(vulkan->Device(), &swRasterAllocInfo, &swRasterDescSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate software raster descriptor set");
+	}
+
+	// Heightmap, for the same displacement as the write pass
+	visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, swRasterDescSet, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
+
+	// Terrain geometry
+	visBuffTerrain.SetupAttributeBufferDescriptor(swRasterDescSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	visBuffTerrain.SetupIndexBufferDescriptor(swRasterDescSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Software raster buffers
+	swRasterIndexBuffer.SetupDescriptor();
+	swRasterIndexBuffer.SetupDescriptorWriteSet(swRasterDescSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	swRasterTriangleBuffer.SetupDescriptor();
+	swRasterTriangleBuffer.SetupDescriptorWriteSet(swRasterDescSet, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	swRasterDispatchBuffer.SetupDescriptor();
+	swRasterDispatchBuffer.SetupDescriptorWriteSet(swRasterDescSet, 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	swRasterVisibilityBuffer.SetupDescriptor();
+	swRasterVisibilityBuffer.SetupDescriptorWriteSet(swRasterDescSet, 7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	std::array<VkWriteDescriptorSet, 8> swRasterDescriptorWrites = {};
+	swRasterDescriptorWrites[0] = uniformRing.RegionWriteDescriptorSet(swRasterDescSet, 0, UNIFORM_REGION_MVP);
+	swRasterDescriptorWrites[1] = visBuffTerrain.Heightmap().WriteDescriptorSet();
+	swRasterDescriptorWrites[2] = visBuffTerrain.AttributeBuffer().WriteDescriptorSet();
+	swRasterDescriptorWrites[3] = visBuffTerrain.IndexBuffer().WriteDescriptorSet();
+	swRasterDescriptorWrites[4] = swRasterIndexBuffer.WriteDescriptorSet();
+	swRasterDescriptorWrites[5] = swRasterTriangleBuffer.WriteDescriptorSet();
+	swRasterDescriptorWrites[6] = swRasterDispatchBuffer.WriteDescriptorSet();
+	swRasterDescriptorWrites[7] = swRasterVisibilityBuffer.WriteDescriptorSet();
+	vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(swRasterDescriptorWrites.size()), swRasterDescriptorWrites.data(), 0, nullptr);
+}
+
+void VulkanApplication::CreateTileShadeDescriptorSet()
+{
+	std::vector<VkDescriptorSetLayout> tileShadeLayouts = { tileShadeDescSetLayout };
+	VkDescriptorSetAllocateInfo tileShadeAllocInfo = {};
+	tileShadeAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	tileShadeAllocInfo.descriptorPool = descriptorPool;
+	tileShadeAllocInfo.descriptorSetCount = 1;
+	tileShadeAllocInfo.pSetLayouts = tileShadeLayouts.data();
+
+	if (vkAllocateDescriptorSets(vulkan->Device(), &tileShadeAllocInfo, &tileShadeDescSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate tile shade descriptor set");
+	}
+
+	// Same terrain resources as the vis buff shade pass
+	visBuffTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tileShadeDescSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
+	visBuffTerrain.SetupIndexBufferDescriptor(tileShadeDescSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	visBuffTerrain.SetupAttributeBufferDescriptor(tileShadeDescSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	visBuffTerrain.SetupHeightmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tileShadeDescSet, 6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
+	visBuffTerrain.SetupNormalmapDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tileShadeDescSet, 7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1);
+
+	// Visibility buffer and shaded output are both storage images in general layout
+	visibilityBuffer.visibility.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE);
+	visibilityBuffer.visibility.SetupDescriptorWriteSet(tileShadeDescSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1);
+	tileShadeOutput.SetUpDescriptorInfo(VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE);
+	tileShadeOutput.SetupDescriptorWriteSet(tileShadeDescSet, 9, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1);
+
+	// Tile buffers
+	tileListBuffer.SetupDescriptor();
+	tileListBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 10, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	tileDispatchBuffer.SetupDescriptor();
+	tileDispatchBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 11, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Material binning buffers
+	materialBinBuffer.SetupDescriptor();
+	materialBinBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	materialPixelBuffer.SetupDescriptor();
+	materialPixelBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 13, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	materialDrawBuffer.SetupDescriptor();
+	materialDrawBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 14, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	materialBuffer.SetupDescriptor();
+	materialBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 15, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Triangle setup buffers
+	triangleSetupBuffer.SetupDescriptor();
+	triangleSetupBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 16, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	visibleTriangleBuffer.SetupDescriptor();
+	visibleTriangleBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 17, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	triangleSetupCounterBuffer.SetupDescriptor();
+	triangleSetupCounterBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 18, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Transformed vertices
+	transformedVertexBuffer.SetupDescriptor();
+	transformedVertexBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 19, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// Tile shading rates and counters for the VRS passes
+	vrsRateBuffer.SetupDescriptor();
+	vrsRateBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 20, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	vrsCounterBuffer.SetupDescriptor();
+	vrsCounterBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 21, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	// History and counters for the temporal reuse pass
+	temporalHistoryBuffer.SetupDescriptor();
+	temporalHistoryBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 22, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+	temporalCounterBuffer.SetupDescriptor();
+	temporalCounterBuffer.SetupDescriptorWriteSet(tileShadeDescSet, 23, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+
+	std::array<VkWriteDescriptorSet, 24> tileShadeDescriptorWrites = {};
+	tileShadeDescriptorWrites[0] = visBuffTerrain.GetTexture().WriteDescriptorSet();
+	tileShadeDescriptorWrites[1] = visibilityBuffer.visibility.WriteDescriptorSet();
+	tileShadeDescriptorWrites[2] = uniformRing.RegionWriteDescriptorSet(tileShadeDescSet, 2, UNIFORM_REGION_MVP);
+	tileShadeDescriptorWrites[3] = visBuffTerrain.IndexBuffer().WriteDescriptorSet();
+	tileShadeDescriptorWrites[4] = visBuffTerrain.AttributeBuffer().WriteDescriptorSet();
+	tileShadeDescriptorWrites[5] = uniformRing.RegionWriteDescriptorSet(tileShadeDescSet, 5, UNIFORM_REGION_SETTINGS);
+	tileShadeDescriptorWrites[6] = visBuffTerrain.Heightmap().WriteDescriptorSet();
+	tileShadeDescriptorWrites[7] = visBuffTerrain.Normalmap().WriteDescriptorSet();
+	tileShadeDescriptorWrites[8] = uniformRing.RegionWriteDescriptorSet(tileShadeDescSet, 8, UNIFORM_REGION_LIGHT);
+	tileShadeDescriptorWrites[9] = tileShadeOutput.WriteDescriptorSet();
+	tileShadeDescriptorWrites[10] = tileListBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[11] = tileDispatchBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[12] = materialBinBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[13] = materialPixelBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[14] = materialDrawBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[15] = materialBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[16] = triangleSetupBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[17] = visibleTriangleBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[18] = triangleSetupCounterBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[19] = transformedVertexBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[20] = vrsRateBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[21] = vrsCounterBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[22] = temporalHistoryBuffer.WriteDescriptorSet();
+	tileShadeDescriptorWrites[23] = temporalCounterBuffer.WriteDescriptorSet();
+	vkUpdateDescriptorSets(vulkan->Device(), SCAST_U32(tileShadeDescriptorWrites.size()), tileShadeDescriptorWrites.data(), 0, nullptr);
+}
+
+// Points every shade set's colour texture at the mipmapped or base level sampler. Every frame in flight may have the sets bound, so
+// the device is idled before they're written.
+void VulkanApplication::UpdateTextureDescriptors()
+{
+	vkDeviceWaitIdle(vulkan->Device());
+	VkWriteDescriptorSet textureWrite;
+	for (size_t i = 0; i < visBuffShadePassDescSets.size(); i++)
+	{
+		visBuffTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, visBuffShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
+		textureWrite = visBuffTerrain.GetTexture().WriteDescriptorSet();
+		vkUpdateDescriptorSets(vulkan->Device(), 1, &textureWrite, 0, nullptr);
+	}
+	for (size_t i = 0; i < tessShadePassDescSets.size(); i++)
+	{
+		tessTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
+		textureWrite = tessTerrain.GetTexture().WriteDescriptorSet();
+		vkUpdateDescriptorSets(vulkan->Device(), 1, &textureWrite, 0, nullptr);
+	}
+
+	// Quad patch sets sample the same texture as the triangle patch sets
+	for (size_t i = 0; i < tessQuadShadePassDescSets.size(); i++)
+	{
+		tessTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tessQuadShadePassDescSets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
+		textureWrite = tessTerrain.GetTexture().WriteDescriptorSet();
+		vkUpdateDescriptorSets(vulkan->Device(), 1, &textureWrite, 0, nullptr);
+	}
+	visBuffTerrain.SetupTextureDescriptor(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tileShadeDescSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, useTextureMips);
+	textureWrite = visBuffTerrain.GetTexture().WriteDescriptorSet();
+	vkUpdateDescriptorSets(vulkan->Device(), 1, &textureWrite, 0, nullptr);
+	sceneResourceGeneration++; // Updating the sets invalidates the cached scene that binds them
+}
 #pragma endregion
 
 #pragma region Other Functions
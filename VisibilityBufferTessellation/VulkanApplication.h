@@ -4,6 +4,7 @@
 #include <array>
 #include <cstdlib>
 #include <chrono>
+#include <cstring>
 #include "vk_mem_alloc.h"
 #include "VulkanCore.h"
 #include "Buffer.h"
@@ -12,6 +13,11 @@
 #include "Camera.h"
 #include "VbtImGUI.h"
 #include "DirectionalLight.h"
+#include "RecordThreadPool.h"
+#include "UploadManager.h"
+#include "DeletionQueue.h"
+#include "PipelineBatch.h"
+#include "Sweep.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE // Ensure that GLM works in Vulkan's clip coordinates of 0.0 to 1.0
@@ -21,12 +27,37 @@
 #pragma region Constants
 const int WIDTH = 1920;
 const int HEIGHT = 1080;
+const int MAX_TESSELLATION_FACTOR = 64;
+const double BENCHMARK_DURATION = 20.0; // Seconds taken to fly the benchmark camera path
+const uint32_t TILE_SHADE_SIZE = 8; // Width and height in pixels of the tiles classified by the compute shade pass
+const uint32_t TILE_SHADE_CLASS_COUNT = 3; // Sky, single triangle and multi triangle tiles
+const uint32_t MATERIAL_BIN_COUNT = MATERIAL_COUNT_MAX + 1; // Sky, then one bin per material
+const uint32_t MATERIAL_DRAW_COUNT = 32; // Draws the vis buff terrain is split into for the multi-material scene
+const uint32_t VRS_RATE_COUNT = 4; // 1x1, 2x1, 1x2 and 2x2 shading rates
+const float TEMPORAL_SWEEP_PAN_RATE = 0.25f; // Degrees the camera turns each frame of the temporal sweep, so there is motion to reproject
+const uint32_t UNIFORM_BENCHMARK_ITERATIONS = 10000; // Frames worth of uniform updates timed for each path by the uniform update benchmark
+const float CAMERA_FOV = 45.0f; // Vertical field of view in degrees, restored when the setup cache sweep finishes
+const std::string PIPELINE_CACHE_PATH = "pipelinecache.bin"; // Written at shutdown and loaded at startup, rewritten whenever the shaders or driver change
+const uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43544256; // "VBTC"
+const uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+#pragma endregion
+
+#pragma region Pipeline Cache
+// Written ahead of the Vulkan pipeline cache data in the pipeline cache file
+struct PipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t shaderHash; // Of every compiled shader the cache was built from
+	uint64_t dataSize; // Of the Vulkan data that follows
+};
 #pragma endregion
 
 #pragma region Frame Buffers
 struct VisibilityBuffer
 {
 	vbt::Image visibility;
+	vbt::Image msaaVisibility, msaaDepth; // Per-sample IDs and depth, only created when the vis buff is multisampled
 };
 
 struct TessellationVisibilityBuffer
@@ -35,6 +66,151 @@ struct TessellationVisibilityBuffer
 };
 #pragma endregion
 
+#pragma region Storage Buffers
+// Post-displacement data of a single tessellated triangle, appended by the geometry stage when triangle records are enabled
+struct TessTriangleRecord
+{
+	glm::vec4 clipPositions[3];
+	glm::vec4 texCoords01;
+	glm::vec4 texCoords2;
+};
+
+// Per bin pixel counts, list offsets and shading dispatches written by the material binning passes
+struct MaterialBinCounters
+{
+	std::array<uint32_t, MATERIAL_BIN_COUNT> counts;
+	std::array<uint32_t, MATERIAL_BIN_COUNT> offsets;
+	std::array<uint32_t, MATERIAL_BIN_COUNT> cursors;
+	std::array<VkDispatchIndirectCommand, MATERIAL_BIN_COUNT> dispatches;
+};
+
+// Material ID table entry, indexed by the draw ID stored in the visibility buffer
+struct MaterialDrawInfo
+{
+	uint32_t firstTriangle; // Triangle IDs restart with each draw
+	uint32_t materialID;
+};
+
+enum MaterialModel : uint32_t { MATERIAL_TEXTURED_LIT, MATERIAL_FLAT_LIT, MATERIAL_SLOPE_BLEND };
+struct MaterialInfo
+{
+	glm::vec4 tint;
+	float textureScale;
+	MaterialModel model; // Also specialises the material's shading pipeline
+	float padding[2];
+};
+
+// Materials of the multi-material scene, the models and texture scales differ so each bin's kernel does different work
+static const std::array<MaterialInfo, MATERIAL_COUNT_MAX> SCENE_MATERIALS = { {
+	{ glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), 1.0f, MATERIAL_TEXTURED_LIT },
+	{ glm::vec4(0.35f, 0.55f, 0.2f, 1.0f), 1.0f, MATERIAL_SLOPE_BLEND },
+	{ glm::vec4(0.45f, 0.42f, 0.4f, 1.0f), 1.0f, MATERIAL_FLAT_LIT },
+	{ glm::vec4(1.0f, 0.7f, 0.6f, 1.0f), 4.0f, MATERIAL_TEXTURED_LIT },
+	{ glm::vec4(0.95f, 0.95f, 1.0f, 1.0f), 2.0f, MATERIAL_SLOPE_BLEND },
+	{ glm::vec4(0.3f, 0.22f, 0.15f, 1.0f), 1.0f, MATERIAL_FLAT_LIT },
+	{ glm::vec4(0.7f, 0.8f, 1.0f, 1.0f), 0.5f, MATERIAL_TEXTURED_LIT },
+	{ glm::vec4(0.5f, 0.6f, 0.3f, 1.0f), 3.0f, MATERIAL_SLOPE_BLEND }
+} };
+
+// Screen space planes of a visible triangle's interpolated attributes, written by the setup pass and indexed by triangle ID
+struct TriangleSetupEntry
+{
+	std::array<glm::vec4, 2> texCoordPlanes;
+	std::array<glm::vec4, 3> normalPlanes;
+};
+
+// Triangles set up by the setup pass and the pixels they cover, read back for statistics
+struct TriangleSetupCounters
+{
+	uint32_t triangleCount;
+	uint32_t pixelCount;
+};
+
+// Fetches made by the subgroup fetch shade passes and the pixels that shared them, read back for statistics
+struct SubgroupFetchCounters
+{
+	uint32_t fetchCount;
+	uint32_t pixelCount;
+};
+
+// Tiles at each shading rate, pixels shaded and the error against full rate shading from the VRS passes, read back for statistics
+struct VrsCounters
+{
+	std::array<uint32_t, VRS_RATE_COUNT> tileCounts;
+	uint32_t shadedPixelCount;
+	uint32_t squaredErrorLow; // Sum of squared 8 bit channel errors, split across two words as there are no 64 bit atomics
+	uint32_t squaredErrorHigh;
+};
+
+// Pixels shaded, reused from the history and disoccluded by the temporal reuse pass, and the error of the reused pixels, read back for statistics
+struct TemporalCounters
+{
+	uint32_t shadedPixelCount;
+	uint32_t reusedPixelCount;
+	uint32_t disoccludedPixelCount;
+	uint32_t squaredErrorLow;
+	uint32_t squaredErrorHigh;
+};
+
+// Every counter the host reads, copied out of the shared counter buffers at the end of a frame into its frame context's own
+// readback buffer
+struct CounterReadback
+{
+	std::array<uint32_t, 4> swRasterDispatch; // Indirect raster dispatch, then the small triangle count
+	std::array<VkDispatchIndirectCommand, TILE_SHADE_CLASS_COUNT> tileDispatches;
+	MaterialBinCounters materialBins;
+	TriangleSetupCounters triangleSetup;
+	SubgroupFetchCounters subgroupFetch;
+	VrsCounters vrs;
+	TemporalCounters temporal;
+	uint32_t tessRecordCount;
+};
+
+// Vis buff terrain vertex after transformation and displacement, written once per frame by the vertex transform pass
+struct TransformedVertex
+{
+	glm::vec4 clipPosition;
+	glm::vec4 positionTexU; // Displaced world position and texture u
+	glm::vec4 normalTexV; // Normal from the normal map and texture v
+};
+#pragma endregion
+
+#pragma region Push Constants
+// Vis buff write pass, gl_DrawIDARB restarts at zero in each indirect call so split material draws push their first draw
+struct WritePushConstants
+{
+	uint32_t drawOffset;
+};
+
+// Shared by the software raster compute passes and the merge draw
+struct SwRasterPushConstants
+{
+	uint32_t screenWidth;
+	uint32_t screenHeight;
+	uint32_t maxTriangleSize;
+	uint32_t triangleCount;
+	uint32_t pass; // Depth or ID pass of the 32 bit fallback
+};
+
+// Shared by the VRS classify and shade passes
+struct VrsPushConstants
+{
+	float gradientThreshold; // Largest luminance step within a tile that can still be shaded coarsely, 0 shades everything at full rate
+	uint32_t measureError; // Also shade reconstructed pixels at full rate and sum the squared error
+};
+
+// Temporal reuse pass, shares the tile shade layout's push constant range with the VRS passes
+struct TemporalPushConstants
+{
+	glm::mat4 previousMvp; // Reprojects this frame's surface into last frame's history
+	uint32_t frameIndex; // Parity picks the history half written, and the slice of pixels refreshed regardless of their history
+	uint32_t reuseBudget; // Frames a shaded colour can be reused for, 1 shades every pixel
+	uint32_t cameraMoved;
+	uint32_t resetHistory; // Set when the history was not written last frame or the settings changed
+	uint32_t measureError; // Also shade reused pixels and sum the squared error
+};
+#pragma endregion
+
 #pragma region Uniform Buffers
 struct MVPUniformBufferObject 
 {
@@ -49,6 +225,88 @@ struct SettingsUBO
 	uint32_t showTessCoordsBuffer = 0;
 	uint32_t showInterpolatedTex = 0;
 	uint32_t wireframe = 0;
+	uint32_t tessRecordCapacity = 0;
+	uint32_t tessFeedback = 0;
+	uint32_t tessFeedbackFallbackFactor = 8;
+	uint32_t tessFeedbackPatchCount = 0;
+	uint32_t tessFeedbackQuadPatches = 0;
+	float tessFeedbackPixelsPerTriangle = 8.0f;
+	float tessFeedbackHysteresis = 0.25f;
+};
+#pragma endregion
+
+#pragma region Frame Contexts
+// Secondary command buffers the scene is recorded into, in the order the primary executes them
+enum SceneCommandBuffer
+{
+	SCENE_PRE_PASS, // Counter resets and the compute passes before the render pass
+	SCENE_WRITE_SUBPASS,
+	SCENE_RESOLVE, // Compute shading between the write and shade render passes
+	SCENE_SHADE_SUBPASS,
+	SCENE_POST_PASS, // Tess feedback passes after the render pass
+	SCENE_COMMAND_BUFFER_COUNT
+};
+
+// Regions of each frame's slice of the uniform ring, bound as dynamic uniform buffers
+enum UniformRegion
+{
+	UNIFORM_REGION_MVP,
+	UNIFORM_REGION_SETTINGS,
+	UNIFORM_REGION_LIGHT,
+	UNIFORM_REGION_COUNT
+};
+
+// Everything the scene command buffers are recorded from, they're replayed until it changes. Members are all 4 bytes so
+// there's no padding to compare.
+struct SceneRecordState
+{
+	uint32_t pipeline;
+	uint32_t resourceGeneration; // Bumped whenever the attachments or descriptor sets the scene uses are rebuilt
+	VkBool32 msaa;
+	VkBool32 materialShade;
+	uint32_t shadedMaterialCount;
+	VkBool32 swRaster;
+	SwRasterPushConstants swRasterConstants;
+	VkBool32 vrs;
+	VrsPushConstants vrsConstants;
+	VkBool32 temporalReuse;
+	VkBool32 tileShade;
+	VkBool32 setupCache;
+	VkBool32 postTransform;
+	VkBool32 subgroupFetch;
+	VkBool32 recordTriangles;
+	VkBool32 tessFeedback;
+	VkBool32 resetTessFeedback;
+	VkBool32 quadPatches;
+	VkBool32 depthPrePass;
+	uint32_t recordThreads;
+	uint32_t writeDrawCalls; // Indirect calls the material draws are split into, shared between the write slices
+	VkBool32 gpuQueries; // Write the timestamp and pipeline statistics queries
+	uint32_t uniformOffset; // Dynamic offset of the frame context's uniform ring slice
+
+	bool operator==(const SceneRecordState& other) const { return memcmp(this, &other, sizeof(SceneRecordState)) == 0; }
+};
+
+// Objects owned by one frame while the CPU records ahead of the GPU, its sync objects are indexed the same way in VulkanCore
+struct FrameContext
+{
+	VkCommandBuffer commandBuffer;
+	std::array<VkCommandBuffer, SCENE_COMMAND_BUFFER_COUNT> sceneCommandBuffers; // Recorded into when the scene is recorded on the main thread
+	VkCommandBuffer uiCommandBuffer; // Recorded every frame and executed after the shade subpass
+	std::array<VkCommandPool, MAX_RECORD_THREADS> threadCommandPools;
+	std::array<std::array<VkCommandBuffer, SCENE_COMMAND_BUFFER_COUNT>, MAX_RECORD_THREADS> threadSceneCommandBuffers;
+	std::array<VkCommandBuffer, SCENE_COMMAND_BUFFER_COUNT> recordedSceneCommandBuffers; // Whichever buffers hold the scene, the write subpass is in writeSliceCommandBuffers
+	std::array<VkCommandBuffer, MAX_RECORD_THREADS> writeSliceCommandBuffers;
+	uint32_t writeSliceCount = 1;
+	VkQueryPool timestampPool;
+	VkQueryPool pipelineStatisticsPool;
+	vbt::Buffer counterReadback; // Persistently mapped CounterReadback written by the context's last submission
+	bool submitted = false; // The counter readback holds results of a submission that haven't been read yet
+	bool queriesPending = false; // Same for the queries, which are polled every frame rather than waited on
+	uint64_t querySubmitFrame = 0; // Submission the pending queries were written by
+	uint64_t submitFrame = 0; // Submission the context's fence was last submitted with
+	SceneRecordState sceneState = {};
+	bool sceneRecorded = false; // The scene command buffers hold sceneState
 };
 #pragma endregion
 
@@ -68,6 +326,11 @@ namespace vbt
 		void ApplySettings(AppSettings settings);
 #endif
 		VulkanCore* GetVulkanCore() { return vulkan; }
+		RenderStatistics Statistics() { return statistics; }
+		void StartBenchmark();
+		void StartSweep(SweepType type);
+		void RunUniformUpdateBenchmark();
+		void RunPipelineCacheBenchmark();
 		void SwitchPipeline(PipelineType type);
 
 		const std::string title = "Visibility Buffer Tessellation";
@@ -82,8 +345,9 @@ namespace vbt
 
 #if IMGUI_ENABLED
 #pragma region ImGui Functions
-		void InitImGui(VkRenderPass renderPass);
-		void RecreateImGui(VkRenderPass renderPass);
+		void InitImGui();
+		void RecreateImGui();
+		ImGui_ImplVulkan_InitInfo ImGuiInitInfo();
 #pragma endregion
 #endif
 
@@ -93,7 +357,26 @@ namespace vbt
 
 #pragma region Testing Functions
 		void CreateTimestampPool();
-		void GetTimestampResults();
+		bool GetQueryResults(FrameContext& frame);
+		void PollQueryResults();
+		void GetCounterResults(const FrameContext& frame);
+		const CounterReadback& WaitForSubmittedCounters();
+		void UpdateBenchmark();
+		void RegisterSweeps();
+		void RegisterSwRasterSweep();
+		void RegisterMaterialSweep();
+		void RegisterSetupCacheSweep();
+		void RegisterPostTransformBenchmark();
+		void RegisterSubgroupFetchSweep();
+		void RegisterMsaaSweep();
+		void RegisterVrsSweep();
+		void RegisterTemporalSweep();
+		void RegisterTextureLodSweep();
+		void RegisterFramesInFlightSweep();
+		void RegisterRecordBenchmark();
+		void RegisterRecordSweep();
+		void RegisterTimingBenchmark();
+		void UpdateSweeps();
 #pragma endregion
 
 #pragma region Input Functions
@@ -105,29 +388,60 @@ namespace vbt
 #pragma region Presentation and Swap Chain Functions
 		void RecreateSwapChain();
 		void CleanUpSwapChainResources();
+		void RetireFrameBufferResources();
+		void RecreateVisibilityBufferResources();
+		VkSampleCountFlagBits SupportedVisBuffSampleCount(int requestedSamples, bool uintFormat);
+		VkDeviceSize VisBuffAttachmentBytes(VkSampleCountFlagBits samples);
 #pragma endregion
 
 #pragma region Graphics Pipeline Functions
 		void CreatePipelineCache();
+		void SavePipelineCache();
+		bool ValidPipelineCacheData(const std::vector<char>& data);
+		uint64_t ShaderContentHash();
 		void CreatePipelineLayouts();
+		void CreatePipelines();
 		void CreateShadePipelines();
 		void CreateWritePipelines();
+		void CreateComputePipelines();
 		void CreateRenderPasses();
-		VkShaderModule CreateShaderModule(const std::vector<char>& code);
+		std::string VisibilityShaderPath(const std::string& name, const std::string& stage);
 #pragma endregion
 
 #pragma region Drawing Functions
 		void InitCamera();
 		void InitLight();
 		void CreateFrameBuffers();
-		void CreateFrameBufferAttachment(VkFormat format, VkImageUsageFlags usage, Image* attachment, VmaAllocator& allocator);
+		void CreateFrameBufferAttachments();
+		void CreateFrameBufferAttachment(VkFormat format, VkImageUsageFlags usage, Image* attachment, VmaAllocator& allocator, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
 		void DrawFrame();
+		void SetFramesInFlight(uint32_t count);
 #pragma endregion
 
 #pragma region Command Buffer Functions
 		void CreateCommandPool();
 		void AllocateCommandBuffers();
-		void RecordCommandBuffers();
+		void RecordCommandBuffer(uint32_t imageIndex);
+		void RecordSharedResourceBarriers(VkCommandBuffer commandBuffer);
+		void RecordCounterReadback(VkCommandBuffer commandBuffer, FrameContext& frame);
+		void RecordSceneCommandBuffers(FrameContext& frame, const SceneRecordState& state);
+		void RecordScenePrePass(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state);
+		void RecordSceneWriteSlice(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state, uint32_t slice);
+		void RecordSceneResolve(VkCommandBuffer commandBuffer, const SceneRecordState& state);
+		void RecordSceneShadeSubpass(VkCommandBuffer commandBuffer, FrameContext& frame, const SceneRecordState& state);
+		void RecordScenePostPass(VkCommandBuffer commandBuffer, const SceneRecordState& state);
+		void BeginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkRenderPass renderPass, uint32_t subpass, VkCommandBufferUsageFlags flags = 0);
+		void SetViewportAndScissor(VkCommandBuffer commandBuffer);
+		VkRenderPass SceneShadeRenderPass(const SceneRecordState& state);
+		void BindUniformRingDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, VkDescriptorSet descriptorSet, uint32_t uniformRegionCount, uint32_t uniformOffset);
+		void RecordTessFeedbackCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset);
+		void RecordSwRasterCommands(VkCommandBuffer commandBuffer, SwRasterPushConstants constants, uint32_t uniformOffset);
+		void RecordTileShadeCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset);
+		void RecordMaterialShadeCommands(VkCommandBuffer commandBuffer, uint32_t shadedMaterialCount, uint32_t uniformOffset);
+		void RecordTriangleSetupCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset);
+		void RecordVertexTransformCommands(VkCommandBuffer commandBuffer, uint32_t uniformOffset);
+		void RecordVrsShadeCommands(VkCommandBuffer commandBuffer, VrsPushConstants constants, uint32_t uniformOffset);
+		void RecordTemporalShadeCommands(VkCommandBuffer commandBuffer, TemporalPushConstants constants, uint32_t uniformOffset);
 #pragma endregion
 
 #pragma region Depth Buffer Functions
@@ -139,7 +453,22 @@ namespace vbt
 #pragma region Buffer Functions
 		void CreateUniformBuffers();
 		void UpdateUniformBuffers();
+		void WriteUniformSlice(uint32_t slice);
+		void CreateTessRecordBuffers();
+		void GrowTessRecordBuffer();
+		void CreateTessFeedbackBuffers();
+		void CreateSwRasterBuffers();
+		void CreateTileShadeBuffers();
+		void CreateMaterialShadeBuffers();
+		void UpdateMaterialDrawTable(uint32_t tableMaterialCount);
+		void CreateTriangleSetupBuffers();
+		void CreatePostTransformBuffers();
+		void CreateSubgroupFetchBuffers();
+		void CreateVrsBuffers();
+		void CreateTemporalBuffers();
+		void CreateCounterReadbackBuffers();
 		void CreateVmaAllocator();
+		void CreateUploadManager();
 #pragma endregion
 
 #pragma region Descriptor Functions
@@ -150,6 +479,13 @@ namespace vbt
 		void CreateWritePassDescriptorSet();
 		void CreateTessWritePassDescriptorSetLayout();
 		void CreateTessWritePassDescriptorSet();
+		void CreateTessFeedbackDescriptorSetLayout();
+		void CreateTessFeedbackDescriptorSets();
+		void CreateSwRasterDescriptorSetLayout();
+		void CreateSwRasterDescriptorSet();
+		void CreateTileShadeDescriptorSetLayout();
+		void CreateTileShadeDescriptorSet();
+		void UpdateTextureDescriptors();
 #pragma endregion
 
 #pragma region Other Functions
@@ -167,13 +503,17 @@ namespace vbt
 		Camera camera;
 		DirectionalLight light;
 		VkPipelineCache pipelineCache;
+		uint64_t shaderContentHash = 0; // Of the shaders the pipelines are built from, hashed once when the cache is created
+		PipelineBatch pipelineBatch; // Pipelines added by the Create*Pipelines functions, compiled on the record threads
 		VkCommandPool commandPool;
+		UploadManager uploadManager; // Startup uploads, on the dedicated transfer queue when there is one
+		DeletionQueue deletionQueue; // Objects replaced while frames using them were in flight
 		VkDescriptorPool descriptorPool;
-		VkQueryPool timestampPool;
 		VmaAllocator allocator;
-		std::vector<VkCommandBuffer> commandBuffers;
+		std::array<FrameContext, MAX_FRAMES_IN_FLIGHT> frames;
+		RecordThreadPool recordThreadPool;
 		vbt::Image depthImage;
-		Buffer settingsBuffer;
+		UniformRing uniformRing; // MVP, settings and light uniforms, one slice per frame context
 #pragma endregion
 
 #pragma region Visibility Buffer Pipeline 
@@ -195,26 +535,158 @@ namespace vbt
 		VkRenderPass tessRenderPass;
 		VkPipeline tessShadePipeline;
 		VkPipeline tessWritePipeline;
+		VkPipeline tessRecordShadePipeline;
+		VkPipeline tessRecordWritePipeline;
+		VkPipeline tessQuadShadePipeline;
+		VkPipeline tessQuadWritePipeline;
+		VkPipeline tessQuadRecordWritePipeline;
+		VkPipeline tessDepthPrePassPipeline;
+		VkPipeline tessQuadDepthPrePassPipeline;
 		VkPipelineLayout tessShadePipelineLayout;
 		VkPipelineLayout tessWritePipelineLayout;
 		std::vector<VkFramebuffer> tessFramebuffers;
+		VkRenderPass uiRenderPass; // Draws the UI over the presented image after either pipeline's render pass, so ImGui never depends on the pipeline
+		std::vector<VkFramebuffer> uiFramebuffers;
 		VkDescriptorSet tessWritePassDescSet;
 		VkDescriptorSetLayout tessWritePassDescSetLayout;
 		std::vector<VkDescriptorSet> tessShadePassDescSets;
+		std::vector<VkDescriptorSet> tessQuadShadePassDescSets;
 		VkDescriptorSetLayout tessShadePassDescSetLayout;
+		Buffer tessRecordBuffer;
+		Buffer tessRecordCounterBuffer;
+#pragma endregion
+
+#pragma region Tessellation Factor Feedback
+		VkPipeline tessFeedbackCoveragePipeline;
+		VkPipeline tessFeedbackResolvePipeline;
+		VkPipelineLayout tessFeedbackPipelineLayout;
+		std::array<VkDescriptorSet, 2> tessFeedbackDescSets; // Triangle and quad patch terrains
+		VkDescriptorSetLayout tessFeedbackDescSetLayout;
+		Buffer tessPatchCoverageBuffer;
+		Buffer tessPatchFactorBuffer;
+		Buffer tessVertexFactorBuffer;
+#pragma endregion
+
+#pragma region Software Rasteriser
+		VkPipeline swRasterBinPipeline;
+		VkPipeline swRasterPipeline;
+		VkPipeline swRasterMergePipeline;
+		VkPipelineLayout swRasterPipelineLayout;
+		VkDescriptorSet swRasterDescSet;
+		VkDescriptorSetLayout swRasterDescSetLayout;
+		Buffer swRasterIndexBuffer; // Vis buff terrain indices with software rasterised and culled triangles made degenerate
+		Buffer swRasterTriangleBuffer;
+		Buffer swRasterDispatchBuffer;
+		Buffer swRasterVisibilityBuffer;
+		VkExtent2D swRasterExtent;
+#pragma endregion
+
+#pragma region Tile Classified Compute Shading
+		VkRenderPass visBuffCompositeRenderPass; // Compatible with the vis buff render pass, but keeps nothing from the write subpass
+		VkPipeline tileClassifyPipeline;
+		VkPipeline tileShadeSkyPipeline;
+		VkPipeline tileShadeSinglePipeline;
+		VkPipeline tileShadeMultiPipeline;
+		VkPipeline tileCompositePipeline;
+		VkPipelineLayout tileShadePipelineLayout;
+		VkDescriptorSet tileShadeDescSet;
+		VkDescriptorSetLayout tileShadeDescSetLayout;
+		vbt::Image tileShadeOutput;
+		Buffer tileListBuffer;
+		Buffer tileDispatchBuffer;
+		VkExtent2D tileShadeExtent;
+#pragma endregion
+
+#pragma region Material Binned Compute Shading
+		// Shares the tile shade descriptor set, output image and composite draw
+		VkPipeline materialCountPipeline;
+		VkPipeline materialOffsetsPipeline;
+		VkPipeline materialScatterPipeline;
+		std::array<VkPipeline, MATERIAL_BIN_COUNT> materialShadePipelines; // Sky, then one per material
+		Buffer materialBinBuffer;
+		Buffer materialPixelBuffer;
+		Buffer materialDrawBuffer;
+		Buffer materialBuffer;
+		Buffer visBuffDrawCommandBuffer; // Indirect draws splitting the vis buff terrain into MATERIAL_DRAW_COUNT draws
+		VkExtent2D materialShadeExtent;
+#pragma endregion
+
+#pragma region Triangle Setup Cache
+		// The setup pass shares the tile shade descriptor set, the cached shade subpass uses the vis buff shade sets
+		VkRenderPass visBuffResumeRenderPass; // Compatible with the vis buff render pass, but loads the visibility buffer for the shade subpass
+		VkPipeline triangleSetupPipeline;
+		VkPipeline visBuffShadeCachedPipeline;
+		Buffer triangleSetupBuffer;
+		Buffer visibleTriangleBuffer; // One bit per vis buff terrain triangle, set by the first pixel of the triangle to be set up
+		Buffer triangleSetupCounterBuffer;
+#pragma endregion
+
+#pragma region Post-Transform Vertex Buffer
+		// The transform pass shares the tile shade descriptor set
+		VkPipeline vertexTransformPipeline;
+		VkPipeline visBuffWriteTransformedPipeline;
+		VkPipeline visBuffShadeTransformedPipeline;
+		Buffer transformedVertexBuffer;
+#pragma endregion
+
+#pragma region Subgroup Cooperative Fetch
+		// Only created when the device supports the subgroup operations, the shade sets of both pipelines bind the counters
+		VkPipeline visBuffShadeSubgroupPipeline = VK_NULL_HANDLE;
+		VkPipeline tessShadeSubgroupPipeline = VK_NULL_HANDLE;
+		Buffer subgroupFetchCounterBuffer;
+#pragma endregion
+
+#pragma region Multisampled Visibility Buffer
+		// Only created when the vis buff is multisampled, resolves the per-sample IDs in the shade subpass
+		VkPipeline visBuffShadeMsaaPipeline = VK_NULL_HANDLE;
+#pragma endregion
+
+#pragma region Variable Rate Compute Shading
+		// Shares the tile shade descriptor set, output image, tile size and composite draw. The output image keeps the previous
+		// frame's shading for the classify pass.
+		VkPipeline vrsClassifyPipeline;
+		VkPipeline vrsShadePipeline;
+		Buffer vrsRateBuffer; // Shading rate of each tile, written by the classify pass
+		Buffer vrsCounterBuffer;
+#pragma endregion
+
+#pragma region Temporal Shading Reuse
+		// Also shares the tile shade descriptor set, output image and composite draw. The history holds two frames so the pass
+		// never reads what it's writing.
+		VkPipeline temporalShadePipeline;
+		Buffer temporalHistoryBuffer; // Packed colour, age and visibility ID of each pixel, for the last frame and this one
+		Buffer temporalCounterBuffer;
 #pragma endregion
 
 #pragma region Geometry
-		// Two terrains, one detailed, one coarse for tessellation.
+		// Three terrains, one detailed, and coarse triangle and quad patch terrains for tessellation.
 		Terrain visBuffTerrain;
 		Terrain tessTerrain;
-		Buffer mvpUniformBuffer;
+		Terrain tessQuadTerrain;
+		MVPUniformBufferObject mvpUbo; // Written into the frame context's uniform ring slice each frame
 #pragma endregion
 
 #pragma region Input, Settings, Counters and Flags
 		PipelineType currentPipeline = VISIBILITYBUFFER;
+		bool pipelineSwitched = false; // The next frame's time is recorded as the switch's first frame
+		bool deviceIdleSwitch = false; // Switch the old way, waiting for the device and rebuilding ImGui, to compare against
+		bool fullResize = false; // Resize the old way, waiting for the device and rebuilding the pipelines, to compare against
+		double startupPipelineBuildTime = 0.0; // Part of the startup time spent in CreatePipelines, ms
 		SettingsUBO renderSettingsUbo;
 		size_t currentFrame = 0;
+		size_t lastSubmittedFrame = 0; // Context of the last submission, which SetFramesInFlight doesn't follow currentFrame to
+		uint32_t framesInFlight = 2; // Frame contexts in use, the CPU can record this many frames before waiting on the GPU
+		uint32_t framesInFlightRestore = 2; // Count when the sweep started, restored when it finishes
+		bool useSceneCache = true; // Replay the recorded scene command buffers until what they were recorded from changes
+		uint32_t sceneResourceGeneration = 0;
+		uint32_t recordThreads = 1; // Threads the scene is recorded on, 1 records on the main thread
+		uint32_t writeDrawCalls = 1;
+		bool useGpuQueries = true;
+		double timestampPeriod = 1.0; // Nanoseconds per timestamp tick
+		uint64_t timestampMask = ~0ull; // Valid bits of the graphics queue's timestamps, differences wrap at the top one
+		uint64_t submittedFrameCount = 0;
+		uint64_t completedFrameCount = 0; // Submissions whose fence has been seen signalled, everything before them has finished too
+		bool attachmentLayoutsPending = false; // Attachments created since the last frame that are used outside a render pass before they're written in one
 		bool framebufferResized = false;
 		double frameTime = 0.0;
 		double forwardPassTime = 0.0;
@@ -223,7 +695,52 @@ namespace vbt
 		bool mouseLeftDown = false;
 		bool mouseRightDown = false;
 		int visBuffTerrainTriCount = 0;
+		int visBuffTerrainVertexCount = 0;
 		int tessTerrainTriCount = 0;
+		int tessQuadPatchCount = 0;
+		bool useTessRecords = false;
+		bool useQuadPatches = false;
+		bool useDepthPrePass = false;
+		bool useUintVisibility = false; // R32_UINT visibility attachments instead of IDs packed into R8G8B8A8_UNORM
+		bool useTessFeedback = false;
+		bool resetTessFeedback = true; // Clears stored factors when feedback starts or the patch terrain changes
+		bool useSwRaster = false;
+		bool swRasterInt64 = false; // 64 bit atomics available, otherwise the two pass fallback is used
+		uint32_t swRasterMaxTriangleSize = 4;
+		bool useTileShading = false; // Compute shading of classified tiles instead of the fullscreen shade subpass
+		bool useMaterialShading = false; // Compute shading of pixels binned by material, takes precedence over tile shading
+		uint32_t materialCount = MATERIAL_COUNT_MAX;
+		bool useSetupCache = false; // Shade from attribute planes set up once per visible triangle instead of once per pixel
+		bool usePostTransform = false; // Transform the vis buff terrain once per frame in compute for both the write and shade passes
+		bool useSubgroupFetch = false; // Share each triangle fetch between the lanes of a subgroup shading it
+		bool subgroupFetchSupported = false;
+		bool drawParametersSupported = false; // Otherwise draw IDs can't be written and material binning is off
+		bool multiDrawIndirectSupported = false; // Otherwise each material draw is an indirect call of its own
+		bool pipelineStatisticsSupported = false; // Otherwise the write subpass statistics aren't queried
+		bool tessRecordsSupported = false; // The geometry stage appends the records, which needs vertex pipeline stores
+		glm::vec3 subgroupFetchSweepOrigin = glm::vec3(); // Camera position when the sweep started, restored when it finishes
+		VkSampleCountFlagBits visBuffSampleCount = VK_SAMPLE_COUNT_1_BIT; // Samples of the vis buff visibility and depth attachments
+		VkSampleCountFlagBits msaaSweepRestoreSampleCount = VK_SAMPLE_COUNT_1_BIT; // Sample count when the sweep started, restored when it finishes
+		bool useVrs = false; // Compute shading of classified tiles at a coarser rate where the previous frame was smooth
+		uint32_t vrsLevel = 2; // Aggressiveness, indexes VRS_GRADIENT_THRESHOLDS
+		bool useTemporalReuse = false; // Reuse last frame's shading where the reprojected pixel saw the same triangle
+		uint32_t temporalReuseBudget = 4;
+		uint32_t temporalFrameIndex = 0;
+		bool temporalHistoryValid = false; // The history was written by the last frame with the current settings
+		glm::mat4 currentMvp = glm::mat4(1.0f);
+		glm::mat4 previousMvp = glm::mat4(1.0f);
+		glm::vec3 temporalSweepOrigin = glm::vec3(); // Camera rotation when the sweep started, each budget pans from it and it's restored at the end
+		bool useTextureMips = true; // Sample the terrain textures' mip chains, otherwise only their full resolution level
+		bool textureLodSweepRestoreMips = true;
+		glm::vec3 textureLodSweepOrigin = glm::vec3(); // Camera position when the sweep started, restored when it finishes
+		double benchmarkElapsed = 0.0;
+		double benchmarkFrameTimeTotal = 0.0;
+		double benchmarkForwardTimeTotal = 0.0;
+		double benchmarkDeferredTimeTotal = 0.0;
+		uint64_t benchmarkTriangleTotal = 0;
+		uint32_t benchmarkFrameCount = 0;
+		std::array<Sweep, SWEEP_COUNT> sweeps; // Registered at startup, by sweep type
+		RenderStatistics statistics;
 #pragma endregion
 	};
 }
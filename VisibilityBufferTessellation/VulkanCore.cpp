@@ -15,9 +15,10 @@ namespace vbt
 		CreateSynchronisationObjects();
 	}
 
+	// The old swapchain and its image views are left for the caller to destroy once the frames using them have finished
 	void VulkanCore::RecreateSwapchain(GLFWwindow* window)
 	{
-		swapChain.InitSwapChain(window, physicalDevice.VkHandle(), device);
+		swapChain.InitSwapChain(window, physicalDevice.VkHandle(), device, swapChain.VkHandle());
 	}
 
 	void VulkanCore::CleanUp()
@@ -60,7 +61,7 @@ namespace vbt
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_1; // Extended feature queries for 64 bit atomics
 	
 		// Set up instance create info (required)
 		VkInstanceCreateInfo createInfo = {};
@@ -172,7 +173,7 @@ void VulkanCore::CreateLogicalDevice()
 
 	// Create a DeviceQueueCreateInfo for each required queue family
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentationFamily.value() };
+	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentationFamily.value(), indices.transferFamily.value_or(indices.graphicsFamily.value()) };
 
 	// Set priority for command buffer execution scheduling
 	float queuePriority = 1.0f;
@@ -193,14 +194,38 @@ void VulkanCore::CreateLogicalDevice()
 	deviceFeatures.tessellationShader = VK_TRUE;
 	deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
 
+	// Optional features, each has a fallback when it's missing
+	const VkPhysicalDeviceFeatures& supportedFeatures = physicalDevice.Features();
+	deviceFeatures.vertexPipelineStoresAndAtomics = supportedFeatures.vertexPipelineStoresAndAtomics; // Geometry stage appends tessellated triangle records
+	deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery; // Tessellator throughput statistics
+	deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect; // Multi-material scene is one indirect call of several draws
+
+	// Draw IDs written to the visibility buffer come from gl_DrawIDARB, when available
+	VkPhysicalDeviceShaderDrawParameterFeatures drawParametersFeatures = {};
+	drawParametersFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETER_FEATURES;
+	drawParametersFeatures.shaderDrawParameters = physicalDevice.SupportsDrawParameters() ? VK_TRUE : VK_FALSE;
+
+	// 64 bit atomics for the software rasteriser, when available
+	std::vector<const char*> enabledExtensions = deviceExtensions;
+	VkPhysicalDeviceShaderAtomicInt64FeaturesKHR atomicInt64Features = {};
+	atomicInt64Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES_KHR;
+	if (physicalDevice.SupportsInt64Atomics())
+	{
+		enabledExtensions.push_back(VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME);
+		deviceFeatures.shaderInt64 = VK_TRUE;
+		atomicInt64Features.shaderBufferInt64Atomics = VK_TRUE;
+		drawParametersFeatures.pNext = &atomicInt64Features;
+	}
+
 	// Create the logical device
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount = SCAST_U32(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
+	createInfo.pNext = &drawParametersFeatures;
 	createInfo.pEnabledFeatures = &deviceFeatures;
-	createInfo.enabledExtensionCount = SCAST_U32(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	createInfo.enabledExtensionCount = SCAST_U32(enabledExtensions.size());
+	createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if (enableValidationLayers)
 	{
@@ -219,6 +244,7 @@ void VulkanCore::CreateLogicalDevice()
 	// Retrieve queue handles
 	vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &physicalDevice.Queues()->graphics);
 	vkGetDeviceQueue(device, indices.presentationFamily.value(), 0, &physicalDevice.Queues()->present);
+	vkGetDeviceQueue(device, indices.transferFamily.value_or(indices.graphicsFamily.value()), 0, &physicalDevice.Queues()->transfer);
 }
 #pragma endregion
 
@@ -10,7 +10,8 @@
 #include "SwapChain.h"
 
 #pragma region Constants
-const int MAX_FRAMES_IN_FLIGHT = 1; 
+const int MAX_FRAMES_IN_FLIGHT = 3; // Frame contexts and sync objects created, the application records ahead into as many of them as its setting allows
+const uint32_t MAX_RECORD_THREADS = 8; // Worker threads started for command recording, each frame context has a command pool per thread
 #pragma endregion
 
 #pragma region Validation Layers
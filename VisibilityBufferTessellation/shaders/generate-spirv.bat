@@ -1,14 +1,79 @@
-glslangvalidator -V visbuffshade.vert -o visbuffshade.vert.spv
-glslangvalidator -V visbuffshade.frag -o visbuffshade.frag.spv
-glslangvalidator -V visbuffwrite.vert -o visbuffwrite.vert.spv
-glslangvalidator -V visbuffwrite.frag -o visbuffwrite.frag.spv
-glslangvalidator -V tessshade.vert -o tessshade.vert.spv
-glslangvalidator -V tessshade.frag -o tessshade.frag.spv
-glslangvalidator -V tesswrite.vert -o tesswrite.vert.spv
-glslangvalidator -V tesswrite.tesc -o tesswrite.tesc.spv
-glslangvalidator -V tesswrite.tese -o tesswrite.tese.spv
-glslangvalidator -V tesswrite.geom -o tesswrite.geom.spv
-glslangvalidator -V tesswrite.frag -o tesswrite.frag.spv
-glslangvalidator -V ui.vert -o ui.vert.spv
-glslangvalidator -V ui.frag -o ui.frag.spv
-pause
+glslangvalidator -V visbuffshade.vert -o visbuffshade.vert.spv || goto failed
+glslangvalidator -V visbuffshade.frag -o visbuffshade.frag.spv || goto failed
+glslangvalidator -V visbuffwrite.vert -o visbuffwrite.vert.spv || goto failed
+glslangvalidator -V visbuffwrite.frag -o visbuffwrite.frag.spv || goto failed
+glslangvalidator -V tessshade.vert -o tessshade.vert.spv || goto failed
+glslangvalidator -V tessshade.frag -o tessshade.frag.spv || goto failed
+glslangvalidator -V tesswrite.vert -o tesswrite.vert.spv || goto failed
+glslangvalidator -V tesswrite.tesc -o tesswrite.tesc.spv || goto failed
+glslangvalidator -V tesswrite.tese -o tesswrite.tese.spv || goto failed
+glslangvalidator -V tesswrite.geom -o tesswrite.geom.spv || goto failed
+glslangvalidator -V tesswrite.frag -o tesswrite.frag.spv || goto failed
+glslangvalidator -V tessquadwrite.tesc -o tessquadwrite.tesc.spv || goto failed
+glslangvalidator -V tessquadwrite.tese -o tessquadwrite.tese.spv || goto failed
+glslangvalidator -V tessquadwrite.frag -o tessquadwrite.frag.spv || goto failed
+glslangvalidator -V tessquadshade.frag -o tessquadshade.frag.spv || goto failed
+glslangvalidator -V tessrecordwrite.geom -o tessrecordwrite.geom.spv || goto failed
+glslangvalidator -V tessrecordwrite.frag -o tessrecordwrite.frag.spv || goto failed
+glslangvalidator -V tessrecordshade.frag -o tessrecordshade.frag.spv || goto failed
+glslangvalidator -V tessfeedbackcoverage.comp -o tessfeedbackcoverage.comp.spv || goto failed
+glslangvalidator -V tessfeedbackresolve.comp -o tessfeedbackresolve.comp.spv || goto failed
+glslangvalidator -V swrasterbin.comp -o swrasterbin.comp.spv || goto failed
+glslangvalidator -V swraster.comp -o swraster.comp.spv || goto failed
+glslangvalidator -V -DSW_RASTER_FALLBACK swraster.comp -o swraster.fallback.comp.spv || goto failed
+glslangvalidator -V swrastermerge.frag -o swrastermerge.frag.spv || goto failed
+glslangvalidator -V tileclassify.comp -o tileclassify.comp.spv || goto failed
+glslangvalidator -V -DTILE_SKY tileshade.comp -o tileshadesky.comp.spv || goto failed
+glslangvalidator -V -DTILE_SINGLE tileshade.comp -o tileshadesingle.comp.spv || goto failed
+glslangvalidator -V -DTILE_MULTI tileshade.comp -o tileshademulti.comp.spv || goto failed
+glslangvalidator -V tilecomposite.frag -o tilecomposite.frag.spv || goto failed
+glslangvalidator -V materialbin.comp -o materialcount.comp.spv || goto failed
+glslangvalidator -V -DMATERIAL_SCATTER materialbin.comp -o materialscatter.comp.spv || goto failed
+glslangvalidator -V materialoffsets.comp -o materialoffsets.comp.spv || goto failed
+glslangvalidator -V materialshade.comp -o materialshade.comp.spv || goto failed
+glslangvalidator -V trianglesetup.comp -o trianglesetup.comp.spv || goto failed
+glslangvalidator -V -DSETUP_CACHE visbuffshade.frag -o visbuffshadecached.frag.spv || goto failed
+glslangvalidator -V vertextransform.comp -o vertextransform.comp.spv || goto failed
+glslangvalidator -V -DPOST_TRANSFORM visbuffwrite.vert -o visbuffwritetransformed.vert.spv || goto failed
+glslangvalidator -V -DNO_DRAW_PARAMETERS visbuffwrite.vert -o visbuffwrite.nodrawparams.vert.spv || goto failed
+glslangvalidator -V -DPOST_TRANSFORM -DNO_DRAW_PARAMETERS visbuffwrite.vert -o visbuffwritetransformed.nodrawparams.vert.spv || goto failed
+glslangvalidator -V -DPOST_TRANSFORM visbuffshade.frag -o visbuffshadetransformed.frag.spv || goto failed
+glslangvalidator -V --target-env vulkan1.1 -DSUBGROUP_FETCH visbuffshade.frag -o visbuffshadesubgroup.frag.spv || goto failed
+glslangvalidator -V -DMSAA visbuffshade.frag -o visbuffshademsaa.frag.spv || goto failed
+glslangvalidator -V vrsclassify.comp -o vrsclassify.comp.spv || goto failed
+glslangvalidator -V vrsshade.comp -o vrsshade.comp.spv || goto failed
+glslangvalidator -V temporalshade.comp -o temporalshade.comp.spv || goto failed
+glslangvalidator -V --target-env vulkan1.1 -DSUBGROUP_FETCH tessshade.frag -o tessshadesubgroup.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT visbuffshade.frag -o visbuffshade.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT visbuffwrite.frag -o visbuffwrite.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessshade.frag -o tessshade.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tesswrite.frag -o tesswrite.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessquadwrite.frag -o tessquadwrite.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessquadshade.frag -o tessquadshade.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessrecordwrite.frag -o tessrecordwrite.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessrecordshade.frag -o tessrecordshade.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tessfeedbackcoverage.comp -o tessfeedbackcoverage.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT swrastermerge.frag -o swrastermerge.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT tileclassify.comp -o tileclassify.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DTILE_SINGLE tileshade.comp -o tileshadesingle.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DTILE_MULTI tileshade.comp -o tileshademulti.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT materialbin.comp -o materialcount.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DMATERIAL_SCATTER materialbin.comp -o materialscatter.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT trianglesetup.comp -o trianglesetup.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DSETUP_CACHE visbuffshade.frag -o visbuffshadecached.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DPOST_TRANSFORM visbuffshade.frag -o visbuffshadetransformed.uint.frag.spv || goto failed
+glslangvalidator -V --target-env vulkan1.1 -DVISIBILITY_UINT -DSUBGROUP_FETCH visbuffshade.frag -o visbuffshadesubgroup.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT -DMSAA visbuffshade.frag -o visbuffshademsaa.uint.frag.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT vrsclassify.comp -o vrsclassify.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT vrsshade.comp -o vrsshade.uint.comp.spv || goto failed
+glslangvalidator -V -DVISIBILITY_UINT temporalshade.comp -o temporalshade.uint.comp.spv || goto failed
+glslangvalidator -V --target-env vulkan1.1 -DVISIBILITY_UINT -DSUBGROUP_FETCH tessshade.frag -o tessshadesubgroup.uint.frag.spv || goto failed
+glslangvalidator -V ui.vert -o ui.vert.spv || goto failed
+glslangvalidator -V ui.frag -o ui.frag.spv || goto failed
+if not "%1"=="nopause" pause
+exit /b 0
+
+:failed
+echo SPIR-V generation failed
+if not "%1"=="nopause" pause
+exit /b 1
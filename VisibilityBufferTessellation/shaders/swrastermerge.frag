@@ -0,0 +1,51 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// In
+layout(location = 0) in vec2 inScreenPos;
+
+// Out 
+layout(location = 0) out vec4 outColour;
+#ifdef VISIBILITY_UINT
+layout(location = 1) out uint visBuff;
+#else
+layout(location = 1) out vec4 visBuff;
+#endif
+
+// Descriptors
+layout(std430, binding = 7) readonly buffer SoftwareVisibilityBuff
+{
+	uint visibility[]; // Pairs of visibility ID and depth key, read as 32 bit words so no int64 support is needed here
+};
+layout(push_constant) uniform PushConstants
+{
+	uint screenWidth;
+	uint screenHeight;
+	uint maxTriangleSize;
+	uint triangleCount;
+	uint pass;
+} constants;
+
+// Copies the software rasterised triangles into the visibility and depth attachments before the hardware triangles are drawn
+void main() 
+{
+	uvec2 pixelCoord = uvec2(gl_FragCoord.xy);
+	if (pixelCoord.x >= constants.screenWidth || pixelCoord.y >= constants.screenHeight)
+		discard;
+
+	uint pixel = pixelCoord.y * constants.screenWidth + pixelCoord.x;
+	uint visibilityID = visibility[pixel * 2];
+	uint depthKey = visibility[pixel * 2 + 1];
+	if (visibilityID == 0)
+		discard;
+
+	// Hardware triangles are then depth tested against the software depth
+	gl_FragDepth = uintBitsToFloat(0xFFFFFFFFu - depthKey);
+	outColour = vec4(0.0);
+#ifdef VISIBILITY_UINT
+	visBuff = visibilityID;
+#else
+	visBuff = unpackUnorm4x8(visibilityID);
+#endif
+}
\ No newline at end of file
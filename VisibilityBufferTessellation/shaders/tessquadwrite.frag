@@ -0,0 +1,50 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+#define PRIMITIVE_ID_BITS 23
+
+// Force early depth/stencil test
+layout(early_fragment_tests) in;
+
+// In
+layout (location = 0) flat in int primitiveID;
+layout (location = 1) flat in uvec3 inTessCoords;
+// Out 
+layout(location = 0) out vec4 outColour;
+#ifdef VISIBILITY_UINT
+layout(location = 1) out uint visBuff;
+#else
+layout(location = 1) out vec4 visBuff;
+#endif
+layout(location = 2) out vec4 tessCoordsBuff1;
+layout(location = 3) out vec4 tessCoordsBuff2;
+
+// Engel's packing function (without alpha bit)
+uint calculateOutputVBID(uint drawID, uint primitiveID)
+{
+	uint drawID_primID = ((drawID << 23) & 0x7F800000) | (primitiveID & 0x007FFFFF);
+	return drawID_primID;
+}
+
+void main() 
+{
+	// Write to colour attachments to avoid undefined behaviour
+	outColour = vec4(0.0); 
+
+	// Fill visibility buffer
+#ifdef VISIBILITY_UINT
+	visBuff = calculateOutputVBID(0, primitiveID + 1); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#else
+	visBuff = unpackUnorm4x8(calculateOutputVBID(0, primitiveID + 1)); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#endif
+
+	// Recover quad domain tess coords from geometry shader, only two per vertex
+	vec2 tessCoord0 = unpackUnorm4x8(inTessCoords.x).xy;
+	vec2 tessCoord1 = unpackUnorm4x8(inTessCoords.y).xy;
+	vec2 tessCoord2 = unpackUnorm4x8(inTessCoords.z).xy;
+
+	// Six coordinates fit in the first two tess coords buffers, the third is masked out for quad patches
+	tessCoordsBuff1 = vec4(tessCoord0, tessCoord1);
+	tessCoordsBuff2 = vec4(tessCoord2, 0.0, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// Structs
+struct TessTriangleRecord
+{
+	vec4 clipPos[3];
+	vec4 texCoords01;
+	vec4 texCoords2;
+};
+struct DerivativesOutput
+{
+	vec3 dbDx;
+	vec3 dbDy;
+};
+
+// Constants
+const float heightTexScale = 8.0f;
+
+// In
+layout(location = 0) in vec2 inScreenPos;
+
+// Out
+layout(location = 0) out vec4 outColour;
+
+// Descriptors
+layout (set = 0, binding = 0) uniform sampler2D textureSampler;
+#ifdef VISIBILITY_UINT
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform usubpassInput inputVisibility;
+#else
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform subpassInput inputVisibility;
+#endif
+layout(set = 0, binding = 5) uniform SettingsUniformBufferObject
+{
+	uint tessellationFactor;
+	uint showVisibilityBuffer;
+	uint showTessCoordsBuffer;
+	uint showInterpolatedTexCoords;
+	uint wireframe;
+	uint tessRecordCapacity;
+} settings;
+layout(set = 0, binding = 7) uniform sampler2D normalmap;
+layout(set = 0, binding = 8) uniform DirectionalLightUniformBufferObject
+{
+	vec4 direction;
+	vec4 ambient;
+	vec4 diffuse;
+} light;
+layout (std430, set = 0, binding = 12) readonly buffer TessRecordBuff
+{
+	TessTriangleRecord records[];
+};
+
+// Interpolate 2D attributes using the partial derivatives and generates dx and dy for texture sampling.
+vec2 Interpolate2DAttributes(mat3x2 attributes, vec3 dbDx, vec3 dbDy, vec2 d)
+{
+	vec3 attr0 = vec3(attributes[0].x, attributes[1].x, attributes[2].x);
+	vec3 attr1 = vec3(attributes[0].y, attributes[1].y, attributes[2].y);
+	vec2 attribute_x = vec2(dot(dbDx,attr0), dot(dbDx,attr1));
+	vec2 attribute_y = vec2(dot(dbDy,attr0), dot(dbDy,attr1));
+	vec2 attribute_s = attributes[0];
+	
+	vec2 result = (attribute_s + d.x * attribute_x + d.y * attribute_y);
+	return result;
+}
+
+vec3 Interpolate3DAttributes(mat3 attributes, vec3 dbDx, vec3 dbDy, vec2 d)
+{
+	vec3 attribute_x = attributes * dbDx;
+	vec3 attribute_y = attributes * dbDy;
+	vec3 attribute_s = attributes[0];
+	
+	return (attribute_s + d.x * attribute_x + d.y * attribute_y);
+}
+
+// Engel's barycentric coord partial derivs function. Follows equation from [Schied][Dachsbacher]
+// Computes the partial derivatives of point's barycentric coordinates from the projected screen space vertices
+DerivativesOutput ComputePartialDerivatives(vec2 v[3])
+{
+	DerivativesOutput derivatives;
+	float d = 1.0 / determinant(mat2(v[2] - v[1], v[0] - v[1]));
+	derivatives.dbDx = vec3(v[1].y - v[2].y, v[2].y - v[0].y, v[0].y - v[1].y) * d;
+	derivatives.dbDy = vec3(v[2].x - v[1].x, v[0].x - v[2].x, v[1].x - v[0].x) * d;
+	return derivatives;
+}
+
+void main() 
+{
+	// Unpack triangle record index from visibility buffer
+#ifdef VISIBILITY_UINT
+	uint recordID = subpassLoad(inputVisibility).r;
+#else
+	uint recordID = packUnorm4x8(subpassLoad(inputVisibility));
+#endif
+
+	// Size of a pixel in normalised device coordinates, taken before any branching as the full screen position is the same on every triangle
+	vec2 pixelSize = vec2(dFdx(inScreenPos.x), dFdy(inScreenPos.y));
+
+	// If this pixel doesn't contain triangle data, return early
+	if (recordID != 0)
+	{
+		// Load the displaced triangle written by the geometry stage, no patch evaluation or heightmap sampling required
+		TessTriangleRecord record = records[recordID - 1];
+
+		// Pre-calculate 1 over w components
+		vec3 oneOverW = 1.0 / vec3(record.clipPos[0].w, record.clipPos[1].w, record.clipPos[2].w);
+
+		// Calculate 2D screen positions
+		vec2 screenPositions[3] = { record.clipPos[0].xy * oneOverW[0], record.clipPos[1].xy * oneOverW[1], record.clipPos[2].xy * oneOverW[2] };
+
+		// Get barycentric coordinates for attribute interpolation
+		DerivativesOutput derivatives = ComputePartialDerivatives(screenPositions);
+
+		// Get delta vector that describes current screen point relative to vertex 0
+		vec2 delta = inScreenPos + -screenPositions[0];
+
+		// Interpolate texture coordinates
+		mat3x2 triTexCoords =
+		{
+			record.texCoords01.xy,
+			record.texCoords01.zw,
+			record.texCoords2.xy
+		};
+		vec2 interpTexCoords = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta);
+
+		// Interpolate normal, sampled at each vertex like the tessellation shade pass
+		mat3 triNormals =
+		{
+			texture(normalmap, triTexCoords[0] / heightTexScale).rgb,
+			texture(normalmap, triTexCoords[1] / heightTexScale).rgb,
+			texture(normalmap, triTexCoords[2] / heightTexScale).rgb
+		};
+		vec3 interpNorm = Interpolate3DAttributes(triNormals, derivatives.dbDx, derivatives.dbDy, delta);
+
+		// Get fragment colour from texture, with gradients over one pixel from the barycentric derivatives. Implicit derivatives
+		// would be taken across the pixel quad, which may cover other triangles.
+		vec2 texCoordsDx = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(pixelSize.x, 0.0f)) - interpTexCoords;
+		vec2 texCoordsDy = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(0.0f, pixelSize.y)) - interpTexCoords;
+		vec4 textureDiffuseColour = textureGrad(textureSampler, interpTexCoords, texCoordsDx, texCoordsDy);
+
+		// Calculate directional light colour contribution
+		vec4 lightColour = light.ambient;
+		float lightIntensity = clamp(dot(-interpNorm, light.direction.xyz), 0.0f, 1.0f);
+		lightColour += light.diffuse * lightIntensity;
+		lightColour = clamp(lightColour, 0.0f, 1.0f);
+
+		// Final Fragment colour
+		outColour =  clamp(textureDiffuseColour * lightColour, 0.0f, 1.0f);
+
+		// Draw visibility buffer images instead if settings are used.
+		if (settings.showVisibilityBuffer == 1)
+			outColour = unpackUnorm4x8(recordID);
+		else if (settings.showInterpolatedTexCoords == 1)
+			outColour = vec4(normalize(abs(interpTexCoords)), 0.0f, 1.0f);
+	}
+	else
+	{
+		outColour = vec4(0.35f, 0.55f, 0.7f, 1.0f);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// Force early depth/stencil test
+layout(early_fragment_tests) in;
+
+// In
+layout (location = 0) flat in uint recordID;
+// Out 
+layout(location = 0) out vec4 outColour;
+#ifdef VISIBILITY_UINT
+layout(location = 1) out uint visBuff;
+#else
+layout(location = 1) out vec4 visBuff;
+#endif
+
+void main() 
+{
+	// Write to colour attachments to avoid undefined behaviour
+	outColour = vec4(0.0); 
+
+	// The visibility buffer stores the full 32 bit record index, the tess coords attachments are masked out in this mode
+#ifdef VISIBILITY_UINT
+	visBuff = recordID;
+#else
+	visBuff = unpackUnorm4x8(recordID);
+#endif
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#ifdef SUBGROUP_FETCH
+#extension GL_KHR_shader_subgroup_basic : enable
+#extension GL_KHR_shader_subgroup_ballot : enable
+#endif
 
 // Structs
 struct Vertex
@@ -30,7 +34,11 @@ layout(location = 0) out vec4 outColour;
 
 // Descriptors
 layout (set = 0, binding = 0) uniform sampler2D textureSampler;
+#ifdef VISIBILITY_UINT
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform usubpassInput inputVisibility;
+#else
 layout (input_attachment_index = 0, set = 0, binding = 1) uniform subpassInput inputVisibility;
+#endif
 layout (input_attachment_index = 1, set = 0, binding = 9) uniform subpassInput inputTessCoords1;
 layout (input_attachment_index = 1, set = 0, binding = 10) uniform subpassInput inputTessCoords2;
 layout (input_attachment_index = 1, set = 0, binding = 11) uniform subpassInput inputTessCoords3;
@@ -63,6 +71,13 @@ layout(set = 0, binding = 8) uniform DirectionalLightUniformBufferObject
 	vec4 ambient;
 	vec4 diffuse;
 } light;
+#ifdef SUBGROUP_FETCH
+layout (std430, set = 0, binding = 13) buffer SubgroupFetchCountBuff
+{
+	uint fetchCount; // Triangle fetches made by the shade pass
+	uint fetchPixelCount; // Pixels that shared them
+};
+#endif
 
 vec2 Interpolate2DLinear(vec2 v0, vec2 v1, vec2 v2, vec3 tessCoord)
 {
@@ -167,14 +182,20 @@ Vertex[3] EvaluateTessellatedPrimitive(Vertex[3] patchControlPoints, vec4 tessCo
 void main() 
 {
 	// Unpack triangle ID and draw ID from visibility buffer
-	vec4 visibilityRaw = subpassLoad(inputVisibility);
+#ifdef VISIBILITY_UINT
+	uint DrawIdTriId = subpassLoad(inputVisibility).r;
+#else
+	uint DrawIdTriId = packUnorm4x8(subpassLoad(inputVisibility));
+#endif
 	vec4 tessCoords_v1XYZ_v2X = subpassLoad(inputTessCoords1);
 	vec4 tessCoords_v2YZ_v3XY = subpassLoad(inputTessCoords2);
 	float tessCoords_v3Z = subpassLoad(inputTessCoords3).x;
-	uint DrawIdTriId = packUnorm4x8(visibilityRaw);
+
+	// Size of a pixel in normalised device coordinates, taken before any branching as the full screen position is the same on every triangle
+	vec2 pixelSize = vec2(dFdx(inScreenPos.x), dFdy(inScreenPos.y));
 
 	// If this pixel doesn't contain triangle data, return early
-	if (visibilityRaw != vec4(0.0))
+	if (DrawIdTriId != 0)
 	{
 		// Output debug tess coords
 		vec4 tessCoordsColour = vec4(packUnorm4x8(vec4(tessCoords_v1XYZ_v2X.xyz, 0)), packUnorm4x8(vec4(tessCoords_v1XYZ_v2X.w, tessCoords_v2YZ_v3XY.xy, 0)), packUnorm4x8(vec4(tessCoords_v2YZ_v3XY.zw, tessCoords_v3Z, 0)), 1.0);
@@ -183,8 +204,41 @@ void main()
 		uint drawID = (DrawIdTriId >> 23) & 0x000000FF; // Draw ID the number of draw call to which the triangle belongs
 		uint triangleID = (DrawIdTriId & 0x007FFFFF) - 1; // Triangle ID is the offset of the triangle within the draw call. i.e. it is relative to drawID
 		
+#ifdef SUBGROUP_FETCH
+		// Lanes in the same patch share one fetch of its control points. Each time round the loop the first remaining lane loads
+		// its patch and broadcasts it to the lanes with the same ID, which then drop out. Tessellated primitives differ per lane,
+		// so each lane still evaluates its own.
+		Vertex[3] patchControlPoints;
+		bool fetchLeader = false;
+		for (;;)
+		{
+			if (DrawIdTriId == subgroupBroadcastFirst(DrawIdTriId))
+			{
+				// The first active lane started this pass of the loop, so it's the one broadcast from
+				fetchLeader = subgroupElect();
+				if (fetchLeader)
+					patchControlPoints = LoadPatchControlPoints(drawID, triangleID);
+				for (uint i = 0; i < 3; i++)
+				{
+					patchControlPoints[i].posXYZnormX = subgroupBroadcastFirst(patchControlPoints[i].posXYZnormX);
+					patchControlPoints[i].normYZtexXY = subgroupBroadcastFirst(patchControlPoints[i].normYZtexXY);
+				}
+				break;
+			}
+		}
+
+		// Statistics, one atomic per subgroup from its first lane that isn't a helper invocation
+		uvec4 shadingLanes = subgroupBallot(!gl_HelperInvocation);
+		uint subgroupFetches = subgroupBallotBitCount(subgroupBallot(fetchLeader));
+		if (gl_SubgroupInvocationID == subgroupBallotFindLSB(shadingLanes))
+		{
+			atomicAdd(fetchCount, subgroupFetches);
+			atomicAdd(fetchPixelCount, subgroupBallotBitCount(shadingLanes));
+		}
+#else
 		// Load input patch control points using visibility buffer data
 		Vertex[3] patchControlPoints = LoadPatchControlPoints(drawID, triangleID);
+#endif
 
 		// Now interpolate to the generated tessellation primitive using stored tess coords
 		Vertex[3] primitiveVertices = EvaluateTessellatedPrimitive(patchControlPoints, tessCoords_v1XYZ_v2X, tessCoords_v2YZ_v3XY, tessCoords_v3Z);
@@ -242,8 +296,11 @@ void main()
 		};
 		vec3 interpNorm = Interpolate3DAttributes(triNormals, derivatives.dbDx, derivatives.dbDy, delta);
 
-		// Get fragment colour from texture
-		vec4 textureDiffuseColour = texture(textureSampler, interpTexCoords);
+		// Get fragment colour from texture, with gradients over one pixel from the barycentric derivatives. Implicit derivatives
+		// would be taken across the pixel quad, which may cover other triangles.
+		vec2 texCoordsDx = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(pixelSize.x, 0.0f)) - interpTexCoords;
+		vec2 texCoordsDy = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(0.0f, pixelSize.y)) - interpTexCoords;
+		vec4 textureDiffuseColour = textureGrad(textureSampler, interpTexCoords, texCoordsDx, texCoordsDy);
 
 		// Calculate directional light colour contribution
 		vec4 lightColour = light.ambient;
@@ -256,7 +313,7 @@ void main()
 
 		// Draw visibility buffer images instead if settings are used.
 		if (settings.showVisibilityBuffer == 1)
-			outColour = visibilityRaw;
+			outColour = unpackUnorm4x8(DrawIdTriId);
 		else if (settings.showTessCoordsBuffer == 1)
 			outColour = tessCoordsColour;
 		else if (settings.showInterpolatedTexCoords == 1)
@@ -12,7 +12,11 @@ layout (location = 0) flat in int primitiveID;
 layout (location = 1) flat in uvec3 inTessCoords;
 // Out 
 layout(location = 0) out vec4 outColour;
+#ifdef VISIBILITY_UINT
+layout(location = 1) out uint visBuff;
+#else
 layout(location = 1) out vec4 visBuff;
+#endif
 layout(location = 2) out vec4 tessCoordsBuff1;
 layout(location = 3) out vec4 tessCoordsBuff2;
 layout(location = 4) out float tessCoordsBuff3;
@@ -30,7 +34,11 @@ void main()
 	outColour = vec4(0.0); 
 
 	// Fill visibility buffer
+#ifdef VISIBILITY_UINT
+	visBuff = calculateOutputVBID(0, primitiveID + 1); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#else
 	visBuff = unpackUnorm4x8(calculateOutputVBID(0, primitiveID + 1)); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#endif
 
 	// Recover tess coords from geometry shader
 	vec3 tessCoord0 = unpackUnorm4x8(inTessCoords.x).xyz;
@@ -10,6 +10,7 @@ layout(location = 2) in vec2 inTexCoords;
 
 // Out
 layout(location = 0) out vec2 outTexCoords;
+layout(location = 1) out uint outVertexIndex;
 out gl_PerVertex
 {
 	vec4 gl_Position;
@@ -20,4 +21,5 @@ void main()
 {
 	gl_Position = vec4(inPosition, 1.0);
 	outTexCoords = inTexCoords;
+	outVertexIndex = gl_VertexIndex; // Feedback tess factors are stored per terrain vertex
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// In
+layout(location = 0) in vec2 inScreenPos;
+
+// Out
+layout(location = 0) out vec4 outColour;
+
+// Descriptors
+layout(binding = 9, rgba8) uniform readonly image2D shadedImage;
+
+// Copies the compute shaded image to the swapchain before the UI is drawn over it
+void main() 
+{
+	outColour = imageLoad(shadedImage, ivec2(gl_FragCoord.xy));
+}
\ No newline at end of file
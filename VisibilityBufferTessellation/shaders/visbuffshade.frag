@@ -1,6 +1,10 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#ifdef SUBGROUP_FETCH
+#extension GL_KHR_shader_subgroup_basic : enable
+#extension GL_KHR_shader_subgroup_ballot : enable
+#endif
 
 // Structs
 struct Vertex
@@ -17,10 +21,30 @@ struct DerivativesOutput
 	vec3 dbDx;
 	vec3 dbDy;
 };
+#ifdef SETUP_CACHE
+// Screen space planes of the interpolated attributes, written by the triangle setup pass
+struct TriangleSetup
+{
+	vec4 texCoordPlanes[2];
+	vec4 normalPlanes[3];
+};
+#endif
+#ifdef POST_TRANSFORM
+// Transformed and displaced vertex, written by the vertex transform pass
+struct TransformedVertex
+{
+	vec4 clipPosition;
+	vec4 positionTexU;
+	vec4 normalTexV;
+};
+#endif
 
 // Constants
 const float heightTexScale = 8.0f;
 const float heightScale = 5.0f;
+#ifdef MSAA
+layout (constant_id = 0) const int sampleCount = 4;
+#endif
 
 // In
 layout(location = 0) in vec2 inScreenPos;
@@ -30,7 +54,15 @@ layout(location = 0) out vec4 outColour;
 
 // Descriptors
 layout (set = 0, binding = 0) uniform sampler2D textureSampler;
+#if defined(VISIBILITY_UINT) && defined(MSAA)
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform usubpassInputMS inputVisibility;
+#elif defined(VISIBILITY_UINT)
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform usubpassInput inputVisibility;
+#elif defined(MSAA)
+layout (input_attachment_index = 0, set = 0, binding = 1) uniform subpassInputMS inputVisibility;
+#else
 layout (input_attachment_index = 0, set = 0, binding = 1) uniform subpassInput inputVisibility;
+#endif
 layout(set = 0, binding = 2) uniform UniformBufferObject 
 {
     mat4 mvp;
@@ -60,6 +92,25 @@ layout(set = 0, binding = 8) uniform DirectionalLightUniformBufferObject
 	vec4 ambient;
 	vec4 diffuse;
 } light;
+#ifdef SETUP_CACHE
+layout (std430, set = 0, binding = 9) readonly buffer TriangleSetupBuff
+{
+	TriangleSetup triangleSetups[];
+};
+#endif
+#ifdef POST_TRANSFORM
+layout (std430, set = 0, binding = 10) readonly buffer TransformedVertBuff
+{
+	TransformedVertex transformedVertices[];
+};
+#endif
+#ifdef SUBGROUP_FETCH
+layout (std430, set = 0, binding = 13) buffer SubgroupFetchCountBuff
+{
+	uint fetchCount; // Triangle fetches made by the shade pass
+	uint fetchPixelCount; // Pixels that shared them
+};
+#endif
 
 // Interpolate 2D attributes using the partial derivatives and generates dx and dy for texture sampling.
 vec2 Interpolate2DAttributes(mat3x2 attributes, vec3 dbDx, vec3 dbDy, vec2 d)
@@ -121,18 +172,130 @@ Vertex[3] LoadTriangleVertices(uint drawID, uint primID)
 	return vertices;
 }
 
-void main() 
+#ifdef SUBGROUP_FETCH
+// Loads, displaces and projects a triangle for the lanes sharing it. Only one lane runs this, so there are no pixel quads to take
+// implicit derivatives from and the vertex samples are taken from the top mip.
+void SetupTriangle(uint drawID, uint primID, out vec2 screenPos0, out DerivativesOutput derivatives, out mat3x2 triTexCoords, out mat3 triNormals)
 {
-	// Unpack triangle ID and draw ID from visibility buffer
-	vec4 visibilityRaw = subpassLoad(inputVisibility);
-	uint DrawIdTriId = packUnorm4x8(visibilityRaw);	
+	Vertex[3] vertices = LoadTriangleVertices(drawID, primID);
+	vec2 screenPositions[3];
+	for (uint i = 0; i < 3; i++)
+	{
+		vec2 heightTexCoords = vertices[i].normYZtexXY.zw / heightTexScale;
+		vec3 position = vertices[i].posXYZnormX.xyz;
+		position.y += textureLod(heightmap, heightTexCoords, 0.0f).r * heightScale;
+		vec4 clipPos = ubo.mvp * vec4(position, 1);
+		screenPositions[i] = clipPos.xy / clipPos.w;
+		triTexCoords[i] = vertices[i].normYZtexXY.zw;
+		triNormals[i] = textureLod(normalmap, heightTexCoords, 0.0f).rgb;
+	}
+	screenPos0 = screenPositions[0];
+	derivatives = ComputePartialDerivatives(screenPositions);
+}
+#endif
+
+#ifdef POST_TRANSFORM
+// Same as LoadTriangleVertices, but from the vertices transformed this frame
+TransformedVertex[3] LoadTransformedVertices(uint drawID, uint primID)
+{
+	TransformedVertex[3] vertices;
+	uint startIndex = drawID;
+	for (uint i = 0; i < 3; i++)
+		vertices[i] = transformedVertices[indexBuffer[primID * 3 + i + startIndex].val];
+	return vertices;
+}
+#endif
+
+// Size of a pixel in normalised device coordinates. Neighbouring pixels in the quad may be on other triangles, and the MSAA path
+// shades in a loop over the pixel's triangles, so texture gradients are taken from the barycentric derivatives over one pixel.
+vec2 pixelSize;
+
+// Shades the triangle with the given packed draw and triangle ID at this pixel, or the sky if there isn't one
+vec4 ShadeVisibilityID(uint DrawIdTriId)
+{
+	vec4 colour;
 
 	// If this pixel doesn't contain triangle data, return early
-	if (visibilityRaw != vec4(0.0))
+	if (DrawIdTriId != 0)
 	{
 		uint drawID = (DrawIdTriId >> 23) & 0x000000FF; // Draw ID the index of the draw call to which the triangle belongs
 		uint triangleID = (DrawIdTriId & 0x007FFFFF) - 1; // Triangle ID is the offset of the triangle within the draw call. i.e. it is relative to drawID		
 		
+#ifdef SETUP_CACHE
+		// The triangle was set up once this frame by the setup pass, so interpolation is a load and a dot product per attribute
+		TriangleSetup setup = triangleSetups[triangleID];
+		vec3 screenPos = vec3(inScreenPos, 1.0f);
+		vec2 interpTexCoords = vec2(dot(setup.texCoordPlanes[0].xyz, screenPos), dot(setup.texCoordPlanes[1].xyz, screenPos));
+		vec3 interpNorm = vec3(dot(setup.normalPlanes[0].xyz, screenPos), dot(setup.normalPlanes[1].xyz, screenPos), dot(setup.normalPlanes[2].xyz, screenPos));
+#elif defined(POST_TRANSFORM)
+		// Vertices were transformed and displaced once this frame, so there's no texture sampling for the geometry
+		TransformedVertex[3] vertices = LoadTransformedVertices(drawID, triangleID);
+		vec2 screenPositions[3] =
+		{
+			vertices[0].clipPosition.xy / vertices[0].clipPosition.w,
+			vertices[1].clipPosition.xy / vertices[1].clipPosition.w,
+			vertices[2].clipPosition.xy / vertices[2].clipPosition.w
+		};
+		DerivativesOutput derivatives = ComputePartialDerivatives(screenPositions);
+		vec2 delta = inScreenPos + -screenPositions[0];
+
+		// Interpolate texture coordinates and normal
+		mat3x2 triTexCoords =
+		{
+			vec2(vertices[0].positionTexU.w, vertices[0].normalTexV.w),
+			vec2(vertices[1].positionTexU.w, vertices[1].normalTexV.w),
+			vec2(vertices[2].positionTexU.w, vertices[2].normalTexV.w)
+		};
+		vec2 interpTexCoords = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta);
+		mat3 triNormals =
+		{
+			vertices[0].normalTexV.xyz,
+			vertices[1].normalTexV.xyz,
+			vertices[2].normalTexV.xyz
+		};
+		vec3 interpNorm = Interpolate3DAttributes(triNormals, derivatives.dbDx, derivatives.dbDy, delta);
+#elif defined(SUBGROUP_FETCH)
+		// Lanes shading the same triangle share one fetch. Each time round the loop the first remaining lane sets up its triangle
+		// and broadcasts it to the lanes with the same ID, which then drop out.
+		vec2 screenPos0;
+		DerivativesOutput derivatives;
+		mat3x2 triTexCoords;
+		mat3 triNormals;
+		bool fetchLeader = false;
+		for (;;)
+		{
+			if (DrawIdTriId == subgroupBroadcastFirst(DrawIdTriId))
+			{
+				// The first active lane started this pass of the loop, so it's the one broadcast from
+				fetchLeader = subgroupElect();
+				if (fetchLeader)
+					SetupTriangle(drawID, triangleID, screenPos0, derivatives, triTexCoords, triNormals);
+				screenPos0 = subgroupBroadcastFirst(screenPos0);
+				derivatives.dbDx = subgroupBroadcastFirst(derivatives.dbDx);
+				derivatives.dbDy = subgroupBroadcastFirst(derivatives.dbDy);
+				for (uint i = 0; i < 3; i++)
+				{
+					triTexCoords[i] = subgroupBroadcastFirst(triTexCoords[i]);
+					triNormals[i] = subgroupBroadcastFirst(triNormals[i]);
+				}
+				break;
+			}
+		}
+
+		// Statistics, one atomic per subgroup from its first lane that isn't a helper invocation
+		uvec4 shadingLanes = subgroupBallot(!gl_HelperInvocation);
+		uint subgroupFetches = subgroupBallotBitCount(subgroupBallot(fetchLeader));
+		if (gl_SubgroupInvocationID == subgroupBallotFindLSB(shadingLanes))
+		{
+			atomicAdd(fetchCount, subgroupFetches);
+			atomicAdd(fetchPixelCount, subgroupBallotBitCount(shadingLanes));
+		}
+
+		// Interpolate texture coordinates and normal
+		vec2 delta = inScreenPos + -screenPos0;
+		vec2 interpTexCoords = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta);
+		vec3 interpNorm = Interpolate3DAttributes(triNormals, derivatives.dbDx, derivatives.dbDy, delta);
+#else
 		// Load triangle vertices using visibility buffer data
 		Vertex[3] vertices = LoadTriangleVertices(drawID, triangleID);
 
@@ -188,9 +351,18 @@ void main()
 			vert2Norm
 		};
 		vec3 interpNorm = Interpolate3DAttributes(triNormals, derivatives.dbDx, derivatives.dbDy, delta);
+#endif
 
 		// Get fragment colour from texture
-		vec4 textureDiffuseColour = texture(textureSampler, interpTexCoords);
+#ifdef SETUP_CACHE
+		// The x and y coefficients of the texture coordinate planes are their gradients in screen space
+		vec2 texCoordsDx = vec2(setup.texCoordPlanes[0].x, setup.texCoordPlanes[1].x) * pixelSize.x;
+		vec2 texCoordsDy = vec2(setup.texCoordPlanes[0].y, setup.texCoordPlanes[1].y) * pixelSize.y;
+#else
+		vec2 texCoordsDx = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(pixelSize.x, 0.0f)) - interpTexCoords;
+		vec2 texCoordsDy = Interpolate2DAttributes(triTexCoords, derivatives.dbDx, derivatives.dbDy, delta + vec2(0.0f, pixelSize.y)) - interpTexCoords;
+#endif
+		vec4 textureDiffuseColour = textureGrad(textureSampler, interpTexCoords, texCoordsDx, texCoordsDy);
 
 		// Calculate directional light colour contribution
 		vec4 lightColour = light.ambient;
@@ -199,17 +371,62 @@ void main()
 		lightColour = clamp(lightColour, 0.0f, 1.0f);
 
 		// Final Fragment colour
-		outColour =  clamp(textureDiffuseColour * lightColour, 0.0f, 1.0f);
+		colour =  clamp(textureDiffuseColour * lightColour, 0.0f, 1.0f);
 
 		// Draw visibility buffer instead if setting is used.
 		if (settings.showVisibilityBuffer == 1)
-			outColour = visibilityRaw;
+			colour = unpackUnorm4x8(DrawIdTriId);
 		else if (settings.showInterpolatedTexCoords == 1)
-			outColour = vec4(normalize(abs(interpTexCoords)), 0.0f, 1.0f);
-			//outColour = vec4(interpNorm, 1.0f);
+			colour = vec4(normalize(abs(interpTexCoords)), 0.0f, 1.0f);
+			//colour = vec4(interpNorm, 1.0f);
 	}
 	else
 	{
-		outColour = vec4(0.35f, 0.55f, 0.7f, 1.0f);
+		colour = vec4(0.35f, 0.55f, 0.7f, 1.0f);
+	}
+	return colour;
+}
+
+void main() 
+{
+	pixelSize = vec2(dFdx(inScreenPos.x), dFdy(inScreenPos.y));
+#ifdef MSAA
+
+	// Gather the distinct IDs in the pixel's samples and how many samples each covers. Interior pixels have one ID and are
+	// shaded once, only edge pixels shade more than one triangle.
+	uint sampleIDs[sampleCount];
+	uint sampleCoverage[sampleCount];
+	int distinctIDs = 0;
+	for (int s = 0; s < sampleCount; s++)
+	{
+#ifdef VISIBILITY_UINT
+		uint DrawIdTriId = subpassLoad(inputVisibility, s).r;
+#else
+		uint DrawIdTriId = packUnorm4x8(subpassLoad(inputVisibility, s));
+#endif
+		int i = 0;
+		while (i < distinctIDs && sampleIDs[i] != DrawIdTriId)
+			i++;
+		if (i == distinctIDs)
+		{
+			sampleIDs[i] = DrawIdTriId;
+			sampleCoverage[i] = 0;
+			distinctIDs++;
+		}
+		sampleCoverage[i]++;
 	}
+
+	// Resolve by weighting each triangle's colour by its coverage
+	outColour = vec4(0.0f);
+	for (int i = 0; i < distinctIDs; i++)
+		outColour += ShadeVisibilityID(sampleIDs[i]) * (float(sampleCoverage[i]) / float(sampleCount));
+#else
+	// Unpack triangle ID and draw ID from visibility buffer
+#ifdef VISIBILITY_UINT
+	uint DrawIdTriId = subpassLoad(inputVisibility).r;
+#else
+	uint DrawIdTriId = packUnorm4x8(subpassLoad(inputVisibility));
+#endif
+	outColour = ShadeVisibilityID(DrawIdTriId);
+#endif
 }
\ No newline at end of file
@@ -12,7 +12,11 @@ layout(location = 0) in flat uint drawID;
 
 // Out 
 layout(location = 0) out vec4 outColour;
+#ifdef VISIBILITY_UINT
+layout(location = 1) out uint visBuff;
+#else
 layout(location = 1) out vec4 visBuff;
+#endif
 
 // Engel's packing function (without alpha bit)
 uint calculateOutputVBID(uint drawID, uint primitiveID)
@@ -27,5 +31,9 @@ void main()
 	outColour = vec4(0.0); 
 
 	// Fill visibility buffer
+#ifdef VISIBILITY_UINT
+	visBuff = calculateOutputVBID(drawID, gl_PrimitiveID + 1); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#else
 	visBuff = unpackUnorm4x8(calculateOutputVBID(drawID, gl_PrimitiveID + 1)); // Offset primitive ID so that the first primitive in each draw call is not lost due to being 0
+#endif
 }
\ No newline at end of file
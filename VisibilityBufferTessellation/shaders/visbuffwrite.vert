@@ -1,7 +1,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#ifndef NO_DRAW_PARAMETERS
 #extension GL_ARB_shader_draw_parameters : enable
+#endif
 
 // Constants
 const float heightTexScale = 8.0f;
@@ -14,11 +16,29 @@ layout(binding = 0) uniform UniformBufferObject
     mat4 proj;
 } ubo;
 layout(binding = 1) uniform sampler2D heightmap;
+layout(push_constant) uniform WritePushConstants
+{
+	uint drawOffset; // First draw of this call when the draws are split across several indirect calls
+} constants;
+#ifdef POST_TRANSFORM
+// Transformed once per frame by the vertex transform pass, indexed by the vertex index so no vertex input is needed
+struct TransformedVertex
+{
+	vec4 clipPosition;
+	vec4 positionTexU;
+	vec4 normalTexV;
+};
+layout (std430, binding = 2) readonly buffer TransformedVertBuff
+{
+	TransformedVertex transformedVertices[];
+};
+#else
 
 // In
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoords;
+#endif
 
 // Out
 layout(location = 0) flat out uint drawID;
@@ -29,6 +49,9 @@ out gl_PerVertex
 
 void main() 
 {
+#ifdef POST_TRANSFORM
+	gl_Position = transformedVertices[gl_VertexIndex].clipPosition;
+#else
 	// Displace height 
 	vec3 pos = inPosition;
 	pos.y += texture(heightmap, inTexCoords / heightTexScale).r * heightScale;
@@ -36,7 +59,12 @@ void main()
 	// Screen Position
 	vec4 vertScreenPos = ubo.mvp * vec4(pos, 1.0);
     gl_Position = vertScreenPos;
+#endif
 
 	// DrawID
-	drawID = gl_DrawIDARB;
+#ifdef NO_DRAW_PARAMETERS
+	drawID = constants.drawOffset;
+#else
+	drawID = gl_DrawIDARB + constants.drawOffset;
+#endif
 }
\ No newline at end of file